@@ -0,0 +1,912 @@
+#include "../Game.hpp"
+#include "../Engine/EventLog.hpp"
+#include "../Engine/Replay.hpp"
+#include "../Engine/Archive.hpp"
+#include "../Engine/Deal.hpp"
+#include "../Engine/Snapshot.hpp"
+#include "../Engine/History.hpp"
+#include "../Engine/CowState.hpp"
+#include "../Engine/Reaction.hpp"
+#include "../Engine/TurnFlow.hpp"
+#include "../Engine/Simulator.hpp"
+#include "../Engine/Rating.hpp"
+#include "../Engine/Mcts.hpp"
+#include "../Engine/Cfr.hpp"
+#include "../Engine/Tournament.hpp"
+#include "../Server/Protocol.hpp"
+#include "../Server/Match.hpp"
+#include "../Server/Matchmaker.hpp"
+#include "../Server/Checkpoint.hpp"
+#include "../Server/Server.hpp"
+#include "../Server/Shard.hpp"
+#include "../Server/Wal.hpp"
+#include "../Server/TimerWheel.hpp"
+#include "../Tools/Histogram.hpp"
+#include "../Players/PlayerFactory.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+double elapsed_ns(Clock::time_point start){
+    return std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+}
+
+void report(const std::string& name, double total_ns, std::size_t ops){
+    double per_op = total_ns / static_cast<double>(ops);
+    std::cout << std::left << std::setw(44) << name
+              << std::right << std::setw(10) << std::fixed << std::setprecision(1) << per_op << " ns/op"
+              << std::setw(14) << std::setprecision(0) << (1e9 / per_op) << " ops/s" << std::endl;
+}
+
+const std::vector<std::string> TABLE = {"Governor", "Spy", "Baron", "General", "Judge", "Merchant"};
+
+/**
+ * @brief Deletes the current players and seats a fresh table with 2 coins each.
+ */
+void seat_table(Game& game, const std::vector<std::string>& roles){
+    game.clear_players();
+    for(std::size_t i = 0; i < roles.size(); ++i){
+        Player* p = PlayerFactory::createPlayer(roles[i], game, "Player " + std::to_string(i + 1));
+        p->set_coins(2);
+        game.get_players().push_back(p);
+    }
+}
+
+/**
+ * @brief Plays one game with a fixed greedy policy and returns its moves.
+ * Coup the next opponent when possible, otherwise tax, gather or arrest.
+ */
+std::vector<Move> record_game(Game& game){
+    std::vector<Move> moves;
+    int n = static_cast<int>(game.get_players().size());
+    while(!game.has_winner()){
+        int seat = game.get_turn();
+        std::vector<Move> options;
+        for(int k = 1; k < n; ++k){
+            options.push_back({GameAction::COUP, seat, (seat + k) % n});
+        }
+        options.push_back({GameAction::TAX, seat});
+        options.push_back({GameAction::GATHER, seat});
+        for(int k = 1; k < n; ++k){
+            options.push_back({GameAction::ARREST, seat, (seat + k) % n});
+        }
+        bool moved = false;
+        for(const Move& m : options){
+            if(game.apply(m) == MoveStatus::OK){
+                moves.push_back(m);
+                moved = true;
+                break;
+            }
+        }
+        if(!moved){
+            break;
+        }
+    }
+    return moves;
+}
+
+// Same moves through the Player API: check_valid_move + is_current + exceptions per call
+void apply_through_players(Game& game, const std::vector<Move>& moves){
+    PlayerList& players = game.get_players();
+    for(const Move& m : moves){
+        Player* p = players[m.actor];
+        switch(m.action){
+            case GameAction::GATHER: p->gather(); break;
+            case GameAction::TAX: p->tax(); break;
+            case GameAction::ARREST:{
+                p->arrest(*players[m.target]);
+                for(Player* other : players){
+                    other->set_lastArrested(other == players[m.target]);
+                }
+                break;
+            }
+            case GameAction::COUP:{
+                std::streambuf* old = std::cout.rdbuf(nullptr); // silence "Game over!"
+                p->coup(*players[m.target]);
+                std::cout.rdbuf(old);
+                break;
+            }
+            default: break;
+        }
+    }
+}
+
+void bench_apply_batch(){
+    Game& game = Game::instance();
+    seat_table(game, TABLE);
+    std::vector<Move> moves = record_game(game);
+    const int rounds = 20000;
+
+    std::size_t applied = 0;
+    double batch_ns = 0;
+    for(int r = 0; r < rounds; ++r){
+        seat_table(game, TABLE);
+        Clock::time_point start = Clock::now();
+        BatchResult result = game.apply_batch(moves);
+        batch_ns += elapsed_ns(start);
+        applied += result.applied;
+        if(result.failed_index >= 0){
+            std::cerr << "batch stopped at " << result.failed_index << ": " << to_string(result.status) << std::endl;
+            return;
+        }
+    }
+    report("apply_batch (" + std::to_string(moves.size()) + " moves/game)", batch_ns, applied);
+
+    double single_ns = 0;
+    for(int r = 0; r < rounds; ++r){
+        seat_table(game, TABLE);
+        Clock::time_point start = Clock::now();
+        apply_through_players(game, moves);
+        single_ns += elapsed_ns(start);
+    }
+    report("Player API per move", single_ns, moves.size() * rounds);
+    game.clear_players();
+}
+
+void bench_event_log(){
+    Game& game = Game::instance();
+    seat_table(game, TABLE);
+    std::vector<Move> moves = record_game(game);
+    const int rounds = 20000;
+
+    EventLog log;
+    double write_ns = 0;
+    for(int r = 0; r < rounds; ++r){
+        seat_table(game, TABLE);
+        log.begin(game);
+        game.set_log(&log);
+        Clock::time_point start = Clock::now();
+        game.apply_batch(moves);
+        write_ns += elapsed_ns(start);
+        game.set_log(nullptr);
+    }
+    report("apply_batch with log attached", write_ns, moves.size() * rounds);
+    std::cout << "  log size: " << log.get_bytes().size() << " bytes for " << log.get_events() << " events" << std::endl;
+
+    // Replay: events only (table seating is measured separately)
+    EventReader header_reader(log);
+    LogHeader header = header_reader.read_header();
+    const std::uint8_t* events = header_reader.position();
+    std::size_t events_size = log.get_bytes().data() + log.get_bytes().size() - events;
+    double replay_ns = 0;
+    std::size_t replayed = 0;
+    for(int r = 0; r < rounds; ++r){
+        Replayer::seat(game, header);
+        EventReader reader(events, events_size);
+        Clock::time_point t = Clock::now();
+        replayed += Replayer::apply_events(game, reader);
+        replay_ns += elapsed_ns(t);
+    }
+    report("replay events", replay_ns, replayed);
+
+    double seat_ns = 0;
+    for(int r = 0; r < rounds; ++r){
+        Clock::time_point t = Clock::now();
+        Replayer::seat(game, header);
+        seat_ns += elapsed_ns(t);
+    }
+    report("replay table seating (per game)", seat_ns, rounds);
+    game.clear_players();
+}
+
+void bench_archive(){
+    Game& game = Game::instance();
+    seat_table(game, TABLE);
+    std::vector<Move> moves = record_game(game);
+    const std::size_t games = 100000;
+    const std::string path = "/tmp/coup_bench_archive.bin";
+
+    seat_table(game, TABLE);
+    EventLog log;
+    log.begin(game);
+    game.set_log(&log);
+    game.apply_batch(moves);
+    game.set_log(nullptr);
+    int winner = game.winner_seat();
+
+    Clock::time_point start = Clock::now();
+    {
+        ArchiveWriter writer(path);
+        for(std::size_t g = 0; g < games; ++g){
+            writer.add(g, log, winner);
+        }
+        writer.finish();
+    }
+    report("archive write (per game)", elapsed_ns(start), games);
+
+    start = Clock::now();
+    ArchiveReader archive(path);
+    report("archive open (mmap + trailer)", elapsed_ns(start), 1);
+
+    std::size_t found = 0;
+    start = Clock::now();
+    for(std::size_t g = 0; g < games; ++g){
+        found += archive.find((g * 7919) % games) != nullptr;
+    }
+    report("archive lookup by id", elapsed_ns(start), games);
+
+    const std::size_t seeks = 20000;
+    start = Clock::now();
+    for(std::size_t i = 0; i < seeks; ++i){
+        archive.replay(game, (i * 7919) % games, moves.size() / 2);
+    }
+    report("archive seek to mid-game turn", elapsed_ns(start), seeks);
+    std::cout << "  " << found << " games, " << moves.size() << " moves each" << std::endl;
+    game.clear_players();
+    std::remove(path.c_str());
+}
+/**
+ * @brief Logs a game that never ends: bribe whenever affordable, otherwise tax.
+ */
+void record_long_game(Game& game, EventLog& log, std::size_t moves){
+    seat_table(game, TABLE);
+    log.begin(game);
+    game.set_log(&log);
+    for(std::size_t i = 0; i < moves; ++i){
+        Move m{GameAction::BRIBE, game.get_turn()};
+        if(game.apply(m) != MoveStatus::OK){
+            m.action = GameAction::TAX;
+            game.apply(m);
+        }
+    }
+    game.set_log(nullptr);
+}
+
+void bench_snapshot_seek(){
+    Game& game = Game::instance();
+    const std::size_t seeks = 2000;
+    for(std::size_t length : {100, 1000, 10000}){
+        for(std::size_t interval : {std::size_t(0), EventLog::DEFAULT_SNAPSHOT_INTERVAL}){
+            EventLog log;
+            log.set_snapshot_interval(interval);
+            record_long_game(game, log, length);
+            Clock::time_point start = Clock::now();
+            for(std::size_t i = 0; i < seeks; ++i){
+                Replayer::replay(game, log, (i * 7919) % log.get_events());
+            }
+            std::string name = "seek in " + std::to_string(length) + "-move game, " +
+                               (interval ? "snapshot every " + std::to_string(interval) : "no snapshots");
+            report(name, elapsed_ns(start), seeks);
+        }
+    }
+    game.clear_players();
+}
+void bench_rng(){
+    const std::size_t draws = 10000000;
+    Rng rng(1);
+    std::uint64_t sink = 0;
+    Clock::time_point start = Clock::now();
+    for(std::size_t i = 0; i < draws; ++i){
+        sink += rng.below(6);
+    }
+    report("Rng::below(6)", elapsed_ns(start), draws);
+
+    const std::size_t splits = 100000;
+    start = Clock::now();
+    for(std::size_t i = 0; i < splits; ++i){
+        sink += rng.split()();
+    }
+    report("Rng::split (2^128 jump)", elapsed_ns(start), splits);
+
+    Game& game = Game::instance();
+    const std::size_t deals = 100000;
+    start = Clock::now();
+    for(std::size_t i = 0; i < deals; ++i){
+        deal_table(game, 6, rng);
+    }
+    report("deal_table (6 seats)", elapsed_ns(start), deals);
+    game.clear_players();
+    std::cout << "  checksum " << sink << std::endl;
+}
+void bench_snapshot(){
+    Game& game = Game::instance();
+    seat_table(game, TABLE);
+    const std::size_t rounds = 1000000;
+    std::vector<std::uint8_t> bytes(Snapshot::size(game));
+
+    Clock::time_point start = Clock::now();
+    for(std::size_t i = 0; i < rounds; ++i){
+        Snapshot::save(game, bytes.data(), bytes.size());
+    }
+    report("snapshot save (6 seats, " + std::to_string(bytes.size()) + " bytes)", elapsed_ns(start), rounds);
+
+    start = Clock::now();
+    for(std::size_t i = 0; i < rounds; ++i){
+        Snapshot::load(game, bytes.data(), bytes.size());
+    }
+    report("snapshot load in place", elapsed_ns(start), rounds);
+
+    const std::size_t reseats = 100000;
+    start = Clock::now();
+    for(std::size_t i = 0; i < reseats; ++i){
+        Player* last = game.get_players()[game.get_players().size() - 1];
+        game.get_players().pop_back();                  // force the reseating path
+        delete last;
+        Snapshot::load(game, bytes.data(), bytes.size());
+    }
+    report("snapshot load onto another table", elapsed_ns(start), reseats);
+    game.clear_players();
+}
+void bench_history(){
+    Game& game = Game::instance();
+    seat_table(game, TABLE);
+    const std::size_t turns = 100000;
+    History history;
+    history.begin(game);
+    Clock::time_point start = Clock::now();
+    for(std::size_t i = 0; i < turns; ++i){
+        if(game.apply({GameAction::BRIBE, game.get_turn()}) != MoveStatus::OK){
+            game.apply({GameAction::TAX, game.get_turn()});
+        }
+        history.record(game);
+    }
+    report("apply + history record", elapsed_ns(start), turns);
+    history.compact();                                  // release spare capacity before measuring
+    double per_1000 = history.memory_bytes() * 1000.0 / static_cast<double>(turns);
+    std::cout << "  delta history: " << std::fixed << std::setprecision(0) << per_1000
+              << " bytes per 1,000 turns (full snapshots: " << Snapshot::size(game) * 1000 << ")" << std::endl;
+
+    const std::size_t lookups = 200000;
+    start = Clock::now();
+    for(std::size_t i = 0; i < lookups; ++i){
+        history.restore(game, (i * 7919) % turns);
+    }
+    report("history restore of a random turn", elapsed_ns(start), lookups);
+    game.clear_players();
+}
+/**
+ * @brief Baseline search node without sharing: every clone copies the names, roles and seats.
+ */
+struct DeepState{
+    std::vector<std::string> names;
+    std::vector<Role> roles;
+    LogSnapshot state;
+
+    std::size_t heap_bytes() const{
+        return names.capacity() * sizeof(std::string) + roles.capacity() + state.seats.capacity() * sizeof(SeatState);
+    }
+};
+
+void bench_cow_state(){
+    Game& game = Game::instance();
+    seat_table(game, TABLE);
+    const std::size_t nodes = 200000;
+    const GameAction actions[] = {GameAction::GATHER, GameAction::TAX};
+
+    // Grow a search tree breadth-first: each node's children are gather and tax
+    std::vector<CowState> cow{CowState::capture(game)};
+    cow.reserve(nodes);
+    MoveStatus status;
+    std::size_t fresh_blocks = static_cast<std::size_t>(cow[0].size());
+    Clock::time_point start = Clock::now();
+    for(std::size_t parent = 0; cow.size() < nodes; ++parent){
+        for(GameAction a : actions){
+            CowState child = cow[parent].after(game, {a, cow[parent].turn()}, status);
+            for(int i = 0; i < child.size(); ++i){
+                fresh_blocks += !child.shares_seat(cow[parent], i);
+            }
+            cow.push_back(std::move(child));
+        }
+    }
+    report("CowState clone + apply", elapsed_ns(start), cow.size() - 1);
+
+    std::vector<DeepState> deep;
+    deep.reserve(nodes);
+    deep.push_back(DeepState{cow[0].table().names, cow[0].table().roles, {}});
+    History::capture(game, deep[0].state);
+    start = Clock::now();
+    for(std::size_t parent = 0; deep.size() < nodes; ++parent){
+        for(GameAction a : actions){
+            DeepState child = deep[parent];
+            Replayer::restore(game, child.state);
+            game.apply({a, child.state.turn});
+            History::capture(game, child.state);
+            deep.push_back(std::move(child));
+        }
+    }
+    report("deep copy + apply", elapsed_ns(start), deep.size() - 1);
+
+    // make_shared puts a 16-byte control block in front of each SeatState
+    double cow_bytes = sizeof(CowState) + fresh_blocks * (sizeof(SeatState) + 16.0) / cow.size();
+    double deep_bytes = sizeof(DeepState) + static_cast<double>(deep[1].heap_bytes());
+    std::cout << "  memory per node: CowState ~" << std::fixed << std::setprecision(0) << cow_bytes
+              << " bytes, deep copy ~" << deep_bytes << " bytes (6 seats)" << std::endl;
+    game.clear_players();
+}
+/**
+ * @brief Encodes each state of an endless bribe/tax game both ways: a full STATE per push,
+ * or a DELTA against the previous push.
+ */
+void bench_state_sync(){
+    Game& game = Game::instance();
+    seat_table(game, TABLE);
+    Reaction reaction;
+    const std::size_t pushes = 100000;
+    std::vector<StateMsg> states;
+    states.reserve(pushes);
+    for(std::uint32_t v = 1; states.size() < pushes; ++v){
+        states.push_back(make_state(1, v, game, reaction));
+        Move m{GameAction::BRIBE, game.get_turn()};
+        if(game.apply(m) != MoveStatus::OK){
+            m.action = GameAction::TAX;
+            game.apply(m);
+        }
+    }
+    std::vector<std::uint8_t> out;
+    out.reserve(pushes * 64);
+    Clock::time_point start = Clock::now();
+    for(const StateMsg& st : states){
+        put_state(out, st);
+    }
+    report("full STATE encode (6 seats)", elapsed_ns(start), pushes);
+    double full_bytes = static_cast<double>(out.size()) / pushes;
+
+    out.clear();
+    start = Clock::now();
+    for(std::size_t i = 1; i < pushes; ++i){
+        put_delta(out, states[i - 1], states[i]);
+    }
+    report("DELTA diff + encode", elapsed_ns(start), pushes - 1);
+    double delta_bytes = static_cast<double>(out.size()) / (pushes - 1);
+    std::cout << "  bytes per push: STATE " << std::fixed << std::setprecision(1) << full_bytes
+              << ", DELTA " << delta_bytes << std::endl;
+    game.clear_players();
+}
+std::uint64_t now_ns(){
+    return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now().time_since_epoch()).count());
+}
+/**
+ * @brief Producers post to one match inbox while its owner drains in batches of 64;
+ * total wall time per command, then enqueue-to-apply latency through the engine.
+ */
+void bench_command_queue(){
+    const std::size_t per_producer = 500000;
+    for(int producers : {1, 2, 4}){
+        MpscQueue<Command> queue(4096);
+        std::atomic<bool> go(false);
+        std::vector<std::thread> threads;
+        for(int p = 0; p < producers; ++p){
+            threads.emplace_back([&queue, &go, p](){
+                while(!go.load(std::memory_order_acquire)){}
+                Command cmd;
+                cmd.seat = p;
+                for(std::size_t i = 0; i < per_producer; ++i){
+                    while(!queue.try_push(cmd)){
+                        std::this_thread::yield();
+                    }
+                }
+            });
+        }
+        std::size_t total = per_producer * static_cast<std::size_t>(producers);
+        std::size_t seen = 0;
+        Clock::time_point start = Clock::now();
+        go.store(true, std::memory_order_release);
+        while(seen < total){
+            std::size_t n = queue.drain([](const Command&){}, 64);
+            if(n == 0){
+                std::this_thread::yield();
+            }
+            seen += n;
+        }
+        report("enqueue + drain, " + std::to_string(producers) + " producers", elapsed_ns(start), total);
+        for(std::thread& t : threads){
+            t.join();
+        }
+    }
+
+    Match match(1, 2);
+    match.join(1, "A");
+    match.join(2, "B");
+    Rng rng(42);
+    match.start(rng);
+    const int producers = 2;
+    const std::size_t commands = 200000;
+    std::atomic<bool> done(false);
+    std::vector<std::thread> threads;
+    for(int p = 0; p < producers; ++p){
+        threads.emplace_back([&match, &done, p](){
+            Command cmd;
+            cmd.seat = p;
+            cmd.action = GameAction::GATHER;
+            while(!done.load(std::memory_order_relaxed)){
+                cmd.tag = now_ns();
+                if(!match.post(cmd)){
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+    Histogram latency;
+    std::size_t applied = 0;
+    Clock::time_point start = Clock::now();
+    while(applied < commands){
+        std::size_t n = match.drain([&](const Command& c, std::uint8_t){ latency.record(now_ns() - c.tag); }, 64);
+        if(n == 0){
+            std::this_thread::yield();
+        }
+        applied += n;
+    }
+    report("post + apply through Match (2 producers)", elapsed_ns(start), applied);
+    done.store(true);
+    for(std::thread& t : threads){
+        t.join();
+    }
+    std::cout << "  enqueue->apply latency: p50 " << latency.percentile(0.5) << " ns, p99 " << latency.percentile(0.99)
+              << " ns, p999 " << latency.percentile(0.999) << " ns (" << std::thread::hardware_concurrency() << " cores)" << std::endl;
+}
+/**
+ * @brief 500k pending match deadlines spread over a minute of millisecond ticks:
+ * schedule all, cancel half (the usual fate of a deadline), then run the clock out.
+ */
+void bench_timer_wheel(){
+    const std::size_t timers = 500000;
+    TimerWheel wheel(0);
+    Rng rng(43);
+    std::vector<TimerWheel::TimerId> ids(timers);
+    Clock::time_point start = Clock::now();
+    for(std::size_t i = 0; i < timers; ++i){
+        ids[i] = wheel.schedule(1 + rng.below(60000), i);
+    }
+    report("timer schedule (500k pending)", elapsed_ns(start), timers);
+
+    start = Clock::now();
+    for(std::size_t i = 0; i < timers; i += 2){
+        wheel.cancel(ids[i]);
+    }
+    report("timer cancel", elapsed_ns(start), timers / 2);
+
+    std::vector<std::uint64_t> expired;
+    expired.reserve(timers);
+    start = Clock::now();
+    for(std::uint64_t t = 1; t <= 60000; ++t){
+        wheel.advance(t, expired);
+    }
+    report("timer expiry (1 ms ticks, per fired timer)", elapsed_ns(start), expired.size());
+}
+/**
+ * @brief Many suspended turn flows at once: the frame each parked game costs, and one
+ * resume (submit a gather, run to the next co_await) per turn across all of them.
+ */
+void bench_turn_flow(){
+    const std::size_t games = 10000;
+    const std::size_t rounds = 6;
+    std::vector<std::unique_ptr<Game>> tables;
+    std::vector<TurnFlow> flows;
+    tables.reserve(games);
+    flows.reserve(games);
+    Clock::time_point start = Clock::now();
+    for(std::size_t i = 0; i < games; ++i){
+        tables.push_back(std::make_unique<Game>());
+        seat_table(*tables.back(), {"Governor", "Spy"});
+        tables.back()->set_turn(0);
+        flows.push_back(TurnFlow::play(*tables.back()));
+    }
+    report("turn flow start (table + frame)", elapsed_ns(start), games);
+    std::cout << "turn flow frame: " << TurnFlow::frame_bytes() << " B per parked game, "
+              << (TurnFlow::frame_bytes() * games) / 1024 << " KiB for " << games << std::endl;
+
+    std::size_t rejected = 0;
+    start = Clock::now();
+    for(std::size_t r = 0; r < rounds; ++r){
+        for(TurnFlow& flow : flows){
+            if(flow.submit({GameAction::GATHER, flow.seat()}) != MoveStatus::OK){
+                rejected++;
+            }
+        }
+    }
+    report("turn flow resume (gather, per turn)", elapsed_ns(start), games * rounds);
+    if(rejected != 0){
+        std::cout << "  rejected moves: " << rejected << std::endl;
+    }
+}
+/**
+ * @brief Restart cost with 100k live 4-seat matches: one checkpoint (single fsync), then
+ * a restore into a fresh server with 1 thread and with one per core.
+ */
+void bench_checkpoint(){
+    const std::size_t count = 100000;
+    const std::string path = "/tmp/coup_bench_checkpoint.bin";
+    std::vector<std::unique_ptr<Match>> matches;
+    std::vector<Match*> live;
+    matches.reserve(count);
+    Rng rng(45);
+    for(std::size_t i = 0; i < count; ++i){
+        auto m = std::make_unique<Match>(static_cast<std::uint32_t>(i + 1), 4);
+        for(int seat = 0; seat < 4; ++seat){
+            m->join(seat, "Player " + std::to_string(seat + 1));
+        }
+        m->start(rng);
+        m->act(m->game().get_turn(), GameAction::TAX, -1);   // some stop inside a block window
+        live.push_back(m.get());
+        matches.push_back(std::move(m));
+    }
+    Clock::time_point start = Clock::now();
+    std::size_t bytes = Checkpoint::write(path, live);
+    double write_ns = elapsed_ns(start);
+    report("checkpoint write + fsync (per match)", write_ns, count);
+    std::cout << "checkpoint: " << bytes / count << " B per match, " << bytes / (1024 * 1024) << " MiB, "
+              << std::setprecision(1) << write_ns / 1e6 << " ms for " << count << std::endl;
+
+    unsigned cores = std::max(1u, std::thread::hardware_concurrency());
+    for(unsigned threads : {1u, cores}){
+        Server server(0, 45);
+        start = Clock::now();
+        std::size_t restored = server.restore(path, threads);
+        double ns = elapsed_ns(start);
+        report("restore into server, " + std::to_string(threads) + " thread(s) (per match)", ns, restored);
+        std::cout << "restart: " << std::setprecision(1) << ns / 1e6 << " ms for " << restored << " matches" << std::endl;
+        if(threads == cores){
+            break;
+        }
+    }
+    std::remove(path.c_str());
+}
+/**
+ * @brief Durable actions per second against the group-commit interval: 1000 matches
+ * append 3-byte action records as fast as they can for half a second per setting, and
+ * an action counts once the commit covering it has returned. Interval 0 syncs every action.
+ */
+void bench_wal(){
+    const std::string path = "/tmp/coup_bench_wal.bin";
+    const std::uint8_t event[3] = {0x21, 0, 0};
+    std::cout << std::left << std::setw(16) << "commit every" << std::right << std::setw(16) << "durable acts/s"
+              << std::setw(12) << "syncs/s" << std::setw(14) << "acts/sync" << std::endl;
+    for(double interval_ms : {0.0, 0.1, 1.0, 5.0, 20.0}){
+        std::remove(path.c_str());
+        Wal wal(path, std::size_t(16) << 20);
+        std::uint32_t version = 0;
+        Clock::time_point start = Clock::now();
+        Clock::time_point last = start;
+        double seconds = 0;
+        while(seconds < 0.5){
+            wal.append(WalKind::EVENTS, 1 + version % 1000, version, event, sizeof(event));
+            version++;
+            Clock::time_point now = Clock::now();
+            if(interval_ms == 0 || std::chrono::duration<double, std::milli>(now - last).count() >= interval_ms){
+                wal.commit();
+                last = now;
+            }
+            seconds = std::chrono::duration<double>(now - start).count();
+        }
+        double durable = static_cast<double>(wal.durable()) / seconds;
+        double syncs = static_cast<double>(wal.commits()) / seconds;
+        std::cout << std::left << std::setw(16) << (interval_ms == 0 ? std::string("action") : std::to_string(interval_ms).substr(0, 4) + " ms")
+                  << std::right << std::setw(16) << std::setprecision(0) << durable
+                  << std::setw(12) << syncs << std::setw(14) << (syncs > 0 ? durable / syncs : 0) << std::endl;
+    }
+    std::remove(path.c_str());
+}
+/**
+ * @brief Shard directory operations, and what moving a connection to another shard costs:
+ * one descriptor and the client's pending bytes over a Unix datagram channel, whatever the
+ * size of the match it is moving to.
+ */
+void bench_shards(){
+    const std::size_t count = 1000000;
+    ShardDirectory directory(8);
+    std::vector<std::uint32_t> ids(count / 4);
+    Clock::time_point start = Clock::now();
+    for(std::size_t i = 0; i < ids.size(); ++i){
+        ids[i] = directory.allocate(static_cast<unsigned>(i % 8));
+    }
+    report("directory allocate", elapsed_ns(start), ids.size());
+    Rng rng(47);
+    std::uint64_t found = 0;
+    start = Clock::now();
+    for(std::size_t i = 0; i < count; ++i){
+        found += directory.lookup(ids[rng.below(ids.size())]) >= 0 ? 1 : 0;
+    }
+    report("directory lookup", elapsed_ns(start), count);
+    start = Clock::now();
+    for(std::uint32_t id : ids){
+        directory.release(id);
+    }
+    report("directory release", elapsed_ns(start), ids.size());
+
+    int channel[2];
+    Handoff::channel(channel);
+    int pipe_fds[2];
+    if(::pipe(pipe_fds) != 0){
+        return;
+    }
+    std::vector<std::uint8_t> frame(16, 7), got;
+    std::vector<int> fds(1, pipe_fds[0]), received;
+    const std::size_t moves = 100000;
+    std::size_t moved = 0;
+    start = Clock::now();
+    for(std::size_t i = 0; i < moves; ++i){
+        if(Handoff::send(channel[0], fds, frame) && Handoff::receive(channel[1], received, got) && received.size() == 1){
+            ::close(received[0]);
+            moved++;
+        }
+    }
+    report("hand off a connection (send + receive + close)", elapsed_ns(start), moves);
+    std::cout << "shards: " << found << " lookups hit, " << moved << " handoffs, directory "
+              << directory.capacity() * 8 / (1024 * 1024) << " MiB of slots" << std::endl;
+    ::close(pipe_fds[0]);
+    ::close(pipe_fds[1]);
+    ::close(channel[0]);
+    ::close(channel[1]);
+}
+/**
+ * @brief Matchmaker throughput and time to match: tickets arrive at a steady rate over two
+ * simulated seconds with ratings spread around 1500 (sd ~300) and table sizes 2-6 alike,
+ * and tables are formed every 10 ms. Joins/s is CPU time for enqueue + tick; wait times
+ * are simulated milliseconds from enqueue to being seated.
+ */
+void bench_matchmaker(){
+    std::cout << std::left << std::setw(14) << "arrivals/s" << std::right << std::setw(16) << "joins/s (cpu)"
+              << std::setw(10) << "tables" << std::setw(12) << "wait p50" << std::setw(10) << "p99"
+              << std::setw(12) << "unmatched" << std::endl;
+    for(std::uint64_t per_ms : {10u, 100u, 1000u}){
+        Matchmaker mm;
+        Rng rng(48);
+        Histogram wait;
+        const std::uint64_t ms = 2000, tick_ms = 10;
+        std::uint64_t joins = 0;
+        double ns = 0;
+        for(std::uint64_t now = 0; now < ms; now += tick_ms){
+            std::vector<Ticket> arrivals(per_ms * tick_ms);
+            for(Ticket& t : arrivals){
+                int sum = 0;
+                for(int i = 0; i < 4; ++i){
+                    sum += static_cast<int>(rng.below(601));
+                }
+                t.tag = joins++;
+                t.rating = 1500 + sum - 1200;
+                t.seats = 2 + static_cast<int>(rng.below(5));
+                t.since = now + rng.below(tick_ms);
+            }
+            Clock::time_point start = Clock::now();
+            for(const Ticket& t : arrivals){
+                mm.enqueue(t);
+            }
+            mm.tick(now + tick_ms, [&](const std::vector<Ticket>& group){
+                for(const Ticket& t : group){
+                    wait.record(now + tick_ms - t.since);
+                }
+            });
+            ns += elapsed_ns(start);
+        }
+        std::cout << std::left << std::setw(14) << per_ms * 1000 << std::right << std::setw(16) << std::setprecision(0)
+                  << static_cast<double>(joins) / (ns / 1e9) << std::setw(10) << mm.formed()
+                  << std::setw(9) << wait.percentile(0.5) << " ms" << std::setw(7) << wait.percentile(0.99) << " ms"
+                  << std::setw(12) << mm.waiting() << std::endl;
+    }
+}
+
+/**
+ * @brief Simulated random vs greedy games at 4 seats: how fast they are played and rated,
+ * and how the ratings settle as games accumulate (batches of 4096, rated on one thread).
+ * Rating threads split each batch; on a machine with fewer cores they only add overhead.
+ */
+void bench_ratings(){
+    const std::size_t games = 100000;
+    std::vector<GameResult> results;
+    Simulator simulator({"random", "greedy"}, 49);
+    Clock::time_point start = Clock::now();
+    simulator.run(games, 4, 1, results);
+    report("simulate game (random/greedy, 4 seats)", elapsed_ns(start), games);
+
+    for(unsigned threads : {1u, 2u, 4u}){
+        RatingEngine engine(2, RatingEngine::DEFAULT_BATCH, threads);
+        start = Clock::now();
+        for(const GameResult& r : results){
+            engine.add(r);
+        }
+        engine.flush();
+        report("rate game (" + std::to_string(threads) + " threads)", elapsed_ns(start), engine.rated());
+    }
+
+    RatingEngine engine(2);
+    std::cout << std::setw(10) << "games" << std::setw(12) << "random" << std::setw(10) << "greedy"
+              << std::setw(13) << "max change" << std::setw(12) << "max sigma" << std::endl;
+    std::size_t next = 1000;
+    std::vector<double> last{RatingEngine::INITIAL_MU, RatingEngine::INITIAL_MU};
+    for(std::size_t i = 0; i < results.size(); ++i){
+        engine.add(results[i]);
+        if(i + 1 == next || i + 1 == results.size()){
+            engine.flush();
+            const RatingTable& t = engine.strategies();
+            double change = std::max(std::abs(t.mu(0) - last[0]), std::abs(t.mu(1) - last[1]));
+            last = {t.mu(0), t.mu(1)};
+            std::cout << std::setw(10) << engine.rated() << std::setprecision(1) << std::setw(12) << t.mu(0)
+                      << std::setw(10) << t.mu(1) << std::setw(13) << change << std::setw(12)
+                      << engine.convergence().back().max_sigma << std::endl;
+            next *= 4;
+        }
+    }
+}
+
+/**
+ * @brief Round-robin throughput for cheap bots (random, greedy, cfr) at 2 and 4 seats, and
+ * what the expensive ones cost: one MCTS move at 100 iterations, and CFR training.
+ */
+void bench_tournament(){
+    default_cfr_table();                    // trained once, outside the timings
+    for(int players : {2, 4}){
+        Tournament tournament({"random", "greedy", "cfr"}, players, players == 2 ? 50 : 1, 50);
+        Clock::time_point start = Clock::now();
+        TournamentResult result = tournament.run(1);
+        report("tournament game (" + std::to_string(players) + " seats, 1 thread)", elapsed_ns(start), result.games);
+    }
+    {
+        Tournament tournament({"random", "greedy", "cfr"}, 2, 50, 50);
+        unsigned threads = std::max(1u, std::thread::hardware_concurrency());
+        Clock::time_point start = Clock::now();
+        TournamentResult result = tournament.run(threads);
+        report("tournament game (2 seats, " + std::to_string(threads) + " threads)", elapsed_ns(start), result.games);
+    }
+
+    Game game;
+    Rng rng(50);
+    MctsStrategy mcts;
+    const int moves = 200;
+    double ns = 0;
+    for(int i = 0; i < moves; ++i){
+        deal_table(game, 4, rng);
+        Clock::time_point start = Clock::now();
+        mcts.choose(game, 0, rng);
+        ns += elapsed_ns(start);
+    }
+    report("mcts move (100 iterations, 4 seats)", ns, moves);
+
+    CfrTable table;
+    Clock::time_point start = Clock::now();
+    table.train(1000, rng);
+    report("cfr training game", elapsed_ns(start), 1000);
+}
+}
+
+int main(){
+    std::cout << "== action submission ==" << std::endl;
+    bench_apply_batch();
+    std::cout << "== event log ==" << std::endl;
+    bench_event_log();
+    std::cout << "== replay archive ==" << std::endl;
+    bench_archive();
+    std::cout << "== snapshot seek ==" << std::endl;
+    bench_snapshot_seek();
+    std::cout << "== random streams ==" << std::endl;
+    bench_rng();
+    std::cout << "== binary snapshots ==" << std::endl;
+    bench_snapshot();
+    std::cout << "== delta history ==" << std::endl;
+    bench_history();
+    std::cout << "== copy-on-write states ==" << std::endl;
+    bench_cow_state();
+    std::cout << "== state sync ==" << std::endl;
+    bench_state_sync();
+    std::cout << "== command queue ==" << std::endl;
+    bench_command_queue();
+    std::cout << "== timer wheel ==" << std::endl;
+    bench_timer_wheel();
+    std::cout << "== turn flow ==" << std::endl;
+    bench_turn_flow();
+    std::cout << "== checkpoint and restore ==" << std::endl;
+    bench_checkpoint();
+    std::cout << "== write-ahead log ==" << std::endl;
+    bench_wal();
+    std::cout << "== shards ==" << std::endl;
+    bench_shards();
+    std::cout << "== matchmaker ==" << std::endl;
+    bench_matchmaker();
+    std::cout << "== ratings ==" << std::endl;
+    bench_ratings();
+    std::cout << "== tournament ==" << std::endl;
+    bench_tournament();
+    return 0;
+}
@@ -0,0 +1,187 @@
+#include "Archive.hpp"
+#include "Replay.hpp"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+const char TRAILER_MAGIC[8] = {'C', 'O', 'U', 'P', 'A', 'R', 'C', '1'};
+constexpr std::size_t TRAILER_SIZE = 8 + 8 + sizeof(TRAILER_MAGIC);
+}
+
+ArchiveWriter::ArchiveWriter(const std::string& path)
+    : _out(path, std::ios::binary | std::ios::trunc), _offset(0), _finished(false)
+{
+    if(!_out){
+        throw std::runtime_error("Cannot create archive: " + path);
+    }
+}
+ArchiveWriter::~ArchiveWriter(){
+    try {
+        finish();
+    } catch (const std::exception&) {
+        // Destructors must not throw; call finish() to see write errors
+    }
+}
+/**
+ * @brief Appends one game's log and indexes it.
+ * @param game_id Caller-chosen id, unique within the archive.
+ * @param log Complete log of the game (header included).
+ * @param winner Winning seat, -1 if unfinished.
+ */
+void ArchiveWriter::add(std::uint64_t game_id, const EventLog& log, int winner){
+    if(_finished){
+        throw std::runtime_error("Archive already finished");
+    }
+    const std::vector<std::uint8_t>& bytes = log.get_bytes();
+    EventReader reader(log);
+    LogHeader header = reader.read_header();
+
+    ArchiveEntry e{};
+    e.game_id = game_id;
+    e.offset = _offset;
+    e.length = static_cast<std::uint32_t>(bytes.size());
+    e.players = static_cast<std::uint8_t>(header.roles.size());
+    e.winner = static_cast<std::int8_t>(winner);
+    for(std::size_t i = 0; i < header.roles.size() && i < 16; ++i){
+        e.roles |= static_cast<std::uint64_t>(header.roles[i]) << (4 * i);
+    }
+    _out.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+    _offset += bytes.size();
+    _index.push_back(e);
+}
+/**
+ * @brief Writes the sorted index and trailer; further add() calls throw.
+ * @throws std::runtime_error on a duplicate game id or write error.
+ */
+void ArchiveWriter::finish(){
+    if(_finished){
+        return;
+    }
+    _finished = true;
+    std::sort(_index.begin(), _index.end(), [](const ArchiveEntry& a, const ArchiveEntry& b){
+        return a.game_id < b.game_id;
+    });
+    for(std::size_t i = 1; i < _index.size(); ++i){
+        if(_index[i].game_id == _index[i - 1].game_id){
+            throw std::runtime_error("Duplicate game id in archive");
+        }
+    }
+    std::uint64_t count = _index.size();
+    std::uint64_t index_offset = (_offset + alignof(ArchiveEntry) - 1) / alignof(ArchiveEntry) * alignof(ArchiveEntry);
+    const char padding[alignof(ArchiveEntry)] = {};
+    _out.write(padding, static_cast<std::streamsize>(index_offset - _offset));
+    _out.write(reinterpret_cast<const char*>(_index.data()), static_cast<std::streamsize>(count * sizeof(ArchiveEntry)));
+    _out.write(reinterpret_cast<const char*>(&count), sizeof(count));
+    _out.write(reinterpret_cast<const char*>(&index_offset), sizeof(index_offset));
+    _out.write(TRAILER_MAGIC, sizeof(TRAILER_MAGIC));
+    _out.flush();
+    if(!_out){
+        throw std::runtime_error("Cannot write archive index");
+    }
+}
+
+/**
+ * @brief Maps an archive read-only and shared, and locates its index.
+ * @throws std::runtime_error if the file cannot be mapped or has no valid trailer: the
+ * index must be aligned and end exactly where the trailer starts.
+ */
+ArchiveReader::ArchiveReader(const std::string& path)
+    : _data(nullptr), _size(0), _index(nullptr), _count(0)
+{
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if(fd < 0){
+        throw std::runtime_error("Cannot open archive: " + path);
+    }
+    struct stat st;
+    if(::fstat(fd, &st) != 0 || static_cast<std::size_t>(st.st_size) < TRAILER_SIZE){
+        ::close(fd);
+        throw std::runtime_error("Not an archive: " + path);
+    }
+    _size = static_cast<std::size_t>(st.st_size);
+    void* map = ::mmap(nullptr, _size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if(map == MAP_FAILED){
+        throw std::runtime_error("Cannot map archive: " + path);
+    }
+    _data = static_cast<const std::uint8_t*>(map);
+
+    const std::uint8_t* trailer = _data + _size - TRAILER_SIZE;
+    std::uint64_t count, index_offset;
+    std::memcpy(&count, trailer, 8);
+    std::memcpy(&index_offset, trailer + 8, 8);
+    std::size_t body = _size - TRAILER_SIZE;
+    if(std::memcmp(trailer + 16, TRAILER_MAGIC, sizeof(TRAILER_MAGIC)) != 0 ||
+       count > body / sizeof(ArchiveEntry) || index_offset != body - count * sizeof(ArchiveEntry) ||
+       index_offset % alignof(ArchiveEntry) != 0){
+        ::munmap(const_cast<std::uint8_t*>(_data), _size);
+        throw std::runtime_error("Corrupt archive trailer: " + path);
+    }
+    _index = reinterpret_cast<const ArchiveEntry*>(_data + index_offset);
+    _count = static_cast<std::size_t>(count);
+}
+ArchiveReader::~ArchiveReader(){
+    ::munmap(const_cast<std::uint8_t*>(_data), _size);
+}
+std::size_t ArchiveReader::games() const{
+    return _count;
+}
+const ArchiveEntry& ArchiveReader::entry(std::size_t i) const{
+    if(i >= _count){
+        throw std::runtime_error("Archive entry out of range");
+    }
+    return _index[i];
+}
+/**
+ * @brief Binary search of the index.
+ * @return Entry of the game, or nullptr if it is not archived.
+ */
+const ArchiveEntry* ArchiveReader::find(std::uint64_t game_id) const{
+    const ArchiveEntry* end = _index + _count;
+    const ArchiveEntry* it = std::lower_bound(_index, end, game_id, [](const ArchiveEntry& e, std::uint64_t id){
+        return e.game_id < id;
+    });
+    return (it != end && it->game_id == game_id) ? it : nullptr;
+}
+std::span<const std::uint8_t> ArchiveReader::game_bytes(const ArchiveEntry& e) const{
+    if(e.offset > _size || e.length > _size - e.offset){
+        throw std::runtime_error("Archive entry points past the end of the file");
+    }
+    return std::span<const std::uint8_t>(_data + e.offset, e.length);
+}
+/**
+ * @brief Counts the events of a log that precede its turn-th move (0-based), i.e. the
+ * state just before that move is played. Only this game's bytes are scanned.
+ */
+std::size_t ArchiveReader::events_before_turn(std::span<const std::uint8_t> log, std::size_t turn){
+    EventReader reader(log.data(), log.size());
+    reader.read_header();
+    std::size_t events = 0;
+    std::size_t moves = 0;
+    Event e;
+    while(reader.next(e)){
+        if(e.kind == EventKind::MOVE && moves++ == turn){
+            break;
+        }
+        events++;
+    }
+    return events;
+}
+/**
+ * @brief Rebuilds a game as it stood before its turn-th move (whole game by default).
+ * @return Number of events applied.
+ * @throws std::runtime_error if the game is not in the archive.
+ */
+std::size_t ArchiveReader::replay(Game& game, std::uint64_t game_id, std::size_t turn) const{
+    const ArchiveEntry* e = find(game_id);
+    if(!e){
+        throw std::runtime_error("Game " + std::to_string(game_id) + " is not archived");
+    }
+    std::span<const std::uint8_t> bytes = game_bytes(*e);
+    std::size_t events = turn == SIZE_MAX ? Replayer::ALL : events_before_turn(bytes, turn);
+    return Replayer::replay(game, bytes.data(), bytes.size(), events);
+}
@@ -0,0 +1,79 @@
+#ifndef ARCHIVE_HPP
+#define ARCHIVE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <span>
+#include <string>
+#include <vector>
+#include "EventLog.hpp"
+#include "../Game.hpp"
+
+/**
+ * @brief Footer index entry, one per archived game (32 bytes, little-endian on disk).
+ * Roles of the first 16 seats are packed 4 bits per seat; larger tables keep them
+ * only in the game's own log header.
+ */
+struct ArchiveEntry{
+    std::uint64_t game_id;
+    std::uint64_t offset;
+    std::uint32_t length;
+    std::uint8_t players;
+    std::int8_t winner;      // seat, -1 if the game was not finished
+    std::uint16_t reserved;
+    std::uint64_t roles;
+
+    Role role(int seat) const { return static_cast<Role>((roles >> (4 * seat)) & 0xf); }
+};
+static_assert(sizeof(ArchiveEntry) == 32, "ArchiveEntry is an on-disk layout");
+
+/**
+ * @brief Packs many event logs into one file:
+ * [log 0][log 1]...[zero padding][index: ArchiveEntry x count, sorted by game id][count u64][index offset u64]["COUPARC1"].
+ * The padding puts the index on an alignof(ArchiveEntry) boundary so readers can use it in place.
+ */
+class ArchiveWriter{
+    private:
+        std::ofstream _out;
+        std::vector<ArchiveEntry> _index;
+        std::uint64_t _offset;
+        bool _finished;
+
+    public:
+        explicit ArchiveWriter(const std::string& path);
+        ~ArchiveWriter();
+        ArchiveWriter(const ArchiveWriter&) = delete;
+        ArchiveWriter& operator=(const ArchiveWriter&) = delete;
+
+        void add(std::uint64_t game_id, const EventLog& log, int winner);
+        void finish();
+};
+
+/**
+ * @brief Read-only view of an archive through a shared memory mapping.
+ * Nothing is parsed up front but the footer; games are found by binary search on the
+ * index and read in place, and concurrent readers share the page cache.
+ */
+class ArchiveReader{
+    private:
+        const std::uint8_t* _data;
+        std::size_t _size;
+        const ArchiveEntry* _index;
+        std::size_t _count;
+
+    public:
+        explicit ArchiveReader(const std::string& path);
+        ~ArchiveReader();
+        ArchiveReader(const ArchiveReader&) = delete;
+        ArchiveReader& operator=(const ArchiveReader&) = delete;
+
+        std::size_t games() const;
+        const ArchiveEntry& entry(std::size_t i) const;
+        const ArchiveEntry* find(std::uint64_t game_id) const;
+        std::span<const std::uint8_t> game_bytes(const ArchiveEntry& e) const;
+        std::size_t replay(Game& game, std::uint64_t game_id, std::size_t turn = SIZE_MAX) const;
+
+        static std::size_t events_before_turn(std::span<const std::uint8_t> log, std::size_t turn);
+};
+#endif
@@ -0,0 +1,293 @@
+#include "Cfr.hpp"
+#include "Deal.hpp"
+#include "Simulator.hpp"
+#include "Snapshot.hpp"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+namespace {
+const char MAGIC[8] = {'C', 'O', 'U', 'P', 'C', 'F', 'R', '1'};
+constexpr GameAction ACTION_OF[CfrTable::ACTIONS] = {
+    GameAction::GATHER, GameAction::TAX, GameAction::BRIBE, GameAction::ARREST, GameAction::SANCTION, GameAction::COUP};
+
+int coin_bucket(int coins){
+    return coins < 3 ? 0 : coins == 3 ? 1 : coins < 7 ? 2 : coins < 10 ? 3 : 4;
+}
+int sample(const double* policy, Rng& rng){
+    double r = static_cast<double>(rng() >> 11) * 0x1.0p-53;
+    int last = 0;
+    for(int a = 0; a < CfrTable::ACTIONS; ++a){
+        if(policy[a] > 0){
+            last = a;
+            r -= policy[a];
+            if(r < 0){
+                return a;
+            }
+        }
+    }
+    return last;
+}
+}
+
+CfrTable::CfrTable()
+    : _regret(INFOSETS * ACTIONS, 0), _sum(INFOSETS * ACTIONS, 0), _trained(0)
+{
+}
+
+/**
+ * @brief Index of what seat sees, 0..INFOSETS-1.
+ */
+int CfrTable::infoset(Game& game, int seat){
+    PlayerList& players = game.get_players();
+    int richest = 0;
+    for(SeatMask others = players.active_mask() & ~seat_bit(seat); others; others &= others - 1){
+        richest = std::max(richest, players.coins(mask_first(others)));
+    }
+    int left = mask_count(players.active_mask());
+    int key = coin_bucket(players.coins(seat));
+    key = key * 2 + ((players.sanction_mask() & seat_bit(seat)) ? 1 : 0);
+    key = key * 2 + ((players.can_arrest_mask() & seat_bit(seat)) ? 1 : 0);
+    key = key * 3 + (richest < 3 ? 0 : richest < 7 ? 1 : 2);
+    key = key * 3 + (left <= 2 ? 0 : left == 3 ? 1 : 2);
+    return key;
+}
+/**
+ * @brief Mask with bit a set when action a has a legal concrete move.
+ */
+unsigned CfrTable::legal(Game& game, int seat){
+    unsigned mask = 0;
+    Move m{GameAction::NONE, seat};
+    for(int a = 0; a < ACTIONS; ++a){
+        mask |= concrete(game, seat, a, m) ? 1u << a : 0u;
+    }
+    return mask;
+}
+/**
+ * @brief The move action stands for: untargeted actions as they are, targeted ones
+ * against the richest active opponent they are legal against (nearest seat on a tie).
+ * @return false if there is none.
+ */
+bool CfrTable::concrete(Game& game, int seat, int action, Move& out){
+    GameAction act = ACTION_OF[action];
+    if(action < 3){
+        out = Move{act, seat};
+        return game.validate(out) == MoveStatus::OK;
+    }
+    PlayerList& players = game.get_players();
+    int n = static_cast<int>(players.size());
+    int best = -1;
+    for(int k = 1; k < n; ++k){
+        int t = (seat + k) % n;
+        if((best < 0 || players.coins(t) > players.coins(best)) && game.validate({act, seat, t}) == MoveStatus::OK){
+            best = t;
+        }
+    }
+    out = Move{act, seat, best};
+    return best >= 0;
+}
+
+/**
+ * @brief Regret matching: legal actions in proportion to their positive regret, or
+ * uniformly if none has any.
+ */
+void CfrTable::current(int infoset, unsigned legal, double* policy) const{
+    const double* regret = &_regret[infoset * ACTIONS];
+    double total = 0;
+    int count = 0;
+    for(int a = 0; a < ACTIONS; ++a){
+        bool ok = legal & (1u << a);
+        total += ok ? regret[a] : 0;
+        count += ok ? 1 : 0;
+    }
+    for(int a = 0; a < ACTIONS; ++a){
+        bool ok = legal & (1u << a);
+        policy[a] = !ok ? 0 : total > 0 ? regret[a] / total : 1.0 / count;
+    }
+}
+/**
+ * @brief Average policy over training, restricted to the legal actions; uniform over
+ * them for an information set training never reached.
+ */
+void CfrTable::average(int infoset, unsigned legal, double* policy) const{
+    const double* sum = &_sum[infoset * ACTIONS];
+    double total = 0;
+    int count = 0;
+    for(int a = 0; a < ACTIONS; ++a){
+        bool ok = legal & (1u << a);
+        total += ok ? sum[a] : 0;
+        count += ok ? 1 : 0;
+    }
+    for(int a = 0; a < ACTIONS; ++a){
+        bool ok = legal & (1u << a);
+        policy[a] = !ok ? 0 : total > 0 ? sum[a] / total : 1.0 / count;
+    }
+}
+/**
+ * @brief Plays game out with every seat on its current policy, every eligible blocker
+ * blocking as a default Strategy does.
+ * @return 1 if traverser wins, else 0.
+ */
+int CfrTable::playout(Game& game, int traverser, Rng& rng) const{
+    double policy[ACTIONS];
+    BlockAllPolicy blocks;
+    Move m{GameAction::NONE, 0};
+    for(int turn = 0; turn < MAX_SIMULATED_TURNS && !game.has_winner(); ++turn){
+        if(game.pass_stuck_turns() > 0){
+            continue;
+        }
+        int seat = game.get_turn();
+        unsigned mask = legal(game, seat);
+        if(mask == 0){
+            break;
+        }
+        current(infoset(game, seat), mask, policy);
+        concrete(game, seat, sample(policy, rng), m);
+        play_move(game, m, blocks);
+    }
+    return game.winner_seat() == traverser ? 1 : 0;
+}
+
+/**
+ * @brief Trains on games self-play games, each at a table of 2..CAPACITY seats with
+ * dealt roles, so one table serves every table size. Every decision adds to the average
+ * policy; one of the traverser's decisions, drawn uniformly (reservoir sampling on a
+ * snapshot), has its actions valued and its regrets updated once the game is over.
+ */
+void CfrTable::train(std::size_t games, Rng& rng){
+    Game game;
+    Game scratch;
+    std::uint8_t snapshot[sizeof(SnapshotHeader) + sizeof(SeatRecord) * PlayerList::CAPACITY];
+    std::size_t bytes = 0;
+    double policy[ACTIONS];
+    double value[ACTIONS];
+    BlockAllPolicy blocks;
+    Move m{GameAction::NONE, 0};
+    for(std::size_t g = 0; g < games; ++g){
+        int players = 2 + static_cast<int>(rng.below(PlayerList::CAPACITY - 1));
+        std::vector<Role> roles = deal_roles(rng, players);
+        seat_roles(game, roles);
+        int traverser = static_cast<int>(rng.below(players));
+        std::uint64_t decisions = 0;
+        int sampled = -1;
+        unsigned sampled_mask = 0;
+        for(int turn = 0; turn < MAX_SIMULATED_TURNS && !game.has_winner(); ++turn){
+            if(game.pass_stuck_turns() > 0){
+                continue;
+            }
+            int seat = game.get_turn();
+            unsigned mask = legal(game, seat);
+            if(mask == 0){
+                break;
+            }
+            int key = infoset(game, seat);
+            current(key, mask, policy);
+            if(seat == traverser && rng.below(++decisions) == 0){
+                bytes = Snapshot::save(game, snapshot, sizeof(snapshot));
+                sampled = key;
+                sampled_mask = mask;
+            }
+            double* sum = &_sum[key * ACTIONS];
+            for(int a = 0; a < ACTIONS; ++a){
+                sum[a] += policy[a];
+            }
+            concrete(game, seat, sample(policy, rng), m);
+            play_move(game, m, blocks);
+        }
+        if(sampled >= 0){
+            current(sampled, sampled_mask, policy);
+            double expected = 0;
+            for(int a = 0; a < ACTIONS; ++a){
+                if(sampled_mask & (1u << a)){
+                    Snapshot::load(scratch, snapshot, bytes);
+                    concrete(scratch, traverser, a, m);
+                    play_move(scratch, m, blocks);
+                    value[a] = playout(scratch, traverser, rng);
+                    expected += policy[a] * value[a];
+                }
+            }
+            double* regret = &_regret[sampled * ACTIONS];
+            for(int a = 0; a < ACTIONS; ++a){
+                if(sampled_mask & (1u << a)){
+                    regret[a] = std::max(0.0, regret[a] + value[a] - expected);
+                }
+            }
+        }
+        _trained++;
+    }
+}
+
+/**
+ * @brief Writes the table: "COUPCFR1", infoset and action counts (u32), games trained
+ * (u64), then the regrets and policy sums as doubles, host byte order.
+ * @throws std::runtime_error if the file cannot be written.
+ */
+void CfrTable::save(const std::string& path) const{
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    std::uint32_t shape[2] = {INFOSETS, ACTIONS};
+    out.write(MAGIC, sizeof(MAGIC));
+    out.write(reinterpret_cast<const char*>(shape), sizeof(shape));
+    out.write(reinterpret_cast<const char*>(&_trained), sizeof(_trained));
+    out.write(reinterpret_cast<const char*>(_regret.data()), static_cast<std::streamsize>(_regret.size() * sizeof(double)));
+    out.write(reinterpret_cast<const char*>(_sum.data()), static_cast<std::streamsize>(_sum.size() * sizeof(double)));
+    if(!out){
+        throw std::runtime_error("Cannot write CFR table: " + path);
+    }
+}
+/**
+ * @throws std::runtime_error if the file is missing, truncated or of another shape.
+ */
+CfrTable CfrTable::load(const std::string& path){
+    std::ifstream in(path, std::ios::binary);
+    if(!in){
+        throw std::runtime_error("Cannot open CFR table: " + path);
+    }
+    char magic[8];
+    std::uint32_t shape[2];
+    CfrTable table;
+    in.read(magic, sizeof(magic));
+    in.read(reinterpret_cast<char*>(shape), sizeof(shape));
+    if(!in || std::memcmp(magic, MAGIC, sizeof(MAGIC)) != 0 || shape[0] != INFOSETS || shape[1] != ACTIONS){
+        throw std::runtime_error("Not a CFR table for this abstraction: " + path);
+    }
+    in.read(reinterpret_cast<char*>(&table._trained), sizeof(table._trained));
+    in.read(reinterpret_cast<char*>(table._regret.data()), static_cast<std::streamsize>(table._regret.size() * sizeof(double)));
+    in.read(reinterpret_cast<char*>(table._sum.data()), static_cast<std::streamsize>(table._sum.size() * sizeof(double)));
+    if(!in){
+        throw std::runtime_error("Truncated CFR table: " + path);
+    }
+    return table;
+}
+
+CfrStrategy::CfrStrategy(std::shared_ptr<const CfrTable> table)
+    : _table(std::move(table))
+{
+}
+
+Move CfrStrategy::choose(Game& game, int seat, Rng& rng){
+    Move m{GameAction::NONE, seat};
+    unsigned mask = CfrTable::legal(game, seat);
+    if(mask == 0){
+        game.first_legal_move(seat, m);
+        return m;
+    }
+    double policy[CfrTable::ACTIONS];
+    _table->average(CfrTable::infoset(game, seat), mask, policy);
+    CfrTable::concrete(game, seat, sample(policy, rng), m);
+    return m;
+}
+
+/**
+ * @brief Table trained with DEFAULT_TRAINING_GAMES games from a fixed seed, on first use
+ * (thread-safe), and shared from then on.
+ */
+std::shared_ptr<const CfrTable> default_cfr_table(){
+    static const std::shared_ptr<const CfrTable> table = [](){
+        auto t = std::make_shared<CfrTable>();
+        Rng rng(50);
+        t->train(CfrTable::DEFAULT_TRAINING_GAMES, rng);
+        return std::shared_ptr<const CfrTable>(t);
+    }();
+    return table;
+}
@@ -0,0 +1,65 @@
+#ifndef CFR_HPP
+#define CFR_HPP
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include "Strategy.hpp"
+
+/**
+ * @brief Policy table learned by counterfactual regret minimisation over an abstraction
+ * of the game. An information set is what a seat sees in five coarse features (its coin
+ * bucket, whether it is sanctioned or may arrest, the richest opponent's coin bucket and
+ * how many players are left); an action is one of gather, tax, bribe, arrest, sanction
+ * or coup, aimed at the richest opponent it is legal against.
+ * train() runs sampled CFR+: in each self-play game one seat is the traverser, and at
+ * one of its turns every legal action is valued by playing the game out under the
+ * current policies; the regrets against the policy's own value are added to that
+ * information set, floored at zero. Play uses the average policy, which is what
+ * converges.
+ */
+class CfrTable{
+    public:
+        static constexpr int INFOSETS = 5 * 2 * 2 * 3 * 3;
+        static constexpr int ACTIONS = 6;
+        static constexpr std::size_t DEFAULT_TRAINING_GAMES = 5000;
+
+    private:
+        std::vector<double> _regret;
+        std::vector<double> _sum;
+        std::uint64_t _trained;
+
+        void current(int infoset, unsigned legal, double* policy) const;
+        int playout(Game& game, int traverser, Rng& rng) const;
+
+    public:
+        CfrTable();
+
+        static int infoset(Game& game, int seat);
+        static unsigned legal(Game& game, int seat);
+        static bool concrete(Game& game, int seat, int action, Move& out);
+
+        void train(std::size_t games, Rng& rng);
+        void average(int infoset, unsigned legal, double* policy) const;
+        std::uint64_t trained() const { return _trained; }
+
+        void save(const std::string& path) const;
+        static CfrTable load(const std::string& path);
+};
+
+/**
+ * @brief Plays a CfrTable's average policy. Instances share one immutable table.
+ */
+class CfrStrategy : public Strategy{
+    private:
+        std::shared_ptr<const CfrTable> _table;
+    public:
+        explicit CfrStrategy(std::shared_ptr<const CfrTable> table);
+
+        const char* name() const override { return "cfr"; }
+        Move choose(Game& game, int seat, Rng& rng) override;
+};
+
+std::shared_ptr<const CfrTable> default_cfr_table();
+#endif
@@ -0,0 +1,89 @@
+#include "CowState.hpp"
+#include "../Players/PlayerFactory.hpp"
+#include <stdexcept>
+
+namespace {
+SeatState read_seat(PlayerList& players, int seat){
+    SeatMask bit = seat_bit(seat);
+    return SeatState{players.coins(seat),
+                     (players.active_mask() & bit) != 0,
+                     (players.sanction_mask() & bit) != 0,
+                     (players.can_arrest_mask() & bit) != 0,
+                     (players.arrested_mask() & bit) != 0,
+                     players[seat]->get_lastAction()};
+}
+bool same_seat(const SeatState& a, const SeatState& b){
+    return a.coins == b.coins && a.active == b.active && a.sanction == b.sanction &&
+           a.can_arrest == b.can_arrest && a.last_arrested == b.last_arrested && a.last_action == b.last_action;
+}
+}
+
+CowState::CowState() : _size(0), _turn(0), _bribe(false) {}
+
+/**
+ * @brief Builds a state from the game's table, with a fresh block per seat.
+ */
+CowState CowState::capture(Game& game){
+    PlayerList& players = game.get_players();
+    auto table = std::make_shared<TableInfo>();
+    CowState s;
+    s._size = static_cast<int>(players.size());
+    for(int i = 0; i < s._size; ++i){
+        table->names.push_back(players[i]->get_name());
+        table->roles.push_back(players.role(i));
+        s._seats[i] = std::make_shared<const SeatState>(read_seat(players, i));
+    }
+    s._table = std::move(table);
+    s._turn = game.get_turn();
+    s._bribe = game.get_isBribe();
+    return s;
+}
+/**
+ * @brief Deletes the game's players and seats this state's table, then loads the state.
+ */
+void CowState::seat(Game& game) const{
+    game.clear_players();
+    for(int i = 0; i < _size; ++i){
+        game.get_players().push_back(PlayerFactory::createPlayer(role_name(_table->roles[i]), game, _table->names[i]));
+    }
+    load(game);
+}
+/**
+ * @brief Overwrites a table already seated by seat() with this state.
+ * @throws std::runtime_error if the game's table has a different size.
+ */
+void CowState::load(Game& game) const{
+    PlayerList& players = game.get_players();
+    if(static_cast<int>(players.size()) != _size){
+        throw std::runtime_error("CowState does not match the seated table");
+    }
+    for(int i = 0; i < _size; ++i){
+        const SeatState& s = *_seats[i];
+        players[i]->set_state(s.coins, s.active, s.sanction, s.can_arrest, s.last_arrested, s.last_action);
+    }
+    game.set_turn(_turn);
+    game.set_isBribe(_bribe);
+}
+/**
+ * @brief Returns the state after a move, sharing every seat block the move left unchanged.
+ * @param scratch Game seated with this match's table; its state is overwritten.
+ * @param status Set to the move's validation result; on failure the result equals *this.
+ */
+CowState CowState::after(Game& scratch, const Move& m, MoveStatus& status) const{
+    load(scratch);
+    status = scratch.apply(m);
+    CowState next(*this);
+    if(status != MoveStatus::OK){
+        return next;
+    }
+    PlayerList& players = scratch.get_players();
+    for(int i = 0; i < _size; ++i){
+        SeatState now = read_seat(players, i);
+        if(!same_seat(now, *_seats[i])){
+            next._seats[i] = std::make_shared<const SeatState>(now);
+        }
+    }
+    next._turn = scratch.get_turn();
+    next._bribe = scratch.get_isBribe();
+    return next;
+}
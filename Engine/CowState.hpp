@@ -0,0 +1,49 @@
+#ifndef COWSTATE_HPP
+#define COWSTATE_HPP
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+#include "EventLog.hpp"
+#include "../Game.hpp"
+
+/**
+ * @brief Parts of a table that never change during a match: names and roles.
+ */
+struct TableInfo{
+    std::vector<std::string> names;
+    std::vector<Role> roles;
+};
+
+/**
+ * @brief Persistent (copy-on-write) game state for search trees and what-if previews.
+ * Each seat's mutable state lives in its own immutable, reference-counted block, and the
+ * table description is shared by every state of the match. Copying a CowState copies
+ * pointers only; after() re-applies a move through a scratch Game and allocates new
+ * blocks only for the seats the move touched, so parent and child share the rest.
+ */
+class CowState{
+    private:
+        std::shared_ptr<const TableInfo> _table;
+        std::shared_ptr<const SeatState> _seats[PlayerList::CAPACITY];
+        int _size;
+        int _turn;
+        bool _bribe;
+
+    public:
+        CowState();
+
+        static CowState capture(Game& game);
+        void seat(Game& game) const;
+        void load(Game& game) const;
+        CowState after(Game& scratch, const Move& m, MoveStatus& status) const;
+
+        int size() const { return _size; }
+        int turn() const { return _turn; }
+        bool bribe() const { return _bribe; }
+        const SeatState& seat_state(int seat) const { return *_seats[seat]; }
+        const TableInfo& table() const { return *_table; }
+        bool shares_seat(const CowState& other, int seat) const { return _seats[seat] == other._seats[seat]; }
+};
+#endif
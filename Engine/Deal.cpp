@@ -0,0 +1,42 @@
+#include "Deal.hpp"
+#include "../Players/PlayerFactory.hpp"
+#include <string>
+
+/**
+ * @brief Draws a role for each seat, uniformly and independently (roles may repeat).
+ * @param rng Stream to draw from; the same seed always deals the same roles.
+ * @param players Number of seats.
+ */
+std::vector<Role> deal_roles(Rng& rng, int players){
+    std::vector<Role> roles(players);
+    for(Role& r : roles){
+        // Every role but CITIZEN, which is the unassigned placeholder
+        r = static_cast<Role>(1 + rng.below(ROLE_COUNT - 1));
+    }
+    return roles;
+}
+/**
+ * @brief Deletes the current players and seats the given roles: "Player 1".."Player n",
+ * STARTING_COINS each, first seat to play.
+ * @throws std::runtime_error if there are more roles than the table capacity.
+ */
+void seat_roles(Game& game, std::span<const Role> roles){
+    game.get_players().reserve(roles.size());
+    game.clear_players();
+    for(Role role : roles){
+        int seat = static_cast<int>(game.get_players().size());
+        Player* p = PlayerFactory::createPlayer(role_name(role), game, "Player " + std::to_string(seat + 1));
+        p->set_coins(STARTING_COINS);
+        game.get_players().push_back(p);
+    }
+    game.set_turn(0);
+}
+/**
+ * @brief Seats a freshly dealt table of players seats (see seat_roles).
+ * @throws std::runtime_error if players exceeds the table capacity.
+ */
+void deal_table(Game& game, int players, Rng& rng){
+    game.get_players().reserve(players);
+    std::vector<Role> roles = deal_roles(rng, players);
+    seat_roles(game, roles);
+}
@@ -0,0 +1,14 @@
+#ifndef DEAL_HPP
+#define DEAL_HPP
+
+#include <span>
+#include <vector>
+#include "Rng.hpp"
+#include "../Game.hpp"
+
+constexpr int STARTING_COINS = 2;
+
+std::vector<Role> deal_roles(Rng& rng, int players);
+void seat_roles(Game& game, std::span<const Role> roles);
+void deal_table(Game& game, int players, Rng& rng);
+#endif
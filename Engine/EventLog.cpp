@@ -0,0 +1,308 @@
+#include "EventLog.hpp"
+#include "../Game.hpp"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+
+namespace {
+const char MAGIC[7] = {'C', 'O', 'U', 'P', 'L', 'O', 'G'};
+}
+
+EventLog::EventLog()
+    : _events(0), _game(nullptr), _snapshot_interval(DEFAULT_SNAPSHOT_INTERVAL), _moves_since_snapshot(0)
+{
+    _bytes.reserve(256);
+}
+/**
+ * @brief Starts a fresh log with a header describing the current table.
+ * A game already in play (some seat out, sanctioned or barred from arresting, a bribe
+ * pending, ...) carries state the header cannot hold; it gets a SNAPSHOT at event 0 so
+ * the log replays on its own from the first byte.
+ * @param game Game to log from here; its seats, coins and turn are recorded.
+ */
+void EventLog::begin(Game& game){
+    clear();
+    _game = &game;
+    for(char c : MAGIC){
+        _bytes.push_back(static_cast<std::uint8_t>(c));
+    }
+    _bytes.push_back(VERSION);
+    PlayerList& players = game.get_players();
+    put_varint(static_cast<std::uint32_t>(players.size()));
+    for(Player* p : players){
+        std::string name = p->get_name();
+        put_varint(static_cast<std::uint32_t>(name.size()));
+        for(char c : name){
+            _bytes.push_back(static_cast<std::uint8_t>(c));
+        }
+        _bytes.push_back(static_cast<std::uint8_t>(p->get_role()));
+        put_varint(static_cast<std::uint32_t>(p->get_coins()));
+    }
+    put_varint(static_cast<std::uint32_t>(game.get_turn()));
+    bool fresh = !game.get_isBribe();
+    for(Player* p : players){
+        fresh = fresh && p->get_isActive() && !p->get_isSanction() && p->get_canArrest() &&
+                !p->get_lastArrested() && p->get_lastAction() == GameAction::NONE;
+    }
+    if(!fresh){
+        put_snapshot();
+    }
+}
+/**
+ * @brief Sets how many moves pass between embedded snapshots; 0 disables them.
+ */
+void EventLog::set_snapshot_interval(std::size_t moves){
+    _snapshot_interval = moves;
+}
+/**
+ * @brief Writes the game's current state as a SNAPSHOT record.
+ * Body: events, turn and bribe flag, then per seat the coins and one byte holding
+ * the four status bits (low nibble) and the last action (high nibble).
+ */
+void EventLog::put_snapshot(){
+    _moves_since_snapshot = 0;
+    if(!_game){
+        return;
+    }
+    _snapshots.push_back(SnapshotMark{_events, _bytes.size()});
+    _bytes.push_back(static_cast<std::uint8_t>(static_cast<int>(EventKind::SNAPSHOT) << 4));
+    std::size_t length_at = _bytes.size();
+    _bytes.push_back(0);                          // body length, patched below
+    std::size_t body_at = _bytes.size();
+    put_varint(static_cast<std::uint32_t>(_events));
+    put_varint(static_cast<std::uint32_t>(_game->get_turn()));
+    _bytes.push_back(_game->get_isBribe() ? 1 : 0);
+    for(Player* p : _game->get_players()){
+        put_varint(static_cast<std::uint32_t>(p->get_coins()));
+        int flags = (p->get_isActive() ? 1 : 0) | (p->get_isSanction() ? 2 : 0) |
+                    (p->get_canArrest() ? 4 : 0) | (p->get_lastArrested() ? 8 : 0);
+        _bytes.push_back(static_cast<std::uint8_t>(flags | (static_cast<int>(p->get_lastAction()) << 4)));
+    }
+    std::size_t body = _bytes.size() - body_at;
+    if(body < 0x80){
+        _bytes[length_at] = static_cast<std::uint8_t>(body);
+        return;
+    }
+    // Large tables: widen the length field to a full varint
+    std::vector<std::uint8_t> length;
+    for(std::uint32_t v = static_cast<std::uint32_t>(body); ; v >>= 7){
+        length.push_back(static_cast<std::uint8_t>(v >= 0x80 ? (v | 0x80) : v));
+        if(v < 0x80){
+            break;
+        }
+    }
+    _bytes.erase(_bytes.begin() + static_cast<std::ptrdiff_t>(length_at));
+    _bytes.insert(_bytes.begin() + static_cast<std::ptrdiff_t>(length_at), length.begin(), length.end());
+}
+const std::vector<std::uint8_t>& EventLog::get_bytes() const{
+    return _bytes;
+}
+std::size_t EventLog::get_events() const{
+    return _events;
+}
+/**
+ * @brief Snapshots in the log, in order.
+ */
+const std::vector<SnapshotMark>& EventLog::get_snapshots() const{
+    return _snapshots;
+}
+void EventLog::clear(){
+    _bytes.clear();
+    _snapshots.clear();
+    _events = 0;
+    _moves_since_snapshot = 0;
+}
+/**
+ * @brief Appends the log to a file (created if missing).
+ * @throws std::runtime_error if the file cannot be written.
+ */
+void EventLog::append_to(const std::string& path) const{
+    std::ofstream out(path, std::ios::binary | std::ios::app);
+    out.write(reinterpret_cast<const char*>(_bytes.data()), static_cast<std::streamsize>(_bytes.size()));
+    if(!out){
+        throw std::runtime_error("Cannot write event log: " + path);
+    }
+}
+/**
+ * @brief Reads a log file written by append_to.
+ * @throws std::runtime_error if the file cannot be read or is not a valid log.
+ */
+EventLog EventLog::load(const std::string& path){
+    std::ifstream in(path, std::ios::binary);
+    if(!in){
+        throw std::runtime_error("Cannot read event log: " + path);
+    }
+    std::vector<std::uint8_t> bytes((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    return from_bytes(bytes.data(), bytes.size());
+}
+EventLog EventLog::from_bytes(const std::uint8_t* data, std::size_t size){
+    EventLog log;
+    log._bytes.assign(data, data + size);
+    EventReader reader(data, size);
+    reader.read_header();
+    Event e;
+    while(reader.position() != data + size){
+        const std::uint8_t* at = reader.position();
+        if(static_cast<EventKind>(*at >> 4) == EventKind::SNAPSHOT){       // the first may open a restored log
+            log._snapshots.push_back(SnapshotMark{log._events, static_cast<std::size_t>(at - data)});
+        }
+        if(!reader.next(e)){
+            break;
+        }
+        log._events++;
+    }
+    return log;
+}
+
+EventReader::EventReader(const std::uint8_t* data, std::size_t size)
+    : _begin(data), _pos(data), _end(data + size), _snapshots(nullptr), _seats(0)
+{}
+EventReader::EventReader(const EventLog& log)
+    : EventReader(log.get_bytes().data(), log.get_bytes().size())
+{
+    _snapshots = &log.get_snapshots();
+}
+std::uint32_t EventReader::get_varint(){
+    std::uint32_t v = 0;
+    for(int shift = 0; shift < 35; shift += 7){
+        if(_pos == _end){
+            throw std::runtime_error("Truncated event log");
+        }
+        std::uint8_t b = *_pos++;
+        v |= static_cast<std::uint32_t>(b & 0x7f) << shift;
+        if(!(b & 0x80)){
+            return v;
+        }
+    }
+    throw std::runtime_error("Corrupt varint in event log");
+}
+LogHeader EventReader::read_header(){
+    if(_end - _pos < static_cast<std::ptrdiff_t>(sizeof(MAGIC) + 1) || std::memcmp(_pos, MAGIC, sizeof(MAGIC)) != 0){
+        throw std::runtime_error("Not an event log");
+    }
+    _pos += sizeof(MAGIC);
+    std::uint8_t version = *_pos++;
+    if(version < 1 || version > EventLog::VERSION){
+        throw std::runtime_error("Unsupported event log version");
+    }
+    LogHeader header;
+    std::uint32_t seats = get_varint();
+    for(std::uint32_t i = 0; i < seats; ++i){
+        std::uint32_t len = get_varint();
+        if(static_cast<std::uint32_t>(_end - _pos) < len + 1){
+            throw std::runtime_error("Truncated event log");
+        }
+        header.names.emplace_back(reinterpret_cast<const char*>(_pos), len);
+        _pos += len;
+        header.roles.push_back(static_cast<Role>(*_pos++));
+        header.coins.push_back(static_cast<int>(get_varint()));
+    }
+    header.turn = static_cast<int>(get_varint());
+    _seats = seats;
+    return header;
+}
+/**
+ * @brief Decodes the next record.
+ * @return false at the end of the log.
+ */
+bool EventReader::next(Event& e){
+    if(_pos == _end){
+        return false;
+    }
+    std::uint8_t tag = *_pos++;
+    while(static_cast<EventKind>(tag >> 4) == EventKind::SNAPSHOT){
+        std::uint32_t len = get_varint();
+        if(static_cast<std::uint32_t>(_end - _pos) < len){
+            throw std::runtime_error("Truncated event log");
+        }
+        _pos += len;
+        if(_pos == _end){
+            return false;
+        }
+        tag = *_pos++;
+    }
+    if((tag >> 4) > static_cast<int>(EventKind::SNAPSHOT) || (tag & 0x0f) > static_cast<int>(GameAction::UNIQE)){
+        throw std::runtime_error("Corrupt event tag in event log");
+    }
+    e.kind = static_cast<EventKind>(tag >> 4);
+    e.action = static_cast<GameAction>(tag & 0x0f);
+    e.seat = static_cast<int>(get_varint());
+    e.target = static_cast<int>(get_varint()) - 1;
+    return true;
+}
+void EventReader::read_snapshot(const std::uint8_t* end, LogSnapshot& s){
+    s.events = get_varint();
+    s.turn = static_cast<int>(get_varint());
+    if(_pos == end){
+        throw std::runtime_error("Truncated snapshot in event log");
+    }
+    s.bribe = *_pos++ != 0;
+    s.seats.resize(_seats);
+    for(SeatState& seat : s.seats){
+        seat.coins = static_cast<int>(get_varint());
+        if(_pos == end){
+            throw std::runtime_error("Truncated snapshot in event log");
+        }
+        std::uint8_t flags = *_pos++;
+        seat.active = flags & 1;
+        seat.sanction = flags & 2;
+        seat.can_arrest = flags & 4;
+        seat.last_arrested = flags & 8;
+        seat.last_action = static_cast<GameAction>(flags >> 4);
+    }
+    if(_pos != end){
+        throw std::runtime_error("Corrupt snapshot in event log");
+    }
+}
+/**
+ * @brief Finds the latest snapshot taken at or before event max_events (and not behind
+ * the reader) and moves the reader just past it. With the log's snapshot offsets this is
+ * a binary search; over bare bytes the records are skipped over, never applied.
+ * @return false (reader unmoved) if no such snapshot exists.
+ */
+bool EventReader::seek_snapshot(std::size_t max_events, LogSnapshot& s){
+    const std::uint8_t* start = _pos;
+    if(_snapshots){
+        auto it = std::upper_bound(_snapshots->begin(), _snapshots->end(), max_events,
+                                   [](std::size_t events, const SnapshotMark& m){ return events < m.events; });
+        if(it == _snapshots->begin() || (--it)->offset < static_cast<std::size_t>(start - _begin)){
+            return false;
+        }
+        if(it->offset >= static_cast<std::size_t>(_end - _begin) ||
+           static_cast<EventKind>(_begin[it->offset] >> 4) != EventKind::SNAPSHOT){
+            throw std::runtime_error("Snapshot index does not match the event log");
+        }
+        _pos = _begin + it->offset + 1;
+        std::uint32_t len = get_varint();
+        if(static_cast<std::uint32_t>(_end - _pos) < len){
+            throw std::runtime_error("Truncated event log");
+        }
+        read_snapshot(_pos + len, s);
+        return true;
+    }
+    const std::uint8_t* best = nullptr;
+    while(_pos != _end){
+        std::uint8_t tag = *_pos++;
+        if(static_cast<EventKind>(tag >> 4) != EventKind::SNAPSHOT){
+            get_varint();
+            get_varint();
+            continue;
+        }
+        std::uint32_t len = get_varint();
+        if(static_cast<std::uint32_t>(_end - _pos) < len){
+            throw std::runtime_error("Truncated event log");
+        }
+        const std::uint8_t* body_end = _pos + len;
+        const std::uint8_t* body = _pos;
+        if(get_varint() > max_events){
+            break;
+        }
+        _pos = body;
+        read_snapshot(body_end, s);
+        best = _pos;
+    }
+    _pos = best ? best : start;
+    return best != nullptr;
+}
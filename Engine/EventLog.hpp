@@ -0,0 +1,161 @@
+#ifndef EVENTLOG_HPP
+#define EVENTLOG_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "../Move.hpp"
+#include "../Role.hpp"
+
+class Game;
+
+enum class EventKind : std::uint8_t{
+    MOVE,
+    BLOCK,
+    ALLOW,
+    SNAPSHOT,
+};
+
+/**
+ * @brief One logged event. For MOVE, seat is the actor; for BLOCK/ALLOW it is the blocker
+ * answering the reaction window of the preceding move.
+ */
+struct Event{
+    EventKind kind;
+    GameAction action;
+    int seat;
+    int target = -1;
+};
+
+/**
+ * @brief Table as it was when logging started: names, roles, coins and whose turn it is.
+ */
+struct LogHeader{
+    std::vector<std::string> names;
+    std::vector<Role> roles;
+    std::vector<int> coins;
+    int turn = 0;
+};
+
+/**
+ * @brief Per-seat part of a snapshot.
+ */
+struct SeatState{
+    int coins;
+    bool active;
+    bool sanction;
+    bool can_arrest;
+    bool last_arrested;
+    GameAction last_action;
+};
+
+/**
+ * @brief Full game state embedded in a log, taken just before a move is applied.
+ * events is the number of events logged before it, so replay can resume from there.
+ */
+struct LogSnapshot{
+    std::size_t events = 0;
+    int turn = 0;
+    bool bribe = false;
+    std::vector<SeatState> seats;
+};
+
+/**
+ * @brief Where a SNAPSHOT record sits in a log: the events logged before it and the
+ * byte offset of its tag.
+ */
+struct SnapshotMark{
+    std::size_t events;
+    std::size_t offset;
+};
+
+/**
+ * @brief Append-only binary log of a match.
+ * Layout: "COUPLOG" + version byte, the table header, then one record per event:
+ * a tag byte (kind in the high nibble, GameAction in the low nibble) followed by the
+ * seat and target+1 as LEB128 varints. Tables under 128 seats give fixed 3-byte records.
+ * Every snapshot-interval moves a SNAPSHOT record (tag, varint body length, body) is
+ * written before the move, and a log begun mid-game opens with one at event 0; readers
+ * skip them unless they are seeking. The log keeps the
+ * offset of every snapshot it wrote or loaded, so a seek goes straight to one.
+ */
+class EventLog{
+    private:
+        std::vector<std::uint8_t> _bytes;
+        std::vector<SnapshotMark> _snapshots;
+        std::size_t _events;
+        Game* _game;
+        std::size_t _snapshot_interval;
+        std::size_t _moves_since_snapshot;
+
+        void put_varint(std::uint32_t v){
+            while(v >= 0x80){
+                _bytes.push_back(static_cast<std::uint8_t>(v | 0x80));
+                v >>= 7;
+            }
+            _bytes.push_back(static_cast<std::uint8_t>(v));
+        }
+        void put_record(EventKind kind, GameAction action, int seat, int target){
+            _bytes.push_back(static_cast<std::uint8_t>((static_cast<int>(kind) << 4) | static_cast<int>(action)));
+            put_varint(static_cast<std::uint32_t>(seat));
+            put_varint(static_cast<std::uint32_t>(target + 1));
+            _events++;
+        }
+        void put_snapshot();
+
+    public:
+        static constexpr std::uint8_t VERSION = 2;
+        static constexpr std::size_t DEFAULT_SNAPSHOT_INTERVAL = 64;
+
+        EventLog();
+
+        void begin(Game& game);
+        void set_snapshot_interval(std::size_t moves);
+        void record_move(const Move& m){
+            if(_snapshot_interval && _moves_since_snapshot == _snapshot_interval){
+                put_snapshot();
+            }
+            _moves_since_snapshot++;
+            put_record(EventKind::MOVE, m.action, m.actor, m.target);
+        }
+        void record_block(GameAction action, int blocker) { put_record(EventKind::BLOCK, action, blocker, -1); }
+        void record_allow(GameAction action, int blocker) { put_record(EventKind::ALLOW, action, blocker, -1); }
+
+        const std::vector<std::uint8_t>& get_bytes() const;
+        std::size_t get_events() const;
+        const std::vector<SnapshotMark>& get_snapshots() const;
+        void clear();
+        void append_to(const std::string& path) const;
+        static EventLog load(const std::string& path);
+        static EventLog from_bytes(const std::uint8_t* data, std::size_t size);
+};
+
+/**
+ * @brief Sequential decoder over a log's bytes.
+ * A reader made from an EventLog seeks through the log's snapshot offsets; one over bare
+ * bytes has none and scans for its snapshot.
+ * @throws std::runtime_error on a bad magic, unknown version, unknown tag or truncated record.
+ */
+class EventReader{
+    private:
+        const std::uint8_t* _begin;
+        const std::uint8_t* _pos;
+        const std::uint8_t* _end;
+        const std::vector<SnapshotMark>* _snapshots;
+
+        std::size_t _seats;
+
+        std::uint32_t get_varint();
+        void read_snapshot(const std::uint8_t* end, LogSnapshot& s);
+
+    public:
+        EventReader(const std::uint8_t* data, std::size_t size);
+        explicit EventReader(const EventLog& log);
+
+        LogHeader read_header();
+        bool next(Event& e);
+        bool seek_snapshot(std::size_t max_events, LogSnapshot& s);
+        const std::uint8_t* position() const { return _pos; }
+};
+#endif
@@ -0,0 +1,206 @@
+#include "History.hpp"
+#include "Replay.hpp"
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+
+namespace {
+std::uint8_t pack(const SeatState& s){
+    return static_cast<std::uint8_t>((s.active ? 1 : 0) | (s.sanction ? 2 : 0) | (s.can_arrest ? 4 : 0) |
+                                     (s.last_arrested ? 8 : 0) | (static_cast<int>(s.last_action) << 4));
+}
+void unpack(std::uint8_t flags, SeatState& s){
+    s.active = flags & 1;
+    s.sanction = flags & 2;
+    s.can_arrest = flags & 4;
+    s.last_arrested = flags & 8;
+    s.last_action = static_cast<GameAction>(flags >> 4);
+}
+std::uint32_t get_varint(const std::uint8_t*& pos){
+    std::uint32_t v = 0;
+    for(int shift = 0; ; shift += 7){
+        std::uint8_t b = *pos++;
+        v |= static_cast<std::uint32_t>(b & 0x7f) << shift;
+        if(!(b & 0x80)){
+            return v;
+        }
+    }
+}
+}
+
+History::History() : _first(0), _retention(0), _since_compact(0) {}
+
+/**
+ * @brief Reads the table's current state from the per-seat arrays.
+ */
+void History::capture(Game& game, LogSnapshot& s){
+    PlayerList& players = game.get_players();
+    s.turn = game.get_turn();
+    s.bribe = game.get_isBribe();
+    s.seats.resize(players.size());
+    for(std::size_t i = 0; i < players.size(); ++i){
+        int seat = static_cast<int>(i);
+        SeatMask bit = seat_bit(seat);
+        SeatState& st = s.seats[i];
+        st.coins = players.coins(seat);
+        st.active = players.active_mask() & bit;
+        st.sanction = players.sanction_mask() & bit;
+        st.can_arrest = players.can_arrest_mask() & bit;
+        st.last_arrested = players.arrested_mask() & bit;
+        st.last_action = players[i]->get_lastAction();
+    }
+}
+void History::put_varint(std::uint32_t v){
+    while(v >= 0x80){
+        _deltas.push_back(static_cast<std::uint8_t>(v | 0x80));
+        v >>= 7;
+    }
+    _deltas.push_back(static_cast<std::uint8_t>(v));
+}
+/**
+ * @brief Drops any previous history and makes the game's current state index 0.
+ */
+void History::begin(Game& game){
+    _keyframes.clear();
+    _deltas.clear();
+    _offsets.clear();
+    _first = 0;
+    _since_compact = 0;
+    capture(game, _current);
+    _current.events = 0;
+    _keyframes.push_back({0, _current});
+}
+/**
+ * @brief Appends the game's current state as the next index, storing only what changed.
+ * @throws std::runtime_error if begin() was not called or the table size changed.
+ */
+void History::record(Game& game){
+    if(_keyframes.empty()){
+        throw std::runtime_error("History::record called before begin");
+    }
+    if(game.get_players().size() != _current.seats.size()){
+        throw std::runtime_error("Table size changed during history recording");
+    }
+    std::swap(_previous, _current);
+    capture(game, _current);
+    std::size_t index = size();
+    _current.events = index;
+
+    _offsets.push_back(static_cast<std::uint32_t>(_deltas.size()));
+    put_varint(static_cast<std::uint32_t>(_current.turn));
+    std::size_t header_at = _deltas.size();
+    _deltas.push_back(0);
+    int changed = 0;
+    for(std::size_t i = 0; i < _current.seats.size(); ++i){
+        const SeatState& now = _current.seats[i];
+        const SeatState& was = _previous.seats[i];
+        std::uint8_t flags = pack(now);
+        if(now.coins != was.coins || flags != pack(was)){
+            _deltas.push_back(static_cast<std::uint8_t>(i));
+            _deltas.push_back(flags);
+            put_varint(static_cast<std::uint32_t>(now.coins));
+            changed++;
+        }
+    }
+    _deltas[header_at] = static_cast<std::uint8_t>((_current.bribe ? 1 : 0) | (changed << 1));
+
+    if(index % KEYFRAME_INTERVAL == 0){
+        _keyframes.push_back({index, _current});
+    }
+    if(_retention && ++_since_compact >= COMPACT_INTERVAL){
+        compact();
+    }
+}
+/**
+ * @brief Oldest index still stored.
+ */
+std::size_t History::first() const{
+    return _first;
+}
+/**
+ * @brief One past the newest index.
+ */
+std::size_t History::size() const{
+    return _keyframes.empty() ? 0 : _first + 1 + _offsets.size();
+}
+/**
+ * @brief Applies the diff that produced state index on top of state index - 1.
+ */
+void History::apply_delta(std::size_t index, LogSnapshot& s) const{
+    const std::uint8_t* pos = _deltas.data() + _offsets[index - _first - 1];
+    s.turn = static_cast<int>(get_varint(pos));
+    std::uint8_t header = *pos++;
+    s.bribe = header & 1;
+    for(int changed = header >> 1; changed > 0; --changed){
+        SeatState& st = s.seats[*pos++];
+        unpack(*pos++, st);
+        st.coins = static_cast<int>(get_varint(pos));
+    }
+    s.events = index;
+}
+/**
+ * @brief Rebuilds a stored state from the nearest keyframe at or before it.
+ * @throws std::runtime_error if the index was compacted away or not recorded yet.
+ */
+LogSnapshot History::state_at(std::size_t index) const{
+    if(index < _first || index >= size()){
+        throw std::runtime_error("History has no state " + std::to_string(index));
+    }
+    auto it = std::upper_bound(_keyframes.begin(), _keyframes.end(), index, [](std::size_t i, const Keyframe& k){
+        return i < k.index;
+    });
+    const Keyframe& key = *(it - 1);
+    LogSnapshot s = key.state;
+    for(std::size_t i = key.index + 1; i <= index; ++i){
+        apply_delta(i, s);
+    }
+    return s;
+}
+/**
+ * @brief Puts the seated table back into a stored state.
+ */
+void History::restore(Game& game, std::size_t index) const{
+    Replayer::restore(game, state_at(index));
+}
+/**
+ * @brief Keeps at most this many recent states (0 keeps everything); applied on compaction.
+ */
+void History::set_retention(std::size_t states){
+    _retention = states;
+}
+/**
+ * @brief Folds states beyond the retention limit into a new base keyframe and releases
+ * spare capacity.
+ */
+void History::compact(){
+    _since_compact = 0;
+    if(_retention && size() - _first > _retention){
+        std::size_t new_first = size() - _retention;
+        Keyframe base{new_first, state_at(new_first)};
+        std::size_t dropped = new_first - _first;     // diffs producing states _first+1 .. new_first
+        std::uint32_t cut = dropped < _offsets.size() ? _offsets[dropped] : static_cast<std::uint32_t>(_deltas.size());
+        _deltas.erase(_deltas.begin(), _deltas.begin() + cut);
+        _offsets.erase(_offsets.begin(), _offsets.begin() + static_cast<std::ptrdiff_t>(dropped));
+        for(std::uint32_t& off : _offsets){
+            off -= cut;
+        }
+        _keyframes.erase(_keyframes.begin(), std::upper_bound(_keyframes.begin(), _keyframes.end(), new_first,
+            [](std::size_t i, const Keyframe& k){ return i < k.index; }));
+        _keyframes.insert(_keyframes.begin(), std::move(base));
+        _first = new_first;
+    }
+    _deltas.shrink_to_fit();
+    _offsets.shrink_to_fit();
+    _keyframes.shrink_to_fit();
+}
+/**
+ * @brief Heap bytes held by the history (diffs, offsets and keyframes).
+ */
+std::size_t History::memory_bytes() const{
+    std::size_t bytes = _deltas.capacity() + _offsets.capacity() * sizeof(std::uint32_t) +
+                        _keyframes.capacity() * sizeof(Keyframe);
+    for(const Keyframe& k : _keyframes){
+        bytes += k.state.seats.capacity() * sizeof(SeatState);
+    }
+    return bytes;
+}
@@ -0,0 +1,53 @@
+#ifndef HISTORY_HPP
+#define HISTORY_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "EventLog.hpp"
+#include "../Game.hpp"
+
+/**
+ * @brief In-memory history of a match's states, one per record() call, stored as diffs.
+ * Each diff holds the turn, the bribe flag and only the seats whose coins or flags changed:
+ * a varint turn, a byte (bribe bit | changed-seat count << 1), then per changed seat its
+ * index, a status/last-action byte and varint coins. A full keyframe every KEYFRAME_INTERVAL
+ * states bounds the cost of rebuilding one. With a retention limit, the history compacts
+ * itself every COMPACT_INTERVAL states by folding older states into a new base keyframe.
+ */
+class History{
+    public:
+        static constexpr std::size_t KEYFRAME_INTERVAL = 128;
+        static constexpr std::size_t COMPACT_INTERVAL = 1024;
+
+        History();
+
+        void begin(Game& game);
+        void record(Game& game);
+        std::size_t first() const;
+        std::size_t size() const;
+        LogSnapshot state_at(std::size_t index) const;
+        void restore(Game& game, std::size_t index) const;
+        void set_retention(std::size_t states);
+        void compact();
+        std::size_t memory_bytes() const;
+        static void capture(Game& game, LogSnapshot& s);
+
+    private:
+        struct Keyframe{
+            std::size_t index;
+            LogSnapshot state;
+        };
+        std::vector<Keyframe> _keyframes;
+        std::vector<std::uint8_t> _deltas;
+        std::vector<std::uint32_t> _offsets;   // _offsets[k]: start of the diff producing state _first + 1 + k
+        LogSnapshot _current;
+        LogSnapshot _previous;                 // scratch, kept to avoid reallocating per record
+        std::size_t _first;
+        std::size_t _retention;
+        std::size_t _since_compact;
+
+        void put_varint(std::uint32_t v);
+        void apply_delta(std::size_t index, LogSnapshot& s) const;
+};
+#endif
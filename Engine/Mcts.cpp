@@ -0,0 +1,124 @@
+#include "Mcts.hpp"
+#include <cmath>
+#include <stdexcept>
+
+namespace {
+constexpr double EXPLORATION = 1.4142135623730951;
+}
+
+/**
+ * @throws std::runtime_error if iterations is not positive.
+ */
+MctsStrategy::MctsStrategy(int iterations, int rollout_turns)
+    : _iterations(iterations), _rollout_turns(rollout_turns)
+{
+    if(iterations <= 0){
+        throw std::runtime_error("MCTS needs at least one iteration");
+    }
+}
+
+/**
+ * @brief UCB1 child of parent; children not yet visited come first.
+ */
+std::int32_t MctsStrategy::select(const Node& parent){
+    double log_visits = std::log(static_cast<double>(parent.visits));
+    std::int32_t best = parent.first_child;
+    double best_score = -1;
+    for(std::int32_t c = parent.first_child; c < parent.first_child + parent.children; ++c){
+        const Node& child = _nodes[c];
+        if(child.visits == 0){
+            return c;
+        }
+        double score = child.wins / child.visits + EXPLORATION * std::sqrt(log_visits / child.visits);
+        if(score > best_score){
+            best_score = score;
+            best = c;
+        }
+    }
+    return best;
+}
+/**
+ * @brief Adds a child for every legal move of the player to move on the scratch table.
+ */
+void MctsStrategy::expand(std::int32_t node){
+    int mover = _scratch.get_turn();
+    legal_moves(_scratch, mover, _moves);
+    _nodes[node].first_child = static_cast<std::int32_t>(_nodes.size());
+    _nodes[node].children = static_cast<std::int32_t>(_moves.size());
+    for(const Move& m : _moves){
+        _nodes.push_back(Node{m, mover, -1, 0, 0, 0});
+    }
+}
+/**
+ * @brief Plays the scratch table out with uniformly random moves.
+ * @return Winning seat, -1 if the turn cap was hit first.
+ */
+int MctsStrategy::rollout(Rng& rng){
+    for(int turn = 0; turn < _rollout_turns && !_scratch.has_winner(); ++turn){
+        if(_scratch.pass_stuck_turns() > 0){
+            continue;
+        }
+        int seat = _scratch.get_turn();
+        if(legal_moves(_scratch, seat, _moves) == 0){
+            break;
+        }
+        play_move(_scratch, _moves[rng.below(_moves.size())], _blocks);
+    }
+    return _scratch.winner_seat();
+}
+
+Move MctsStrategy::choose(Game& game, int seat, Rng& rng){
+    std::size_t bytes = Snapshot::save(game, _root, sizeof(_root));
+    legal_moves(game, seat, _moves);
+    for(const Move& m : _moves){
+        if(m.action == GameAction::COUP){
+            Snapshot::load(_scratch, _root, bytes);
+            play_move(_scratch, m, _blocks);
+            if(_scratch.winner_seat() == seat){
+                return m;                           // decisive: no search needed
+            }
+        }
+    }
+    _nodes.clear();
+    _nodes.push_back(Node{Move{GameAction::NONE, seat}, -1, -1, 0, 0, 0});
+    for(int it = 0; it < _iterations; ++it){
+        Snapshot::load(_scratch, _root, bytes);
+        _path.clear();
+        _path.push_back(0);
+        std::int32_t node = 0;
+        while(_nodes[node].first_child >= 0 && _nodes[node].children > 0){
+            node = select(_nodes[node]);
+            play_move(_scratch, _nodes[node].move, _blocks);
+            _scratch.pass_stuck_turns();
+            _path.push_back(node);
+        }
+        if(_nodes[node].first_child < 0 && !_scratch.has_winner()){
+            expand(node);
+            if(_nodes[node].children > 0){
+                node = _nodes[node].first_child + static_cast<std::int32_t>(rng.below(_nodes[node].children));
+                play_move(_scratch, _nodes[node].move, _blocks);
+                _scratch.pass_stuck_turns();
+                _path.push_back(node);
+            }
+        }
+        int winner = rollout(rng);
+        for(std::int32_t n : _path){
+            Node& visited = _nodes[n];
+            visited.visits++;
+            visited.wins += visited.mover == winner ? 1.0 : 0.0;
+        }
+    }
+    const Node& root = _nodes[0];
+    if(root.children == 0){
+        Move any{GameAction::NONE, seat};
+        game.first_legal_move(seat, any);
+        return any;
+    }
+    std::int32_t best = root.first_child;
+    for(std::int32_t c = root.first_child; c < root.first_child + root.children; ++c){
+        if(_nodes[c].visits > _nodes[best].visits){
+            best = c;
+        }
+    }
+    return _nodes[best].move;
+}
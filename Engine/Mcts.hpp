@@ -0,0 +1,49 @@
+#ifndef MCTS_HPP
+#define MCTS_HPP
+
+#include <cstdint>
+#include <vector>
+#include "Snapshot.hpp"
+#include "Strategy.hpp"
+
+/**
+ * @brief Monte Carlo tree search (UCT): each iteration restores the position on a scratch
+ * table from a binary snapshot, walks the tree by UCB1, expands one node, plays the game
+ * out with random moves and credits the win to the nodes whose mover won. Every reaction
+ * window along the way is resolved as a default Strategy would, by blocking. Every seat
+ * maximises its own wins, so no zero-sum assumption is made for multi-player tables.
+ * The most visited move at the root is played, unless a coup wins the game on the spot.
+ */
+class MctsStrategy : public Strategy{
+    private:
+        struct Node{
+            Move move;
+            int mover;
+            std::int32_t first_child;
+            std::int32_t children;
+            std::uint32_t visits;
+            double wins;
+        };
+        int _iterations;
+        int _rollout_turns;
+        Game _scratch;
+        std::vector<Node> _nodes;
+        std::vector<std::int32_t> _path;
+        std::vector<Move> _moves;
+        BlockAllPolicy _blocks;
+        std::uint8_t _root[sizeof(SnapshotHeader) + sizeof(SeatRecord) * PlayerList::CAPACITY];
+
+        std::int32_t select(const Node& parent);
+        void expand(std::int32_t node);
+        int rollout(Rng& rng);
+
+    public:
+        static constexpr int DEFAULT_ITERATIONS = 100;
+        static constexpr int DEFAULT_ROLLOUT_TURNS = 200;
+
+        explicit MctsStrategy(int iterations = DEFAULT_ITERATIONS, int rollout_turns = DEFAULT_ROLLOUT_TURNS);
+
+        const char* name() const override { return "mcts"; }
+        Move choose(Game& game, int seat, Rng& rng) override;
+};
+#endif
@@ -0,0 +1,217 @@
+#include "Rating.hpp"
+#include <algorithm>
+#include <cmath>
+#include <exception>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+namespace {
+// Elo points per natural-log unit of odds: a 400 point lead is 10:1
+constexpr double SCALE = 173.71779276130073;
+
+double initial_info(){
+    return (SCALE / RatingEngine::INITIAL_SIGMA) * (SCALE / RatingEngine::INITIAL_SIGMA);
+}
+
+/**
+ * @brief Adds one pool's share of a game to sums: the winner against every other seat.
+ * key[i] is seat i's index in the combined gradient, or -1 if it has none in this pool.
+ */
+void accumulate(const int* key, int players, int winner, double weight, const double* strength,
+                std::vector<double>& gradient, std::vector<double>& hessian, std::vector<std::uint32_t>& games){
+    int kw = key[winner];
+    if(kw < 0){
+        return;
+    }
+    for(int i = 0; i < players; ++i){
+        int ki = key[i];
+        if(ki < 0){
+            continue;
+        }
+        games[ki]++;
+        if(ki == kw){
+            continue;
+        }
+        double p = strength[kw] / (strength[kw] + strength[ki]);
+        double surprise = weight * (1 - p);
+        double information = weight * p * (1 - p);
+        gradient[kw] += surprise;
+        gradient[ki] -= surprise;
+        hessian[kw] += information;
+        hessian[ki] += information;
+    }
+}
+}
+
+RatingTable::RatingTable(std::size_t keys)
+    : _mu(keys, RatingEngine::INITIAL_MU), _info(keys, initial_info()), _games(keys, 0)
+{
+}
+double RatingTable::sigma(std::size_t key) const{
+    return SCALE / std::sqrt(_info[key]);
+}
+/**
+ * @brief Applies one batch: every key gains the batch's information and steps by its
+ * gradient over all the information it now has.
+ * @return Largest rating change.
+ */
+double RatingTable::update(const double* gradient, const double* hessian, const std::uint32_t* games){
+    double largest = 0;
+    for(std::size_t k = 0; k < _mu.size(); ++k){
+        _info[k] += hessian[k];
+        double change = SCALE * gradient[k] / _info[k];
+        _mu[k] += change;
+        _games[k] += games[k];
+        largest = std::max(largest, std::abs(change));
+    }
+    return largest;
+}
+
+/**
+ * @param strategies Number of strategies; results name them by index.
+ * @param batch Games rated together (at least one).
+ * @param threads Threads rating each batch (at least one).
+ * @throws std::runtime_error on too many strategies.
+ */
+RatingEngine::RatingEngine(std::size_t strategies, std::size_t batch, unsigned threads)
+    : _strategies(strategies), _roles(ROLE_COUNT), _batch(batch == 0 ? 1 : batch), _threads(threads == 0 ? 1 : threads), _rated(0)
+{
+    if(strategies >= GameResult::NO_STRATEGY){
+        throw std::runtime_error("Too many strategies to rate");
+    }
+    _pending.reserve(_batch);
+}
+/**
+ * @brief Queues a game, and rates the batch once it is full.
+ * @throws std::runtime_error on a bad table size or winner, or a seat naming a strategy
+ * outside the engine's range.
+ */
+void RatingEngine::add(const GameResult& result){
+    if(result.players < 2 || result.players > PlayerList::CAPACITY || result.winner >= result.players){
+        throw std::runtime_error("Malformed game result");
+    }
+    for(int i = 0; i < result.players; ++i){
+        if(result.strategies[i] != GameResult::NO_STRATEGY && result.strategies[i] >= _strategies.size()){
+            throw std::runtime_error("Unknown strategy index " + std::to_string(result.strategies[i]));
+        }
+    }
+    if(result.winner < 0){
+        return;
+    }
+    _pending.push_back(result);
+    if(_pending.size() >= _batch){
+        flush();
+    }
+}
+/**
+ * @brief Queues an archived game: its roles are rated, it has no strategies.
+ * @return false if it was skipped: unfinished, or larger than the index records roles
+ * for (or than the table).
+ */
+bool RatingEngine::add(const ArchiveEntry& entry){
+    if(entry.players < 2 || entry.players > PlayerList::CAPACITY || entry.players > 16 || entry.winner < 0){
+        return false;
+    }
+    GameResult result;
+    result.players = entry.players;
+    result.winner = entry.winner;
+    for(int i = 0; i < entry.players; ++i){
+        result.roles[i] = entry.role(i);
+        result.strategies[i] = GameResult::NO_STRATEGY;
+    }
+    add(result);
+    return true;
+}
+/**
+ * @brief Queues every game in an archive, straight from its index.
+ * @return Number of games queued.
+ */
+std::size_t RatingEngine::add(const ArchiveReader& archive){
+    std::size_t queued = 0;
+    for(std::size_t i = 0; i < archive.games(); ++i){
+        queued += add(archive.entry(i)) ? 1 : 0;
+    }
+    return queued;
+}
+
+/**
+ * @brief Rates the queued games now, even if the batch is not full.
+ */
+void RatingEngine::flush(){
+    if(_pending.empty()){
+        return;
+    }
+    std::size_t strategies = _strategies.size();
+    std::size_t keys = strategies + ROLE_COUNT;
+    std::vector<double> strength(keys);
+    for(std::size_t k = 0; k < strategies; ++k){
+        strength[k] = std::exp((_strategies.mu(k) - INITIAL_MU) / SCALE);
+    }
+    for(int r = 0; r < ROLE_COUNT; ++r){
+        strength[strategies + r] = std::exp((_roles.mu(r) - INITIAL_MU) / SCALE);
+    }
+
+    std::size_t games = _pending.size();
+    unsigned workers = static_cast<unsigned>(std::min<std::size_t>(_threads, games));
+    std::vector<Sums> sums(workers);
+    std::vector<std::exception_ptr> errors(workers);
+    auto rate = [&](unsigned w){
+        try {
+            Sums& s = sums[w];
+            s.gradient.assign(keys, 0);
+            s.hessian.assign(keys, 0);
+            s.games.assign(keys, 0);
+            int strategy_key[PlayerList::CAPACITY];
+            int role_key[PlayerList::CAPACITY];
+            for(std::size_t g = games * w / workers; g < games * (w + 1) / workers; ++g){
+                const GameResult& r = _pending[g];
+                for(int i = 0; i < r.players; ++i){
+                    strategy_key[i] = r.strategies[i] == GameResult::NO_STRATEGY ? -1 : r.strategies[i];
+                    role_key[i] = static_cast<int>(strategies) + static_cast<int>(r.roles[i]);
+                }
+                double weight = 1.0 / (r.players - 1);
+                accumulate(strategy_key, r.players, r.winner, weight, strength.data(), s.gradient, s.hessian, s.games);
+                accumulate(role_key, r.players, r.winner, weight, strength.data(), s.gradient, s.hessian, s.games);
+            }
+        } catch (...) {
+            errors[w] = std::current_exception();
+        }
+    };
+    std::vector<std::thread> pool;
+    for(unsigned w = 1; w < workers; ++w){
+        pool.emplace_back(rate, w);
+    }
+    rate(0);
+    for(std::thread& t : pool){
+        t.join();
+    }
+    for(std::exception_ptr& e : errors){
+        if(e){
+            std::rethrow_exception(e);
+        }
+    }
+    Sums& total = sums[0];
+    for(unsigned w = 1; w < workers; ++w){
+        for(std::size_t k = 0; k < keys; ++k){
+            total.gradient[k] += sums[w].gradient[k];
+            total.hessian[k] += sums[w].hessian[k];
+            total.games[k] += sums[w].games[k];
+        }
+    }
+    double change = _strategies.update(total.gradient.data(), total.hessian.data(), total.games.data());
+    change = std::max(change, _roles.update(total.gradient.data() + strategies, total.hessian.data() + strategies,
+                                            total.games.data() + strategies));
+    _rated += games;
+    _pending.clear();
+
+    double sigma = 0;
+    for(const RatingTable* table : {&_strategies, &_roles}){
+        for(std::size_t k = 0; k < table->size(); ++k){
+            if(table->games(k) > 0){
+                sigma = std::max(sigma, table->sigma(k));
+            }
+        }
+    }
+    _convergence.push_back({_rated, change, sigma == 0 ? INITIAL_SIGMA : sigma});
+}
@@ -0,0 +1,86 @@
+#ifndef RATING_HPP
+#define RATING_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "Archive.hpp"
+#include "Simulator.hpp"
+
+/**
+ * @brief Ratings of one pool of keys (strategies, or roles), on the Elo scale.
+ * Each key keeps a mean mu and its information (inverse variance); sigma is the standard
+ * error that information implies, so it shrinks as a key plays more rated games.
+ */
+class RatingTable{
+    private:
+        std::vector<double> _mu;
+        std::vector<double> _info;
+        std::vector<std::uint64_t> _games;
+
+    public:
+        explicit RatingTable(std::size_t keys = 0);
+
+        std::size_t size() const { return _mu.size(); }
+        double mu(std::size_t key) const { return _mu[key]; }
+        double sigma(std::size_t key) const;
+        std::uint64_t games(std::size_t key) const { return _games[key]; }     // seats it held in rated games
+        double update(const double* gradient, const double* hessian, const std::uint32_t* games);
+};
+
+/**
+ * @brief Rating change and the largest sigma after one batch, for convergence reports.
+ */
+struct ConvergencePoint{
+    std::uint64_t games;
+    double max_change;
+    double max_sigma;
+};
+
+/**
+ * @brief Streaming multi-player ratings per strategy and per role.
+ * A game is read as its winner beating every other seat, each of those n - 1 results
+ * weighted 1 / (n - 1) (seats sharing the winner's key teach nothing and are skipped);
+ * the win probability of a pair is the Elo logistic curve of their rating difference.
+ * Games queue until a batch is full and are then rated together against the ratings as
+ * they stood at the start of the batch: every key takes one Newton step on the batch's
+ * log-likelihood, scaled by all the information it has gathered so far, like a Kalman
+ * (or TrueSkill) update with a shrinking sigma. Because a batch only reads the old
+ * ratings, its games are split into contiguous ranges, one per thread, each summing into
+ * its own gradient; the sums are added in range order so a given thread count always
+ * gives the same ratings. Unfinished games (no winner) are not rated.
+ */
+class RatingEngine{
+    public:
+        static constexpr double INITIAL_MU = 1500;
+        static constexpr double INITIAL_SIGMA = 350;
+        static constexpr std::size_t DEFAULT_BATCH = 4096;
+
+    private:
+        struct Sums{
+            std::vector<double> gradient;
+            std::vector<double> hessian;
+            std::vector<std::uint32_t> games;
+        };
+        RatingTable _strategies;
+        RatingTable _roles;
+        std::vector<GameResult> _pending;
+        std::vector<ConvergencePoint> _convergence;
+        std::size_t _batch;
+        unsigned _threads;
+        std::uint64_t _rated;
+
+    public:
+        explicit RatingEngine(std::size_t strategies, std::size_t batch = DEFAULT_BATCH, unsigned threads = 1);
+
+        void add(const GameResult& result);
+        bool add(const ArchiveEntry& entry);
+        std::size_t add(const ArchiveReader& archive);
+        void flush();
+
+        const RatingTable& strategies() const { return _strategies; }
+        const RatingTable& roles() const { return _roles; }
+        std::uint64_t rated() const { return _rated; }
+        const std::vector<ConvergencePoint>& convergence() const { return _convergence; }
+};
+#endif
@@ -0,0 +1,149 @@
+#include "Reaction.hpp"
+#include "EventLog.hpp"
+#include <stdexcept>
+
+bool AllowAllPolicy::should_block(Game& game, int blocker, const Reaction& reaction){
+    (void)game; (void)blocker; (void)reaction;
+    return false;
+}
+bool BlockAllPolicy::should_block(Game& game, int blocker, const Reaction& reaction){
+    (void)game; (void)blocker; (void)reaction;
+    return true;
+}
+
+Reaction::Reaction()
+    : _game(nullptr), _action(GameAction::NONE), _actor(-1), _target(-1),
+      _pending(0), _blocked_by(-1)
+{}
+/**
+ * @brief Opens a reaction window for an action that has already been executed.
+ * A coup the targeted General already blocked opens no window.
+ * @param game Game the action was played in.
+ * @param action Action just performed.
+ * @param actor Seat that performed it.
+ * @param target Target seat (coup only), -1 otherwise.
+ */
+Reaction::Reaction(Game& game, GameAction action, int actor, int target)
+    : _game(&game), _action(action), _actor(actor), _target(target),
+      _pending(0), _blocked_by(-1)
+{
+    PlayerList& players = game.get_players();
+    if(actor < 0 || actor >= static_cast<int>(players.size())){
+        throw std::runtime_error("Invalid actor seat");
+    }
+    if(action == GameAction::COUP && players[actor]->get_lastAction() != GameAction::COUP){
+        return;
+    }
+    _pending = game.blockers_for(action, actor);
+}
+bool Reaction::is_open() const{
+    return _pending != 0 && _blocked_by < 0;
+}
+/**
+ * @brief Seat of the blocker whose answer is awaited, or -1 if the window is closed.
+ */
+int Reaction::current_blocker() const{
+    return is_open() ? mask_first(_pending) : -1;
+}
+void Reaction::allow(){
+    if(is_open()){
+        if(EventLog* log = _game->get_log()){
+            log->record_allow(_action, current_blocker());
+        }
+        _pending &= _pending - 1;
+    }
+}
+/**
+ * @brief Current blocker blocks: applies the role's counter effect and closes the window.
+ * General restores the couped target and the turn moves on from the actor,
+ * Governor takes the tax back, Judge cancels the bribe's extra turn.
+ * @throws std::runtime_error if the window is closed, or the blocker's own rules refuse the
+ * block; the blocker is consumed either way, so the window moves on to the next one.
+ */
+void Reaction::block(){
+    if(!is_open()){
+        throw std::runtime_error("No blocker to answer");
+    }
+    int seat = current_blocker();
+    _pending &= _pending - 1;
+    if(EventLog* log = _game->get_log()){
+        log->record_block(_action, seat);
+    }
+
+    PlayerList& players = _game->get_players();
+    Player* blocker = players[seat];
+    Player* actor = players[_actor];
+    switch(_action){
+        case GameAction::COUP:
+            blocker->uniqe(*actor, *players[_target]);
+            _game->set_turn(_actor);
+            _game->turn_manager();
+            break;
+        case GameAction::TAX:
+        case GameAction::BRIBE:
+            blocker->uniqe(*actor);
+            break;
+        default:
+            throw std::runtime_error("Action cannot be blocked");
+    }
+    _blocked_by = seat;
+    _pending = 0;
+}
+/**
+ * @brief Asks every remaining blocker in seat order until one blocks successfully.
+ * @param policy Decides for each blocker.
+ * @return Seat that blocked, or -1 if the action stands.
+ */
+int Reaction::resolve(ReactionPolicy& policy){
+    while(is_open()){
+        if(policy.should_block(*_game, current_blocker(), *this)){
+            try {
+                block();
+            } catch (const std::runtime_error&) {
+                // Failed block is treated as an allow
+            }
+        }
+        else{
+            allow();
+        }
+    }
+    return _blocked_by;
+}
+
+GameAction Reaction::get_action() const{
+    return _action;
+}
+int Reaction::get_actor() const{
+    return _actor;
+}
+int Reaction::get_target() const{
+    return _target;
+}
+/**
+ * @brief Narrows the window to the blockers still owed an answer, e.g. when a window
+ * saved mid-way is reopened; seats not eligible when it opened are ignored.
+ */
+void Reaction::set_pending(SeatMask pending){
+    if(_game){
+        _pending = pending & _game->blockers_for(_action, _actor);
+    }
+}
+SeatMask Reaction::get_pending() const{
+    return _pending;
+}
+int Reaction::get_blockedBy() const{
+    return _blocked_by;
+}
+
+/**
+ * @brief Applies m and, if it opens a reaction window (tax, bribe, coup), resolves it
+ * with policy before returning: what a bot or a simulator does for a whole move.
+ * @return The move's status; a rejected move opens no window.
+ */
+MoveStatus play_move(Game& game, const Move& m, ReactionPolicy& policy){
+    MoveStatus status = game.apply(m);
+    if(status == MoveStatus::OK && Game::blocker_role(m.action) != Role::CITIZEN){
+        Reaction(game, m.action, m.actor, m.target).resolve(policy);
+    }
+    return status;
+}
@@ -0,0 +1,62 @@
+#ifndef REACTION_HPP
+#define REACTION_HPP
+
+#include "../Game.hpp"
+
+class Reaction;
+
+/**
+ * @brief Strategy consulted for every eligible blocker of a reaction window.
+ * Bots, servers and tests implement this; the GUI drives a Reaction step by step instead.
+ */
+class ReactionPolicy{
+    public:
+        virtual ~ReactionPolicy() = default;
+        virtual bool should_block(Game& game, int blocker, const Reaction& reaction) = 0;
+};
+
+class AllowAllPolicy : public ReactionPolicy{
+    public:
+        bool should_block(Game& game, int blocker, const Reaction& reaction) override;
+};
+
+class BlockAllPolicy : public ReactionPolicy{
+    public:
+        bool should_block(Game& game, int blocker, const Reaction& reaction) override;
+};
+
+/**
+ * @brief Reaction window opened after a blockable action (coup, tax, bribe).
+ * Eligible blockers are fixed when the window opens and answered in seat order.
+ * The first successful block closes the window; a block that fails its role rules
+ * (e.g. General short of coins) counts as an allow.
+ */
+class Reaction{
+    private:
+        Game* _game;
+        GameAction _action;
+        int _actor;
+        int _target;
+        SeatMask _pending;
+        int _blocked_by;
+
+    public:
+        Reaction();
+        Reaction(Game& game, GameAction action, int actor, int target = -1);
+
+        bool is_open() const;
+        int current_blocker() const;
+        void allow();
+        void block();
+        int resolve(ReactionPolicy& policy);
+        void set_pending(SeatMask pending);
+
+        GameAction get_action() const;
+        int get_actor() const;
+        int get_target() const;
+        SeatMask get_pending() const;
+        int get_blockedBy() const;
+};
+
+MoveStatus play_move(Game& game, const Move& m, ReactionPolicy& policy);
+#endif
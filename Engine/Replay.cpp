@@ -0,0 +1,116 @@
+#include "Replay.hpp"
+#include "Reaction.hpp"
+#include "../Players/PlayerFactory.hpp"
+#include <stdexcept>
+
+/**
+ * @brief Deletes the game's players and seats the table described by a log header.
+ */
+void Replayer::seat(Game& game, const LogHeader& header){
+    game.clear_players();
+    for(std::size_t i = 0; i < header.roles.size(); ++i){
+        Player* p = PlayerFactory::createPlayer(role_name(header.roles[i]), game, header.names[i]);
+        p->set_coins(header.coins[i]);
+        game.get_players().push_back(p);
+    }
+    game.set_turn(header.turn);
+}
+/**
+ * @brief Overwrites the seated players' state with a snapshot.
+ * @throws std::runtime_error if the snapshot was taken at a different table size.
+ */
+void Replayer::restore(Game& game, const LogSnapshot& snapshot){
+    PlayerList& players = game.get_players();
+    if(snapshot.seats.size() != players.size()){
+        throw std::runtime_error("Snapshot does not match the seated table");
+    }
+    for(std::size_t i = 0; i < players.size(); ++i){
+        const SeatState& s = snapshot.seats[i];
+        players[i]->set_state(s.coins, s.active, s.sanction, s.can_arrest, s.last_arrested, s.last_action);
+    }
+    game.set_turn(snapshot.turn);
+    game.set_isBribe(snapshot.bribe);
+}
+std::size_t Replayer::replay(Game& game, const EventLog& log, std::size_t max_events){
+    EventReader reader(log);
+    return replay(game, reader, max_events);
+}
+/**
+ * @brief Seats the logged table and brings it to the state after max_events events,
+ * starting from the nearest earlier snapshot if there is one.
+ * @return Number of events the rebuilt state covers.
+ * @throws std::runtime_error if the log is malformed or a move is illegal in the rebuilt state.
+ */
+std::size_t Replayer::replay(Game& game, const std::uint8_t* data, std::size_t size, std::size_t max_events){
+    EventReader reader(data, size);
+    return replay(game, reader, max_events);
+}
+/**
+ * @brief As above, from a reader at the start of a log (one made from an EventLog seeks
+ * through its snapshot offsets).
+ */
+std::size_t Replayer::replay(Game& game, EventReader& reader, std::size_t max_events){
+    seat(game, reader.read_header());
+    LogSnapshot snapshot;
+    if(!reader.seek_snapshot(max_events, snapshot)){
+        return apply_events(game, reader, max_events);
+    }
+    restore(game, snapshot);
+    return snapshot.events + apply_events(game, reader, max_events - snapshot.events);
+}
+/**
+ * @brief Re-applies events from the reader's position onto the current state.
+ * Each move is validated against the rebuilt state, so a corrupt log fails loudly.
+ * The game's own log is detached meanwhile so replaying does not log again.
+ */
+std::size_t Replayer::apply_events(Game& game, EventReader& reader, std::size_t max_events){
+    EventLog* saved = game.get_log();
+    game.set_log(nullptr);
+    int seats = static_cast<int>(game.get_players().size());
+    Move last{GameAction::NONE, -1};
+    Reaction reaction;
+    bool reacting = false;
+    std::size_t applied = 0;
+    Event e;
+    try {
+        while(applied < max_events && reader.next(e)){
+            if(e.seat < 0 || e.seat >= seats || e.target >= seats){
+                throw std::runtime_error("Event " + std::to_string(applied) + " has an invalid seat");
+            }
+            if(e.kind == EventKind::MOVE){
+                last = Move{e.action, e.seat, e.target};
+                reacting = false;
+                MoveStatus status = game.validate(last);
+                if(status != MoveStatus::OK){
+                    throw std::runtime_error("Event " + std::to_string(applied) + " is illegal: " + to_string(status));
+                }
+                game.apply_unchecked(last);
+            }
+            else{
+                if(!reacting){
+                    reaction = Reaction(game, last.action, last.actor, last.target);
+                    reacting = true;
+                }
+                while(reaction.is_open() && reaction.current_blocker() != e.seat){
+                    reaction.allow();
+                }
+                if(e.kind == EventKind::BLOCK){
+                    try {
+                        reaction.block();
+                    } catch (const std::runtime_error&) {
+                        // Refused block, same outcome as when it was played
+                    }
+                }
+                else{
+                    reaction.allow();
+                }
+            }
+            applied++;
+        }
+    } catch (...) {
+        game.set_log(saved);
+        throw;
+    }
+    game.set_log(saved);
+    return applied;
+}
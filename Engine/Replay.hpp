@@ -0,0 +1,26 @@
+#ifndef REPLAY_HPP
+#define REPLAY_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include "EventLog.hpp"
+#include "../Game.hpp"
+
+/**
+ * @brief Rebuilds a Game from an event log by seating the logged table and re-applying
+ * every move and block decision in order. When the log carries snapshots, replay
+ * restores the latest one before the requested point and re-applies only the rest.
+ */
+class Replayer{
+    public:
+        static constexpr std::size_t ALL = std::numeric_limits<std::size_t>::max();
+
+        static void seat(Game& game, const LogHeader& header);
+        static void restore(Game& game, const LogSnapshot& snapshot);
+        static std::size_t replay(Game& game, const EventLog& log, std::size_t max_events = ALL);
+        static std::size_t replay(Game& game, const std::uint8_t* data, std::size_t size, std::size_t max_events = ALL);
+        static std::size_t replay(Game& game, EventReader& reader, std::size_t max_events = ALL);
+        static std::size_t apply_events(Game& game, EventReader& reader, std::size_t max_events = ALL);
+};
+#endif
@@ -0,0 +1,99 @@
+#ifndef RNG_HPP
+#define RNG_HPP
+
+#include <cstdint>
+#include <random>
+
+/**
+ * @brief xoshiro256** generator: small, fast and reproducible from a 64-bit seed.
+ * Seeding expands the seed with splitmix64. split() hands out a generator 2^128 draws
+ * ahead and advances this one past it, so each simulator thread can own a stream that
+ * never overlaps another. Satisfies UniformRandomBitGenerator for <algorithm> use.
+ */
+class Rng{
+    private:
+        std::uint64_t _s[4];
+        __extension__ typedef unsigned __int128 wide;
+
+        static std::uint64_t rotl(std::uint64_t x, int k){
+            return (x << k) | (x >> (64 - k));
+        }
+
+    public:
+        using result_type = std::uint64_t;
+
+        explicit Rng(std::uint64_t seed = 0){
+            for(std::uint64_t& s : _s){
+                seed += 0x9e3779b97f4a7c15ULL;
+                std::uint64_t z = seed;
+                z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+                z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+                s = z ^ (z >> 31);
+            }
+        }
+        // Nondeterministic seed for games that do not ask for one
+        static std::uint64_t random_seed(){
+            std::random_device rd;
+            return (static_cast<std::uint64_t>(rd()) << 32) ^ rd();
+        }
+        static constexpr result_type min() { return 0; }
+        static constexpr result_type max() { return ~result_type(0); }
+
+        result_type operator()(){
+            const std::uint64_t result = rotl(_s[1] * 5, 7) * 9;
+            const std::uint64_t t = _s[1] << 17;
+            _s[2] ^= _s[0];
+            _s[3] ^= _s[1];
+            _s[1] ^= _s[2];
+            _s[0] ^= _s[3];
+            _s[2] ^= t;
+            _s[3] = rotl(_s[3], 45);
+            return result;
+        }
+        /**
+         * @brief Uniform value in [0, n) without modulo bias (Lemire's multiply-shift).
+         */
+        std::uint64_t below(std::uint64_t n){
+            wide m = static_cast<wide>((*this)()) * n;
+            std::uint64_t low = static_cast<std::uint64_t>(m);
+            if(low < n){
+                const std::uint64_t threshold = -n % n;
+                while(low < threshold){
+                    m = static_cast<wide>((*this)()) * n;
+                    low = static_cast<std::uint64_t>(m);
+                }
+            }
+            return static_cast<std::uint64_t>(m >> 64);
+        }
+        /**
+         * @brief Advances the state by 2^128 draws.
+         */
+        void jump(){
+            static constexpr std::uint64_t JUMP[] = {
+                0x180ec6d33cfd0abaULL, 0xd5a61266f0c9392cULL, 0xa9582618e03fc9aaULL, 0x39abdc4529b1661cULL};
+            std::uint64_t s[4] = {0, 0, 0, 0};
+            for(std::uint64_t word : JUMP){
+                for(int b = 0; b < 64; ++b){
+                    if(word & (std::uint64_t(1) << b)){
+                        for(int i = 0; i < 4; ++i){
+                            s[i] ^= _s[i];
+                        }
+                    }
+                    (*this)();
+                }
+            }
+            for(int i = 0; i < 4; ++i){
+                _s[i] = s[i];
+            }
+        }
+        /**
+         * @brief Returns a copy of this stream and jumps this one past it.
+         */
+        Rng split(){
+            Rng child = *this;
+            jump();
+            return child;
+        }
+        bool operator==(const Rng& other) const = default;
+};
+#endif
@@ -0,0 +1,143 @@
+#include "Simulator.hpp"
+#include "Deal.hpp"
+#include <algorithm>
+#include <exception>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+
+/**
+ * @brief Seats roles and plays them out, seat i moving as seats[i] chooses and answering
+ * the reaction windows it may block in (after every tax, bribe and coup), as in
+ * TurnFlow::play. A move the game rejects is replaced by the first legal one, and a seat
+ * with none is passed.
+ * @return The result; strategies are left for the caller to fill in.
+ * @throws std::runtime_error if seats and roles differ in size or exceed the table.
+ */
+GameResult play_game(Game& game, std::span<Strategy* const> seats, std::span<const Role> roles, Rng& rng, int max_turns){
+    if(seats.size() != roles.size()){
+        throw std::runtime_error("Every seat needs a strategy");
+    }
+    seat_roles(game, roles);
+    GameResult result;
+    result.players = static_cast<std::uint8_t>(roles.size());
+    for(std::size_t i = 0; i < roles.size(); ++i){
+        result.roles[i] = roles[i];
+    }
+    SeatPolicy policy(seats, rng);
+    int turns = 0;
+    while(turns < max_turns && !game.has_winner()){
+        int passed = game.pass_stuck_turns();
+        if(passed > 0){
+            turns += passed;
+            continue;
+        }
+        int seat = game.get_turn();
+        Move m = seats[seat]->choose(game, seat, rng);
+        if(play_move(game, m, policy) != MoveStatus::OK){
+            if(!game.first_legal_move(seat, m)){
+                break;
+            }
+            play_move(game, m, policy);
+        }
+        turns++;
+    }
+    result.turns = static_cast<std::uint16_t>(turns);
+    result.winner = static_cast<std::int8_t>(game.has_winner() ? game.winner_seat() : -1);
+    return result;
+}
+
+/**
+ * @throws std::runtime_error on an empty lineup, too many strategies or an unknown name.
+ */
+Simulator::Simulator(std::vector<std::string> strategies, std::uint64_t seed)
+    : _strategies(std::move(strategies)), _stream(seed), _cursor(_stream), _played(0)
+{
+    if(_strategies.empty() || _strategies.size() >= GameResult::NO_STRATEGY){
+        throw std::runtime_error("Simulator needs 1-254 strategies");
+    }
+    for(const std::string& name : _strategies){
+        make_strategy(name);
+    }
+}
+
+/**
+ * @brief Plays the next games games at tables of players seats and appends their results
+ * to out, in game order.
+ * @param threads Threads playing them (at least one).
+ * @throws std::runtime_error if players is outside 2..CAPACITY.
+ */
+void Simulator::run(std::size_t games, int players, unsigned threads, std::vector<GameResult>& out){
+    if(players < 2 || players > PlayerList::CAPACITY){
+        throw std::runtime_error("Table size out of range");
+    }
+    std::size_t base = out.size();
+    out.resize(base + games);
+    std::uint64_t end = _played + games;
+    std::uint64_t first = _played / STREAM_GAMES;
+    std::uint64_t blocks = games == 0 ? 0 : (end - 1) / STREAM_GAMES - first + 1;
+    unsigned workers = threads == 0 ? 1 : threads;
+    if(workers > blocks){
+        workers = blocks == 0 ? 1 : static_cast<unsigned>(blocks);
+    }
+    Rng last_stream = _stream;
+    Rng last_cursor = _cursor;
+    std::vector<std::exception_ptr> errors(workers);
+    auto play = [&](unsigned w){
+        try {
+            Game game;
+            std::vector<std::unique_ptr<Strategy>> owned;
+            for(const std::string& name : _strategies){
+                owned.push_back(make_strategy(name));
+            }
+            Strategy* seats[PlayerList::CAPACITY];
+            std::uint64_t b = blocks * w / workers;
+            Rng stream = _stream;
+            for(std::uint64_t k = 0; k < b; ++k){
+                stream.jump();
+            }
+            for(; b < blocks * (w + 1) / workers; ++b){
+                Rng rng = b == 0 ? _cursor : stream;
+                std::uint64_t to = std::min(end, (first + b + 1) * STREAM_GAMES);
+                for(std::uint64_t g = std::max(_played, (first + b) * STREAM_GAMES); g < to; ++g){
+                    std::uint8_t lineup[PlayerList::CAPACITY];
+                    for(int s = 0; s < players; ++s){
+                        lineup[s] = static_cast<std::uint8_t>(rng.below(_strategies.size()));
+                        seats[s] = owned[lineup[s]].get();
+                    }
+                    std::vector<Role> roles = deal_roles(rng, players);
+                    GameResult& r = out[base + (g - _played)];
+                    r = play_game(game, std::span<Strategy* const>(seats, players), roles, rng);
+                    std::copy(lineup, lineup + players, r.strategies);
+                }
+                if(b + 1 == blocks){
+                    if(to % STREAM_GAMES == 0){
+                        stream.jump();
+                        rng = stream;
+                    }
+                    last_stream = stream;
+                    last_cursor = rng;
+                }
+                stream.jump();
+            }
+        } catch (...) {
+            errors[w] = std::current_exception();
+        }
+    };
+    std::vector<std::thread> pool;
+    for(unsigned w = 1; w < workers; ++w){
+        pool.emplace_back(play, w);
+    }
+    play(0);
+    for(std::thread& t : pool){
+        t.join();
+    }
+    _played = end;
+    _stream = last_stream;
+    _cursor = last_cursor;
+    for(std::exception_ptr& e : errors){
+        if(e){
+            std::rethrow_exception(e);
+        }
+    }
+}
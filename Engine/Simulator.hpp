@@ -0,0 +1,56 @@
+#ifndef SIMULATOR_HPP
+#define SIMULATOR_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <vector>
+#include "Rng.hpp"
+#include "Strategy.hpp"
+#include "../Game.hpp"
+
+/**
+ * @brief Who sat where and who won: what rating and tournament code needs from a game.
+ */
+struct GameResult{
+    static constexpr std::uint8_t NO_STRATEGY = 0xff;     // archived games do not record bots
+
+    std::uint8_t players = 0;
+    std::int8_t winner = -1;            // seat, -1 if the game hit the turn cap
+    std::uint16_t turns = 0;
+    Role roles[PlayerList::CAPACITY] = {};
+    std::uint8_t strategies[PlayerList::CAPACITY] = {};
+};
+
+constexpr int MAX_SIMULATED_TURNS = 1000;
+
+GameResult play_game(Game& game, std::span<Strategy* const> seats, std::span<const Role> roles, Rng& rng,
+                     int max_turns = MAX_SIMULATED_TURNS);
+
+/**
+ * @brief Plays self-play games between named strategies on a pool of threads.
+ * Games are numbered from the first run(); block b of STREAM_GAMES games draws its
+ * lineups, deals and moves from the seed's stream jumped b times (Rng::jump), one game
+ * after the other. Blocks never share a sequence and a block is always played by one
+ * thread, so the results are the same for any thread count, and since the stream of a
+ * block left half played is kept, a long run can be cut into calls to run() without
+ * changing it.
+ */
+class Simulator{
+    private:
+        std::vector<std::string> _strategies;
+        Rng _stream;                // stream of the block holding game _played, unused
+        Rng _cursor;                // the same, past the games of it already played
+        std::uint64_t _played;
+
+    public:
+        static constexpr std::uint64_t STREAM_GAMES = 64;
+
+        Simulator(std::vector<std::string> strategies, std::uint64_t seed);
+
+        void run(std::size_t games, int players, unsigned threads, std::vector<GameResult>& out);
+        const std::vector<std::string>& strategies() const { return _strategies; }
+        std::uint64_t played() const { return _played; }
+};
+#endif
@@ -0,0 +1,122 @@
+#include "Snapshot.hpp"
+#include "../Players/PlayerFactory.hpp"
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+namespace {
+const char MAGIC[4] = {'C', 'P', 'S', 'N'};
+constexpr int LAST_ACTION = static_cast<int>(GameAction::UNIQE);
+}
+
+std::size_t Snapshot::size(Game& game){
+    return sizeof(SnapshotHeader) + game.get_players().size() * sizeof(SeatRecord);
+}
+/**
+ * @brief Writes the game into a caller-provided buffer.
+ * @return Bytes written (always size(game)).
+ * @throws std::runtime_error if the buffer is too small or a name does not fit a SeatRecord.
+ */
+std::size_t Snapshot::save(Game& game, std::uint8_t* out, std::size_t capacity){
+    std::size_t total = size(game);
+    if(capacity < total){
+        throw std::runtime_error("Snapshot buffer too small");
+    }
+    PlayerList& players = game.get_players();
+    SnapshotHeader header{};
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = VERSION;
+    header.seats = static_cast<std::uint8_t>(players.size());
+    header.bribe = game.get_isBribe() ? 1 : 0;
+    header.turn = game.get_turn();
+    std::memcpy(out, &header, sizeof(header));
+
+    std::uint8_t* pos = out + sizeof(header);
+    for(std::size_t i = 0; i < players.size(); ++i){
+        int seat = static_cast<int>(i);
+        SeatMask bit = seat_bit(seat);
+        Player* p = players[i];
+        std::string name = p->get_name();
+        if(name.size() > SeatRecord::NAME_CAPACITY){
+            throw std::runtime_error("Player name too long for a snapshot: " + name);
+        }
+        SeatRecord r{};
+        r.coins = players.coins(seat);
+        r.role = static_cast<std::uint8_t>(players.role(seat));
+        r.flags = static_cast<std::uint8_t>(((players.active_mask() & bit) ? 1 : 0) |
+                                            ((players.sanction_mask() & bit) ? 2 : 0) |
+                                            ((players.can_arrest_mask() & bit) ? 4 : 0) |
+                                            ((players.arrested_mask() & bit) ? 8 : 0));
+        r.last_action = static_cast<std::uint8_t>(p->get_lastAction());
+        r.name_length = static_cast<std::uint8_t>(name.size());
+        std::memcpy(r.name, name.data(), name.size());
+        std::memcpy(pos, &r, sizeof(r));
+        pos += sizeof(r);
+    }
+    return total;
+}
+std::vector<std::uint8_t> Snapshot::save(Game& game){
+    std::vector<std::uint8_t> bytes(size(game));
+    save(game, bytes.data(), bytes.size());
+    return bytes;
+}
+/**
+ * @brief Restores a game from a blob. The whole blob is checked before the game is touched.
+ * @throws std::runtime_error on a bad magic, unknown version, wrong size or out-of-range field.
+ */
+void Snapshot::load(Game& game, const std::uint8_t* data, std::size_t size){
+    SnapshotHeader header;
+    if(size < sizeof(header)){
+        throw std::runtime_error("Truncated snapshot");
+    }
+    std::memcpy(&header, data, sizeof(header));
+    if(std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0){
+        throw std::runtime_error("Not a game snapshot");
+    }
+    if(header.version != VERSION){
+        throw std::runtime_error("Unsupported snapshot version " + std::to_string(header.version));
+    }
+    if(header.seats > PlayerList::CAPACITY){
+        throw std::runtime_error("Snapshot has more seats than COUP_MAX_PLAYERS");
+    }
+    if(size != sizeof(header) + header.seats * sizeof(SeatRecord)){
+        throw std::runtime_error("Snapshot size does not match its seat count");
+    }
+    if(header.bribe > 1 || header.turn < 0 || (header.seats > 0 && header.turn >= header.seats)){
+        throw std::runtime_error("Corrupt snapshot header");
+    }
+    std::size_t seats = header.seats;
+    SeatRecord records[PlayerList::CAPACITY];
+    std::memcpy(records, data + sizeof(header), seats * sizeof(SeatRecord));
+    for(std::size_t i = 0; i < seats; ++i){
+        const SeatRecord& r = records[i];
+        if(r.coins < 0 || r.role >= ROLE_COUNT || r.flags > 15 || r.last_action > LAST_ACTION ||
+           r.name_length > SeatRecord::NAME_CAPACITY){
+            throw std::runtime_error("Corrupt snapshot seat");
+        }
+    }
+
+    PlayerList& players = game.get_players();
+    bool same_table = players.size() == seats;
+    for(std::size_t i = 0; same_table && i < seats; ++i){
+        const SeatRecord& r = records[i];
+        same_table = players.role(static_cast<int>(i)) == static_cast<Role>(r.role) &&
+                     players[i]->get_name() == std::string_view(r.name, r.name_length);
+    }
+    if(!same_table){
+        game.clear_players();
+        for(std::size_t i = 0; i < seats; ++i){
+            const SeatRecord& r = records[i];
+            Role role = static_cast<Role>(r.role);
+            players.push_back(PlayerFactory::createPlayer(role_name(role), game, std::string(r.name, r.name_length)));
+        }
+    }
+    for(std::size_t i = 0; i < seats; ++i){
+        const SeatRecord& r = records[i];
+        players[i]->set_state(r.coins, r.flags & 1, r.flags & 2, r.flags & 4, r.flags & 8,
+                              static_cast<GameAction>(r.last_action));
+    }
+    game.set_turn(header.turn);
+    game.set_isBribe(header.bribe != 0);
+}
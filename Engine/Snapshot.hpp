@@ -0,0 +1,52 @@
+#ifndef SNAPSHOT_HPP
+#define SNAPSHOT_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "../Game.hpp"
+
+/**
+ * @brief Blob header (16 bytes). Multi-byte fields are stored in host (little-endian) order.
+ */
+struct SnapshotHeader{
+    char magic[4];
+    std::uint16_t version;
+    std::uint8_t seats;
+    std::uint8_t bribe;
+    std::int32_t turn;
+    std::uint32_t reserved;
+};
+static_assert(sizeof(SnapshotHeader) == 16, "SnapshotHeader is an on-disk layout");
+
+/**
+ * @brief One seat (32 bytes): role, coins, status bits, last action and name.
+ */
+struct SeatRecord{
+    static constexpr std::size_t NAME_CAPACITY = 24;
+
+    std::int32_t coins;
+    std::uint8_t role;
+    std::uint8_t flags;      // 1 active, 2 sanctioned, 4 can arrest, 8 last arrested
+    std::uint8_t last_action;
+    std::uint8_t name_length;
+    char name[NAME_CAPACITY];
+};
+static_assert(sizeof(SeatRecord) == 32, "SeatRecord is an on-disk layout");
+
+/**
+ * @brief Versioned, fixed-layout binary image of a Game and its players:
+ * a SnapshotHeader followed by one SeatRecord per seat, 16 + 32 * seats bytes in total.
+ * Loading onto a table with the same roles and names overwrites the players in place;
+ * otherwise the table is reseated.
+ */
+class Snapshot{
+    public:
+        static constexpr std::uint16_t VERSION = 1;
+
+        static std::size_t size(Game& game);
+        static std::size_t save(Game& game, std::uint8_t* out, std::size_t capacity);
+        static std::vector<std::uint8_t> save(Game& game);
+        static void load(Game& game, const std::uint8_t* data, std::size_t size);
+};
+#endif
@@ -0,0 +1,111 @@
+#include "Strategy.hpp"
+#include "Cfr.hpp"
+#include "Mcts.hpp"
+#include <stdexcept>
+
+/**
+ * @brief Lists every legal move that ends seat's turn: gather, tax and bribe, then arrest,
+ * sanction and coup against each active opponent. Abilities that leave the turn open
+ * (Baron's invest, Spy's reveal) are left out, so any choice moves the game on.
+ * @return Number of moves written to out (which is cleared first).
+ */
+std::size_t legal_moves(Game& game, int seat, std::vector<Move>& out){
+    out.clear();
+    for(GameAction a : {GameAction::GATHER, GameAction::TAX, GameAction::BRIBE}){
+        if(game.validate({a, seat}) == MoveStatus::OK){
+            out.push_back({a, seat});
+        }
+    }
+    for(SeatMask targets = game.get_players().active_mask() & ~seat_bit(seat); targets; targets &= targets - 1){
+        int t = mask_first(targets);
+        for(GameAction a : {GameAction::ARREST, GameAction::SANCTION, GameAction::COUP}){
+            if(game.validate({a, seat, t}) == MoveStatus::OK){
+                out.push_back({a, seat, t});
+            }
+        }
+    }
+    return out.size();
+}
+
+bool Strategy::should_block(Game&, int, const Reaction&, Rng&){
+    return true;
+}
+bool SeatPolicy::should_block(Game& game, int blocker, const Reaction& reaction){
+    return _seats[blocker]->should_block(game, blocker, reaction, _rng);
+}
+
+Move RandomStrategy::choose(Game& game, int seat, Rng& rng){
+    if(legal_moves(game, seat, _moves) == 0){
+        return Move{GameAction::NONE, seat};
+    }
+    return _moves[rng.below(_moves.size())];
+}
+
+/**
+ * @brief Blocks or lets the action stand with even odds.
+ */
+bool RandomStrategy::should_block(Game&, int, const Reaction&, Rng& rng){
+    return rng.below(2) == 0;
+}
+
+Move GreedyStrategy::choose(Game& game, int seat, Rng&){
+    int n = static_cast<int>(game.get_players().size());
+    for(int k = 1; k < n; ++k){
+        Move coup{GameAction::COUP, seat, (seat + k) % n};
+        if(game.validate(coup) == MoveStatus::OK){
+            return coup;
+        }
+    }
+    for(GameAction a : {GameAction::TAX, GameAction::GATHER}){
+        if(game.validate({a, seat}) == MoveStatus::OK){
+            return Move{a, seat};
+        }
+    }
+    for(int k = 1; k < n; ++k){
+        Move arrest{GameAction::ARREST, seat, (seat + k) % n};
+        if(game.validate(arrest) == MoveStatus::OK){
+            return arrest;
+        }
+    }
+    Move any{GameAction::NONE, seat};
+    game.first_legal_move(seat, any);
+    return any;
+}
+
+bool PassiveStrategy::should_block(Game&, int, const Reaction&, Rng&){
+    return false;
+}
+
+/**
+ * @brief Creates a strategy by name: "random", "greedy", "passive", "mcts" or "mcts:ITERATIONS",
+ * and "cfr" (the default table) or "cfr:PATH" (a table saved by CfrTable::save).
+ * @throws std::runtime_error on an unknown name or a table that cannot be loaded.
+ */
+std::unique_ptr<Strategy> make_strategy(const std::string& name){
+    if(name == "random"){
+        return std::make_unique<RandomStrategy>();
+    }
+    if(name == "greedy"){
+        return std::make_unique<GreedyStrategy>();
+    }
+    if(name == "passive"){
+        return std::make_unique<PassiveStrategy>();
+    }
+    if(name == "mcts"){
+        return std::make_unique<MctsStrategy>();
+    }
+    if(name.rfind("mcts:", 0) == 0){
+        try {
+            return std::make_unique<MctsStrategy>(std::stoi(name.substr(5)));
+        } catch (const std::logic_error&) {
+            throw std::runtime_error("Bad MCTS iteration count: " + name);
+        }
+    }
+    if(name == "cfr"){
+        return std::make_unique<CfrStrategy>(default_cfr_table());
+    }
+    if(name.rfind("cfr:", 0) == 0){
+        return std::make_unique<CfrStrategy>(std::make_shared<const CfrTable>(CfrTable::load(name.substr(4))));
+    }
+    throw std::runtime_error("Unknown strategy: " + name);
+}
@@ -0,0 +1,72 @@
+#ifndef STRATEGY_HPP
+#define STRATEGY_HPP
+
+#include <memory>
+#include <span>
+#include <string>
+#include <vector>
+#include "Reaction.hpp"
+#include "Rng.hpp"
+#include "../Game.hpp"
+
+/**
+ * @brief A bot: picks the move for the seat whose turn it is, and answers the reaction
+ * windows its seat is eligible to block in.
+ * Simulators create one instance per thread, so implementations may keep scratch state
+ * but never share it. choose() may try moves on the game but must leave it as found.
+ * By default every eligible block is made.
+ */
+class Strategy{
+    public:
+        virtual ~Strategy() = default;
+        virtual const char* name() const = 0;
+        virtual Move choose(Game& game, int seat, Rng& rng) = 0;
+        virtual bool should_block(Game& game, int blocker, const Reaction& reaction, Rng& rng);
+};
+
+/**
+ * @brief Answers a reaction window for every seat of a table, each by its own strategy.
+ */
+class SeatPolicy : public ReactionPolicy{
+    private:
+        std::span<Strategy* const> _seats;
+        Rng& _rng;
+    public:
+        SeatPolicy(std::span<Strategy* const> seats, Rng& rng) : _seats(seats), _rng(rng) {}
+        bool should_block(Game& game, int blocker, const Reaction& reaction) override;
+};
+
+/**
+ * @brief Uniform over the legal moves; blocks half the time.
+ */
+class RandomStrategy : public Strategy{
+    private:
+        std::vector<Move> _moves;
+    public:
+        const char* name() const override { return "random"; }
+        Move choose(Game& game, int seat, Rng& rng) override;
+        bool should_block(Game& game, int blocker, const Reaction& reaction, Rng& rng) override;
+};
+
+/**
+ * @brief Coup the next opponent when possible, otherwise tax, gather or arrest, in that
+ * order (the benchmarks' fixed policy).
+ */
+class GreedyStrategy : public Strategy{
+    public:
+        const char* name() const override { return "greedy"; }
+        Move choose(Game& game, int seat, Rng& rng) override;
+};
+
+/**
+ * @brief Greedy's moves, but never blocks: the baseline for what blocking is worth.
+ */
+class PassiveStrategy : public GreedyStrategy{
+    public:
+        const char* name() const override { return "passive"; }
+        bool should_block(Game& game, int blocker, const Reaction& reaction, Rng& rng) override;
+};
+
+std::size_t legal_moves(Game& game, int seat, std::vector<Move>& out);
+std::unique_ptr<Strategy> make_strategy(const std::string& name);
+#endif
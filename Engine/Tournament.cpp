@@ -0,0 +1,172 @@
+#include "Tournament.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <exception>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+
+namespace {
+constexpr double Z = 1.959963984540054;      // two-sided 95%
+constexpr int DEALT_ROLES = ROLE_COUNT - 1;   // every role but CITIZEN
+}
+
+double Tally::rate() const{
+    return games == 0 ? 0 : score / games;
+}
+double Tally::low() const{
+    if(games == 0){
+        return 0;
+    }
+    double n = static_cast<double>(games), p = rate();
+    double centre = (p + Z * Z / (2 * n)) / (1 + Z * Z / n);
+    double half = Z * std::sqrt(p * (1 - p) / n + Z * Z / (4 * n * n)) / (1 + Z * Z / n);
+    return std::max(0.0, centre - half);
+}
+double Tally::high() const{
+    if(games == 0){
+        return 1;
+    }
+    double n = static_cast<double>(games), p = rate();
+    double centre = (p + Z * Z / (2 * n)) / (1 + Z * Z / n);
+    double half = Z * std::sqrt(p * (1 - p) / n + Z * Z / (4 * n * n)) / (1 + Z * Z / n);
+    return std::min(1.0, centre + half);
+}
+
+TournamentResult& TournamentResult::operator+=(const TournamentResult& other){
+    for(std::size_t i = 0; i < versus.size(); ++i){
+        versus[i] += other.versus[i];
+    }
+    for(std::size_t i = 0; i < roles.size(); ++i){
+        roles[i] += other.roles[i];
+    }
+    for(std::size_t i = 0; i < seats.size(); ++i){
+        seats[i] += other.seats[i];
+    }
+    games += other.games;
+    unfinished += other.unfinished;
+    return *this;
+}
+
+/**
+ * @throws std::runtime_error on fewer than two strategies, an unknown one, or a table
+ * size outside 2..CAPACITY (or too large to enumerate, over 12 seats).
+ */
+Tournament::Tournament(std::vector<std::string> strategies, int players, std::size_t rounds, std::uint64_t seed)
+    : _strategies(std::move(strategies)), _players(players), _rounds(rounds), _seed(seed), _deals(1)
+{
+    if(_strategies.size() < 2){
+        throw std::runtime_error("A tournament needs at least two strategies");
+    }
+    if(players < 2 || players > PlayerList::CAPACITY || players > 12){
+        throw std::runtime_error("Table size out of range");
+    }
+    for(const std::string& name : _strategies){
+        make_strategy(name);
+    }
+    for(int i = 0; i < static_cast<int>(_strategies.size()); ++i){
+        for(int j = i + 1; j < static_cast<int>(_strategies.size()); ++j){
+            _pairs.emplace_back(i, j);
+        }
+    }
+    for(unsigned mask = 1; mask + 1 < (1u << players); ++mask){
+        _seatings.push_back(mask);
+    }
+    for(int s = 0; s < players; ++s){
+        _deals *= DEALT_ROLES;
+    }
+}
+
+std::uint64_t Tournament::games() const{
+    return _rounds * _pairs.size() * _seatings.size() * _deals;
+}
+
+/**
+ * @brief Plays the whole schedule.
+ * @param threads Threads playing it (at least one).
+ */
+TournamentResult Tournament::run(unsigned threads) const{
+    std::size_t k = _strategies.size();
+    TournamentResult empty;
+    empty.strategies = k;
+    empty.players = _players;
+    empty.versus.resize(k * k);
+    empty.roles.resize(k * ROLE_COUNT);
+    empty.seats.resize(k * _players);
+
+    std::uint64_t total = games();
+    unsigned workers = threads == 0 ? 1 : threads;
+    std::vector<TournamentResult> partial(workers, empty);
+    std::vector<std::exception_ptr> errors(workers);
+    std::atomic<std::uint64_t> next{0};
+    auto play = [&](unsigned w){
+        try {
+            Game game;
+            std::vector<std::unique_ptr<Strategy>> owned;
+            for(const std::string& name : _strategies){
+                owned.push_back(make_strategy(name));
+            }
+            TournamentResult& out = partial[w];
+            Strategy* seats[PlayerList::CAPACITY];
+            int side_of[PlayerList::CAPACITY];
+            std::vector<Role> roles(_players);
+            Rng stream(_seed);
+            std::uint64_t at = 0;                   // chunk stream is positioned on
+            for(std::uint64_t begin; (begin = next.fetch_add(CHUNK, std::memory_order_relaxed)) < total;){
+                for(; at < begin / CHUNK; ++at){
+                    stream.jump();
+                }
+                Rng rng = stream;
+                for(std::uint64_t g = begin; g < begin + CHUNK && g < total; ++g){
+                    std::uint64_t rest = g;
+                    std::uint64_t deal = rest % _deals;
+                    rest /= _deals;
+                    unsigned mask = _seatings[rest % _seatings.size()];
+                    rest /= _seatings.size();
+                    auto [a, b] = _pairs[rest % _pairs.size()];
+                    int strategy[2] = {a, b};
+                    for(int s = 0; s < _players; ++s){
+                        side_of[s] = (mask >> s) & 1;
+                        seats[s] = owned[strategy[side_of[s]]].get();
+                        roles[s] = static_cast<Role>(1 + deal % DEALT_ROLES);
+                        deal /= DEALT_ROLES;
+                    }
+                    GameResult r = play_game(game, std::span<Strategy* const>(seats, _players), roles, rng);
+                    double side_score[2] = {0, 0};
+                    for(int s = 0; s < _players; ++s){
+                        double points = r.winner < 0 ? 1.0 / _players : s == r.winner ? 1.0 : 0.0;
+                        int x = strategy[side_of[s]];
+                        side_score[side_of[s]] += points;
+                        out.roles[x * ROLE_COUNT + static_cast<int>(roles[s])].add(points);
+                        out.seats[x * _players + s].add(points);
+                    }
+                    out.versus[a * k + b].add(side_score[0]);
+                    out.versus[b * k + a].add(side_score[1]);
+                    out.games++;
+                    out.unfinished += r.winner < 0 ? 1 : 0;
+                }
+            }
+        } catch (...) {
+            errors[w] = std::current_exception();
+            next.store(total, std::memory_order_relaxed);
+        }
+    };
+    std::vector<std::thread> pool;
+    for(unsigned w = 1; w < workers; ++w){
+        pool.emplace_back(play, w);
+    }
+    play(0);
+    for(std::thread& t : pool){
+        t.join();
+    }
+    for(std::exception_ptr& e : errors){
+        if(e){
+            std::rethrow_exception(e);
+        }
+    }
+    for(unsigned w = 1; w < workers; ++w){
+        partial[0] += partial[w];
+    }
+    return partial[0];
+}
@@ -0,0 +1,70 @@
+#ifndef TOURNAMENT_HPP
+#define TOURNAMENT_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "Simulator.hpp"
+
+/**
+ * @brief Points scored over a number of games, as a win rate with a 95% Wilson interval.
+ */
+struct Tally{
+    double score = 0;
+    std::uint64_t games = 0;
+
+    void add(double points){ score += points; games++; }
+    Tally& operator+=(const Tally& other){ score += other.score; games += other.games; return *this; }
+    double rate() const;
+    double low() const;
+    double high() const;
+};
+
+/**
+ * @brief Win rates of a tournament, by opponent, by role held and by seat.
+ */
+struct TournamentResult{
+    std::size_t strategies = 0;
+    int players = 0;
+    std::vector<Tally> versus;          // [i * strategies + j]: i's seats in games against j
+    std::vector<Tally> roles;           // [i * ROLE_COUNT + role]: i's seats holding role
+    std::vector<Tally> seats;           // [i * players + seat]: i in that seat
+    std::uint64_t games = 0;
+    std::uint64_t unfinished = 0;
+
+    const Tally& against(std::size_t i, std::size_t j) const { return versus[i * strategies + j]; }
+    TournamentResult& operator+=(const TournamentResult& other);
+};
+
+/**
+ * @brief Round-robin between strategies: every pair meets at tables of players seats in
+ * every seating (each seat given to one side or the other, both sides present) and with
+ * every dealing of the six roles to the seats, rounds times over.
+ * A won game scores 1 for the winner's seat and side; a game that hits the turn cap is
+ * shared, each seat scoring 1 / players. Games are numbered in schedule order; chunk c of
+ * CHUNK games draws from the seed's stream jumped c times (Rng::jump), so no two chunks
+ * share a sequence and every game plays out the same for any thread count. Threads take
+ * chunks from a shared counter in increasing order, jumping their generator forward to
+ * each, and tally them on their own.
+ */
+class Tournament{
+    private:
+        std::vector<std::string> _strategies;
+        int _players;
+        std::size_t _rounds;
+        std::uint64_t _seed;
+        std::vector<std::pair<int, int>> _pairs;
+        std::vector<unsigned> _seatings;       // bit s set: seat s plays the pair's second strategy
+        std::uint64_t _deals;
+
+    public:
+        static constexpr std::uint64_t CHUNK = 64;
+
+        Tournament(std::vector<std::string> strategies, int players = 2, std::size_t rounds = 1, std::uint64_t seed = 1);
+
+        std::uint64_t games() const;
+        TournamentResult run(unsigned threads) const;
+        const std::vector<std::string>& strategies() const { return _strategies; }
+};
+#endif
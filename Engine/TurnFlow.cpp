@@ -0,0 +1,168 @@
+#include "TurnFlow.hpp"
+#include <atomic>
+#include <new>
+#include <stdexcept>
+#include <utility>
+
+namespace {
+std::atomic<std::size_t> last_frame{0};       // flows may start on several threads
+
+bool blockable(GameAction action){
+    return action == GameAction::TAX || action == GameAction::BRIBE || action == GameAction::COUP;
+}
+}
+
+/**
+ * @brief Hands the coroutine its own promise without suspending.
+ */
+struct TurnFlow::Self{
+    promise_type* promise = nullptr;
+
+    bool await_ready() const noexcept { return false; }
+    bool await_suspend(Handle h) noexcept { promise = &h.promise(); return false; }
+    promise_type& await_resume() const noexcept { return *promise; }
+};
+/**
+ * @brief Parks the coroutine until submit() hands it a move.
+ */
+struct TurnFlow::NextMove{
+    promise_type* promise = nullptr;
+
+    bool await_ready() const noexcept { return false; }
+    void await_suspend(Handle h) noexcept { promise = &h.promise(); promise->waiting = Waiting::MOVE; }
+    Move await_resume() const noexcept { return promise->move; }
+};
+/**
+ * @brief Parks the coroutine until answer() hands it the current blocker's choice.
+ */
+struct TurnFlow::NextAnswer{
+    promise_type* promise = nullptr;
+
+    bool await_ready() const noexcept { return false; }
+    void await_suspend(Handle h) noexcept { promise = &h.promise(); promise->waiting = Waiting::ANSWER; }
+    bool await_resume() const noexcept { return promise->block; }
+};
+
+TurnFlow TurnFlow::promise_type::get_return_object(){
+    return TurnFlow(Handle::from_promise(*this));
+}
+void* TurnFlow::promise_type::operator new(std::size_t size){
+    last_frame.store(size, std::memory_order_relaxed);
+    return ::operator new(size);
+}
+void TurnFlow::promise_type::operator delete(void* frame, std::size_t size) noexcept{
+    ::operator delete(frame, size);
+}
+
+TurnFlow::TurnFlow(TurnFlow&& other) noexcept : _handle(std::exchange(other._handle, nullptr)) {}
+TurnFlow& TurnFlow::operator=(TurnFlow&& other) noexcept{
+    if(this != &other){
+        if(_handle){
+            _handle.destroy();
+        }
+        _handle = std::exchange(other._handle, nullptr);
+    }
+    return *this;
+}
+TurnFlow::~TurnFlow(){
+    if(_handle){
+        _handle.destroy();
+    }
+}
+/**
+ * @brief The turn loop. Runs until the first input it needs before returning to the caller.
+ * Turns nobody can play are passed (Game::pass_stuck_turns); an illegal move leaves the
+ * same seat to move again; a blockable move opens a Reaction and waits on its blockers.
+ * @param open A window already open when the flow starts (a restored match), answered first.
+ */
+TurnFlow TurnFlow::play(Game& game, Reaction open){
+    promise_type& self = co_await Self{};
+    self.game = &game;
+    self.reaction = open;
+    while(true){
+        while(self.reaction.is_open()){
+            if(co_await NextAnswer{}){
+                try {
+                    self.reaction.block();
+                } catch (const std::runtime_error&) {
+                    // Block refused by its role rules: counts as an allow
+                }
+            }
+            else{
+                self.reaction.allow();
+            }
+        }
+        if(game.has_winner()){
+            break;
+        }
+        game.pass_stuck_turns();
+        Move m = co_await NextMove{};
+        self.status = game.apply(m);
+        if(self.status == MoveStatus::OK && blockable(m.action)){
+            self.reaction = Reaction(game, m.action, m.actor, m.target);
+        }
+    }
+}
+/**
+ * @brief Size in bytes of the most recently allocated turn-flow frame.
+ */
+std::size_t TurnFlow::frame_bytes(){
+    return last_frame.load(std::memory_order_relaxed);
+}
+void TurnFlow::resume(){
+    _handle.promise().waiting = Waiting::NOTHING;
+    _handle.resume();
+    if(std::exception_ptr error = std::exchange(_handle.promise().error, nullptr)){
+        std::rethrow_exception(error);
+    }
+}
+TurnFlow::Waiting TurnFlow::waiting() const{
+    return _handle ? _handle.promise().waiting : Waiting::NOTHING;
+}
+/**
+ * @brief Seat the flow is waiting on: the mover, the pending blocker, or -1.
+ */
+int TurnFlow::seat() const{
+    switch(waiting()){
+        case Waiting::MOVE:
+            return _handle.promise().game->get_turn();
+        case Waiting::ANSWER:
+            return _handle.promise().reaction.current_blocker();
+        default:
+            return -1;
+    }
+}
+/**
+ * @brief Plays the move the flow is waiting on and runs to its next input.
+ * @return The move's MoveStatus; on anything but OK the same seat is asked again.
+ * @throws std::runtime_error if the flow is not waiting on a move.
+ */
+MoveStatus TurnFlow::submit(const Move& m){
+    if(waiting() != Waiting::MOVE){
+        throw std::runtime_error("Turn flow is not waiting on a move");
+    }
+    _handle.promise().move = m;
+    resume();
+    return _handle.promise().status;
+}
+/**
+ * @brief Answers for the pending blocker (seat()) and runs to the next input.
+ * @throws std::runtime_error if no reaction window is waiting on an answer.
+ */
+void TurnFlow::answer(bool block){
+    if(waiting() != Waiting::ANSWER){
+        throw std::runtime_error("Turn flow is not waiting on an answer");
+    }
+    _handle.promise().block = block;
+    resume();
+}
+/**
+ * @brief The last reaction window opened; closed between windows.
+ */
+const Reaction& TurnFlow::reaction() const{
+    static const Reaction closed;
+    return _handle ? _handle.promise().reaction : closed;
+}
+bool TurnFlow::done() const{
+    return _handle && _handle.done();
+}
@@ -0,0 +1,74 @@
+#ifndef TURNFLOW_HPP
+#define TURNFLOW_HPP
+
+#include <coroutine>
+#include <cstddef>
+#include <exception>
+#include "../Game.hpp"
+#include "Reaction.hpp"
+
+/**
+ * @brief A whole game's turn order written as one C++20 coroutine: each turn co_awaits the
+ * mover's move, applies it, then co_awaits each eligible blocker's answer in seat order.
+ * The coroutine suspends whenever it needs input, so a parked match is only its frame
+ * (a few hundred bytes, see frame_bytes()) and needs no thread; whoever holds the
+ * TurnFlow resumes it by submitting the input it is waiting for.
+ * Move-only; destroying it destroys the frame. The Game must outlive it.
+ */
+class TurnFlow{
+    public:
+        enum class Waiting{
+            NOTHING,                           // not started, or the game has a winner
+            MOVE,
+            ANSWER,
+        };
+
+        struct promise_type{
+            Game* game = nullptr;
+            Waiting waiting = Waiting::NOTHING;
+            Move move{GameAction::NONE, -1};
+            bool block = false;
+            MoveStatus status = MoveStatus::OK;
+            Reaction reaction;
+            std::exception_ptr error;
+
+            TurnFlow get_return_object();
+            std::suspend_never initial_suspend() noexcept { return {}; }
+            std::suspend_always final_suspend() noexcept { waiting = Waiting::NOTHING; return {}; }
+            void return_void() {}
+            void unhandled_exception() { error = std::current_exception(); }
+
+            static void* operator new(std::size_t size);
+            static void operator delete(void* frame, std::size_t size) noexcept;
+        };
+
+    private:
+        using Handle = std::coroutine_handle<promise_type>;
+        Handle _handle;
+
+        explicit TurnFlow(Handle h) : _handle(h) {}
+        void resume();
+
+        struct Self;
+        struct NextMove;
+        struct NextAnswer;
+
+    public:
+        TurnFlow() : _handle(nullptr) {}
+        TurnFlow(TurnFlow&& other) noexcept;
+        TurnFlow& operator=(TurnFlow&& other) noexcept;
+        TurnFlow(const TurnFlow&) = delete;
+        TurnFlow& operator=(const TurnFlow&) = delete;
+        ~TurnFlow();
+
+        static TurnFlow play(Game& game, Reaction open = Reaction());
+        static std::size_t frame_bytes();
+
+        Waiting waiting() const;
+        int seat() const;
+        MoveStatus submit(const Move& m);
+        void answer(bool block);
+        const Reaction& reaction() const;
+        bool done() const;
+};
+#endif
@@ -1,9 +1,11 @@
 #include "Game.hpp"
 #include "Players/Baron.hpp"
 #include "Players/Merchant.hpp"
+#include "Engine/EventLog.hpp"
 Game::Game(){
     _turn = 0;
     _is_bribe = false;
+    _log = nullptr;
 }
 Game::~Game(){
     for(Player* p : _players){
@@ -27,7 +29,7 @@ void Game::clear_players() {
     _turn = 0;
     _is_bribe = false;
 }
-std::vector<Player*>& Game::get_players(){
+PlayerList& Game::get_players(){
     return _players;
 }
 int Game::get_turn(){
@@ -49,16 +51,9 @@ void Game::set_isBribe(const bool isBribe){
  * @throws std::runtime_error if no single winner yet.
  */
 std::string Game::winner(){
-    std::string won;
-    int count  = 0;
-    for(Player* p : _players){
-        if(p->get_isActive()){
-            count++;
-            won = p->get_name();
-        }
-    }
-    if(count == 1){
-        return won;
+    SeatMask active = _players.active_mask();
+    if(mask_count(active) == 1){
+        return _players[mask_first(active)]->get_name();
     }
     throw std::runtime_error("No winner yet or multiple players still active");
 }
@@ -96,13 +91,13 @@ bool Game::have_arrests_options(Player& p) const{
     if (!p.get_canArrest()) {
         return false;
     }
-    for (int i = 0; i < static_cast<int>(_players.size()); ++i) {
-        Player* player = _players[i];
-        if (i != _turn && player->get_isActive() && !player->get_lastArrested()) {
-            int coins = player->get_coins();
-            if (coins > 0 || (dynamic_cast<Merchant*>(player) && coins > 1)) {
-                return true;
-            }
+    SeatMask candidates = _players.active_mask() & ~_players.arrested_mask() & ~seat_bit(_turn);
+    while (candidates) {
+        int i = mask_first(candidates);
+        candidates &= candidates - 1;
+        int coins = _players.coins(i);
+        if (coins >= (_players.role(i) == Role::MERCHANT ? 2 : 1)) {
+            return true;
         }
     }
     return false;
@@ -124,6 +119,44 @@ bool Game::can_take_action(Player& p) const{
     }
     return this->have_arrests_options(p);
 }
+/**
+ * @brief Role allowed to block an action: General blocks coup, Governor blocks tax, Judge blocks bribe.
+ * @param action Action being answered.
+ * @return Blocking role, or Role::CITIZEN if the action cannot be blocked.
+ */
+Role Game::blocker_role(GameAction action){
+    switch(action){
+        case GameAction::COUP: return Role::GENERAL;
+        case GameAction::TAX: return Role::GOVERNOR;
+        case GameAction::BRIBE: return Role::JUDGE;
+        default: return Role::CITIZEN;
+    }
+}
+/**
+ * @brief Seats that may block the given action, in seat order (lowest bit first).
+ * A General additionally needs 5 coins to pay for the block.
+ * @param action Action being answered.
+ * @param actor Seat that performed the action; never its own blocker.
+ * @return Mask of eligible blocker seats, 0 if nobody can block.
+ */
+SeatMask Game::blockers_for(GameAction action, int actor) const{
+    Role role = blocker_role(action);
+    if(role == Role::CITIZEN){
+        return 0;
+    }
+    SeatMask mask = _players.active_role_mask(role) & ~seat_bit(actor);
+    if(role == Role::GENERAL){
+        SeatMask rich = 0;
+        for(SeatMask m = mask; m; m &= m - 1){
+            int seat = mask_first(m);
+            if(_players.coins(seat) >= 5){
+                rich |= seat_bit(seat);
+            }
+        }
+        mask = rich;
+    }
+    return mask;
+}
 /**
  * @brief Advances to the next active player’s turn, handles sanctions, arrests, bribes, and Merchant bonus.
  * @throws std::runtime_error if no players.
@@ -133,10 +166,10 @@ void Game::turn_manager(){
         throw std::runtime_error("No players");
     }
     Player* currentPlayer = _players[_turn];
-    if(currentPlayer->get_isSanction()){
+    if(_players.sanction_mask() & seat_bit(_turn)){
         currentPlayer->set_isSanction(false);
     }
-    if(!currentPlayer->get_canArrest()){
+    if(!(_players.can_arrest_mask() & seat_bit(_turn))){
         currentPlayer->set_canArrest(true);
     }
     if (_is_bribe) {
@@ -146,9 +179,9 @@ void Game::turn_manager(){
 
     do {
         _turn = (_turn + 1) % static_cast<int>(_players.size());
-    } while (!_players[_turn]->get_isActive());
+    } while (!_players.is_active(_turn));
 
-    if(dynamic_cast<Merchant*>(_players[_turn]) && _players[_turn]->get_coins() > 2){
+    if(_players.role(_turn) == Role::MERCHANT && _players.coins(_turn) > 2){
         _players[_turn]->set_coins(_players[_turn]->get_coins() + 1);
     }
     if(!can_take_action(*_players[_turn])){
@@ -156,3 +189,245 @@ void Game::turn_manager(){
     }
     
 }
+/**
+ * @brief True once exactly one seat is still active.
+ */
+bool Game::has_winner() const{
+    return mask_count(_players.active_mask()) == 1;
+}
+/**
+ * @brief Seat of the winner, or -1 while more than one player is active.
+ */
+int Game::winner_seat() const{
+    return has_winner() ? mask_first(_players.active_mask()) : -1;
+}
+/**
+ * @brief Finds the first move, in a fixed cautious order (gather, tax, bribe, then arrest,
+ * sanction and coup on each active opponent), that ends the seat's turn. Role abilities
+ * are excluded since they leave the turn open. Servers play it for idle players.
+ * @param out Set to the move when one exists.
+ * @return false if the seat has no such move.
+ */
+bool Game::first_legal_move(int seat, Move& out) const{
+    for(GameAction a : {GameAction::GATHER, GameAction::TAX, GameAction::BRIBE}){
+        if(validate({a, seat}) == MoveStatus::OK){
+            out = Move{a, seat};
+            return true;
+        }
+    }
+    for(SeatMask targets = _players.active_mask() & ~seat_bit(seat); targets; targets &= targets - 1){
+        int t = mask_first(targets);
+        for(GameAction a : {GameAction::ARREST, GameAction::SANCTION, GameAction::COUP}){
+            if(validate({a, seat, t}) == MoveStatus::OK){
+                out = Move{a, seat, t};
+                return true;
+            }
+        }
+    }
+    return false;
+}
+/**
+ * @brief True if the seat can play some move that ends its turn. Callers hosting
+ * unattended games use this to pass turns that would otherwise stall.
+ */
+bool Game::has_legal_move(int seat) const{
+    Move m{GameAction::NONE, seat};
+    return first_legal_move(seat, m);
+}
+/**
+ * @brief Passes the turn of each player left with no legal move (e.g. sanctioned and broke
+ * after a bribe), at most once around the table, so nobody waits on a move no one can make.
+ * @return Number of turns passed.
+ */
+int Game::pass_stuck_turns(){
+    int n = static_cast<int>(_players.size());
+    int passes = 0;
+    while(passes < n && !has_winner() && !has_legal_move(_turn)){
+        _is_bribe = false;
+        turn_manager();
+        passes++;
+    }
+    return passes;
+}
+/**
+ * @brief Checks a seat-addressed move against the rules without throwing.
+ * Covers the Player action checks plus the table rules the GUI enforces
+ * (Spy arrest ban, no repeat arrest, Judge sanction surcharge).
+ * @param m Move to check.
+ * @return MoveStatus::OK if the move is legal, otherwise the first rule it breaks.
+ */
+MoveStatus Game::validate(const Move& m) const{
+    int n = static_cast<int>(_players.size());
+    if(n == 0){
+        return MoveStatus::NO_PLAYERS;
+    }
+    if(m.actor < 0 || m.actor >= n){
+        return MoveStatus::BAD_SEAT;
+    }
+    if(has_winner()){
+        return MoveStatus::GAME_OVER;
+    }
+    if(!_players.is_active(m.actor)){
+        return MoveStatus::INACTIVE;
+    }
+    if(m.actor != _turn){
+        return MoveStatus::OUT_OF_TURN;
+    }
+    int coins = _players.coins(m.actor);
+    if(coins > 9 && m.action != GameAction::COUP){
+        return MoveStatus::MUST_COUP;
+    }
+    bool has_target = m.target >= 0 && m.target < n && m.target != m.actor && _players.is_active(m.target);
+    switch(m.action){
+        case GameAction::GATHER:
+        case GameAction::TAX:
+            if(_players.sanction_mask() & seat_bit(m.actor)){
+                return MoveStatus::SANCTIONED;
+            }
+            return MoveStatus::OK;
+        case GameAction::BRIBE:
+            return coins < 4 ? MoveStatus::NOT_ENOUGH_COINS : MoveStatus::OK;
+        case GameAction::ARREST:{
+            if(!(_players.can_arrest_mask() & seat_bit(m.actor))){
+                return MoveStatus::CANNOT_ARREST;
+            }
+            if(!has_target || (_players.arrested_mask() & seat_bit(m.target))){
+                return MoveStatus::BAD_TARGET;
+            }
+            int need = _players.role(m.target) == Role::MERCHANT ? 2 : 1;
+            return _players.coins(m.target) < need ? MoveStatus::TARGET_NO_COINS : MoveStatus::OK;
+        }
+        case GameAction::SANCTION:{
+            if(!has_target){
+                return MoveStatus::BAD_TARGET;
+            }
+            int need = _players.role(m.target) == Role::JUDGE ? 4 : 3;
+            return coins < need ? MoveStatus::NOT_ENOUGH_COINS : MoveStatus::OK;
+        }
+        case GameAction::COUP:
+            if(!has_target){
+                return MoveStatus::BAD_TARGET;
+            }
+            return coins < 7 ? MoveStatus::NOT_ENOUGH_COINS : MoveStatus::OK;
+        case GameAction::UNIQE:
+            switch(_players.role(m.actor)){
+                case Role::BARON:
+                    return coins < 3 ? MoveStatus::NOT_ENOUGH_COINS : MoveStatus::OK;
+                case Role::SPY:
+                    return has_target ? MoveStatus::OK : MoveStatus::BAD_TARGET;
+                default:
+                    return MoveStatus::NO_ABILITY;
+            }
+        default:
+            return MoveStatus::BAD_ACTION;
+    }
+}
+/**
+ * @brief Applies a move validate() accepted. Reactions (blocks) are not opened here;
+ * callers that want them open an Engine/Reaction afterwards.
+ * As in the GUI, Baron's invest and Spy's reveal do not end the turn.
+ */
+void Game::apply_unchecked(const Move& m){
+    if(_log){
+        _log->record_move(m);
+    }
+    Player* p = _players[m.actor];
+    switch(m.action){
+        case GameAction::GATHER:
+            p->apply_gather();
+            break;
+        case GameAction::TAX:
+            p->apply_tax();
+            break;
+        case GameAction::BRIBE:
+            p->apply_bribe();
+            break;
+        case GameAction::ARREST:{
+            Player* target = _players[m.target];
+            p->apply_arrest(*target);
+            for(SeatMask a = _players.arrested_mask() & ~seat_bit(m.target); a; a &= a - 1){
+                _players[mask_first(a)]->set_lastArrested(false);
+            }
+            target->set_lastArrested(true);
+            break;
+        }
+        case GameAction::SANCTION:
+            p->apply_sanction(*_players[m.target]);
+            break;
+        case GameAction::COUP:
+            p->apply_coup(*_players[m.target]);
+            break;
+        case GameAction::UNIQE:
+            if(_players.role(m.actor) == Role::BARON){
+                p->uniqe();
+            }
+            else{
+                p->uniqe(*_players[m.target]);
+            }
+            break;
+        default:
+            break;
+    }
+}
+/**
+ * @brief Validates and applies a single seat-addressed move.
+ * @return MoveStatus::OK if applied, otherwise the reason it was rejected (state untouched).
+ */
+MoveStatus Game::apply(const Move& m){
+    MoveStatus status = validate(m);
+    if(status == MoveStatus::OK){
+        apply_unchecked(m);
+    }
+    return status;
+}
+/**
+ * @brief Applies a sequence of moves in one loop, one validation per move and no exceptions.
+ * Stops at the first illegal move; moves before it stay applied.
+ * @param moves Moves in play order.
+ * @return Count applied, plus index and status of the move that stopped the batch.
+ */
+BatchResult Game::apply_batch(std::span<const Move> moves){
+    BatchResult result;
+    for(const Move& m : moves){
+        MoveStatus status = validate(m);
+        if(status != MoveStatus::OK){
+            result.failed_index = static_cast<int>(result.applied);
+            result.status = status;
+            break;
+        }
+        apply_unchecked(m);
+        result.applied++;
+    }
+    return result;
+}
+
+/**
+ * @brief Attaches an event log; every move applied through the engine is appended to it.
+ * @param log Log to write, or nullptr to stop logging.
+ */
+void Game::set_log(EventLog* log){
+    _log = log;
+}
+EventLog* Game::get_log() const{
+    return _log;
+}
+
+const char* to_string(MoveStatus status){
+    switch(status){
+        case MoveStatus::OK: return "ok";
+        case MoveStatus::NO_PLAYERS: return "no players";
+        case MoveStatus::BAD_SEAT: return "no such seat";
+        case MoveStatus::GAME_OVER: return "game is over";
+        case MoveStatus::INACTIVE: return "player not active";
+        case MoveStatus::OUT_OF_TURN: return "player is out of turn";
+        case MoveStatus::MUST_COUP: return "player has 10 coins, must coup";
+        case MoveStatus::SANCTIONED: return "player is sanctioned";
+        case MoveStatus::NOT_ENOUGH_COINS: return "not enough money";
+        case MoveStatus::BAD_TARGET: return "invalid target";
+        case MoveStatus::TARGET_NO_COINS: return "target player has no money";
+        case MoveStatus::CANNOT_ARREST: return "player cannot arrest";
+        case MoveStatus::NO_ABILITY: return "role has no such ability";
+        case MoveStatus::BAD_ACTION: return "unknown action";
+    }
+    return "unknown";
+}
@@ -3,20 +3,30 @@
 
 #include <iostream>
 #include <vector>
+#include <span>
 #include "Players/Player.hpp"
+#include "PlayerList.hpp"
+#include "Move.hpp"
+
+class EventLog;
+
 class Game{
     private:
-        std::vector<Player*> _players;
+        PlayerList _players;
         int _turn;
         bool _is_bribe;
+        EventLog* _log;
+        void apply_unchecked(const Move& m);
+        friend class Replayer;
+    public:
+        // The GUI and tests share instance(); servers and simulators own one Game per match
         Game();
         ~Game();
         Game(const Game&) = delete;
         Game& operator=(const Game&) = delete;
-    public:
         static Game& instance();
           void clear_players();
-        std::vector<Player*>& get_players();
+        PlayerList& get_players();
         int get_turn();
         void set_turn(const int turn);
          bool get_isBribe() const;
@@ -29,6 +39,18 @@ class Game{
         void turn_manager();
         bool have_arrests_options(Player& p) const;
         bool can_take_action( Player& p) const;
+        static Role blocker_role(GameAction action);
+        SeatMask blockers_for(GameAction action, int actor) const;
+        bool has_winner() const;
+        int winner_seat() const;
+        MoveStatus validate(const Move& m) const;
+        bool has_legal_move(int seat) const;
+        bool first_legal_move(int seat, Move& out) const;
+        int pass_stuck_turns();
+        MoveStatus apply(const Move& m);
+        BatchResult apply_batch(std::span<const Move> moves);
+        void set_log(EventLog* log);
+        EventLog* get_log() const;
         //void add_player(Player* p);
         //void make_action();
 
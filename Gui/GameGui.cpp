@@ -11,16 +11,17 @@
 #include "../Players/Governor.hpp"
 #include "../Players/Spy.hpp"
 #include "../Players/PlayerFactory.hpp"
+#include "../Engine/Deal.hpp"
 #include "../GameAction.hpp"
 
 
-GameGui::GameGui(int playerCount) 
+GameGui::GameGui(int playerCount, std::uint64_t seed) 
     : window(sf::VideoMode(1200, 800), "Coup - Main Game")
     , font()
     , fontLoaded(false)
     , numPlayers(playerCount)
     , game(&Game::instance())
-    , rng(std::random_device{}())
+    , rng(seed)
     , waitingForBlock(false)
     , blockingPlayer(-1)
     , lastActionTarget(-1)
@@ -28,7 +29,7 @@ GameGui::GameGui(int playerCount)
     , winnerName("")
     
 {
-    std::cout << "GameGui constructor started with " << playerCount << " players" << std::endl;
+    std::cout << "GameGui constructor started with " << playerCount << " players, seed " << seed << std::endl;
     
     // Try to load font
     if (!font.loadFromFile("/usr/share/fonts/truetype/msttcorefonts/Arial.ttf") &&
@@ -38,7 +39,6 @@ GameGui::GameGui(int playerCount)
     } else {
         fontLoaded = true;
     }
-    roleNames = {"Governor", "Spy", "Baron", "General", "Judge", "Merchant"};
 
     std::cout << "About to initialize colors" << std::endl;
     initializeColors();
@@ -73,35 +73,10 @@ void GameGui::initializeColors() {
 }
 
 void GameGui::initializePlayers() {
-     // Clear existing players first
-    std::vector<Player*>& players = game->get_players();
-    for(Player* p : players) {
-        delete p;
-    }
-    players.clear();
-
+    // Replaces any existing players; the same seed deals the same table
     playersGui.resize(numPlayers);
-    players.reserve(numPlayers);
+    deal_table(*game, numPlayers, rng);
 
-   std::vector<std::string> availableRoles(numPlayers);
-    for (int i = 0; i < numPlayers; ++i) {
-        availableRoles[i] = roleNames[rng() % roleNames.size()];
-    }      
-    std::shuffle(availableRoles.begin(), availableRoles.end(), rng);
-    
-    for (int i = 0; i < numPlayers; i++) {
-        Player* newPlayer = nullptr;
-        std::string playerName = "Player " + std::to_string(i + 1);
-        std::string role = availableRoles[i];
-        
-        // Create player based on role
-        newPlayer = PlayerFactory::createPlayer(role, *game, playerName);
-        //
-         newPlayer->set_coins(2);  
-         newPlayer->set_isActive(true);
-         players.push_back(newPlayer);
-    }
-    
     setupPlayerPositions();
 }
 
@@ -513,7 +488,7 @@ void GameGui::handleMouseMove(sf::Vector2i mousePos) {
                     isAvailable = currentPlayer->get_canArrest();
                      if (isAvailable) {
                     // Check if there are any valid arrest targets
-                    std::vector<Player*>& players = game->get_players();
+                    PlayerList& players = game->get_players();
                     bool hasValidTarget = false;
                     
                     for (int j = 0; j < numPlayers; j++) {
@@ -530,7 +505,7 @@ void GameGui::handleMouseMove(sf::Vector2i mousePos) {
                 break;
                     
                 case GameAction::SANCTION:{
-                    std::vector<Player*>& players = game->get_players();
+                    PlayerList& players = game->get_players();
                     bool hasValidTarget = false;
                     
                     for (int j = 0; j < numPlayers; j++) {
@@ -610,7 +585,7 @@ void GameGui::handleMouseMove(sf::Vector2i mousePos) {
 }
 
 void GameGui::executeTargetedAction(int targetIndex) {
-    std::vector<Player*>& players = game->get_players();
+    PlayerList& players = game->get_players();
     Player* currentPlayer = players[game->get_turn()];
     
     // Find actual target 
@@ -644,9 +619,8 @@ void GameGui::executeTargetedAction(int targetIndex) {
                 lastPlayer = game->get_turn();
                 currentPlayer->coup(*target);
                 actionName = "Coup";
-                coupTarget = target;
                 // Check for blocking after execution
-                if (players[lastPlayer]->get_lastAction() == GameAction::COUP && hasGeneralToBlock()) {
+                if (openReaction(GameAction::COUP, actualTargetIndex)) {
                     waitingForBlock = true;
                     lastAction = pendingAction;
                     updateInfoPanel(currentPlayer->get_name() + " couped " + target->get_name() + " - Generals can block!");
@@ -697,7 +671,7 @@ void GameGui::executeTargetedAction(int targetIndex) {
                 currentPlayer->arrest(*target);
                 actionName = "Arrest";
 
-                std::vector<Player*>& allPlayers = game->get_players();
+                PlayerList& allPlayers = game->get_players();
                 for (Player* p : allPlayers) {
                     if (p != target) {
                         p->set_lastArrested(false);
@@ -820,52 +794,10 @@ void GameGui::executeTargetedAction(int targetIndex) {
     updatePlayerDisplay();
 }
 
-bool GameGui::hasGeneralToBlock() {
-   std::vector<Player*>& players = game->get_players();
-   //int temp_turn = getActualCurrentIndex();
-    eligibleBlockers.clear();
-    
-    for (int i = 0; i < static_cast<int>(players.size()); i++) {
-        Player* p = players[i];
-        if (p->get_name() != players[lastPlayer]->get_name() && 
-            dynamic_cast<General*>(p) && 
-            p->get_isActive() && 
-            p->get_coins() >= 5) {
-            eligibleBlockers.push_back(i);
-        }
-    }
-    return !eligibleBlockers.empty();
-}
-bool GameGui::hasGovernorToBlock() {
-    std::vector<Player*>& players = game->get_players();
-   //int temp_turn = getActualCurrentIndex();
-    eligibleBlockers.clear();
-    
-    for (int i = 0; i < static_cast<int>(players.size()); i++) {
-        Player* p = players[i];
-        if (p->get_name() != players[lastPlayer]->get_name() && 
-            dynamic_cast<Governor*>(p) && 
-            p->get_isActive()) { 
-            eligibleBlockers.push_back(i);
-        }
-    }
-    return !eligibleBlockers.empty();
-}
-
-bool GameGui::hasJudgeToBlock() {
-    std::vector<Player*>& players = game->get_players();
-    //int temp_turn = getActualCurrentIndex();
-    eligibleBlockers.clear();
-    
-    for (int i = 0; i < static_cast<int>(players.size()); i++) {
-        Player* p = players[i];
-        if (p->get_name() != players[lastPlayer]->get_name() && 
-            dynamic_cast<Judge*>(p) && 
-            p->get_isActive()) {
-            eligibleBlockers.push_back(i);
-        }
-    }
-    return !eligibleBlockers.empty();
+// Opens the engine's reaction window for the action lastPlayer just played
+bool GameGui::openReaction(GameAction action, int target) {
+    reaction = Reaction(*game, action, lastPlayer, target);
+    return reaction.is_open();
 }
 
 
@@ -903,16 +835,15 @@ bool GameGui::isValidSanctionTarget(Player* target){
 }
 
 void GameGui::startBlockingSequence() {
-    if (!eligibleBlockers.empty()) {
-        currentBlockerIndex = 0;
+    if (reaction.is_open()) {
         showCurrentBlockerOption();
     }
 }
 
 void GameGui::showCurrentBlockerOption() {
-    if (currentBlockerIndex < static_cast<int>(eligibleBlockers.size())) {
-        std::vector<Player*>& players = game->get_players();
-        int blockerPlayerIndex = eligibleBlockers[currentBlockerIndex];
+    if (reaction.is_open()) {
+        PlayerList& players = game->get_players();
+        int blockerPlayerIndex = reaction.current_blocker();
         currentBlockerName = players[blockerPlayerIndex]->get_name();
         
         // Highlight the current blocker's card
@@ -964,7 +895,7 @@ void GameGui::showCurrentBlockerOption() {
         gamePhase = 0;
         targetPlayer = -1;
         waitingForBlock = false;
-        eligibleBlockers.clear();
+        reaction = Reaction();
         phaseText.setString("Phase: Action Selection");
         instructionText.setString("Choose an action:");
         
@@ -979,31 +910,11 @@ void GameGui::showCurrentBlockerOption() {
 }
 
 void GameGui::handleBlock() {
-    std::vector<Player*> players = game->get_players();
-    Player* blocker = players[eligibleBlockers[currentBlockerIndex]];
-    //int temp_turn = getActualCurrentIndex();
-    Player* currentPlayer = players[lastPlayer]; 
     std::string blockMessage;
     
     try {
-        // Call blocker's uniqe() method based on their type
-        // Check if blocker is Baron (who doesn't need a target)
-        if (dynamic_cast<Baron*>(blocker)) {
-            blocker->uniqe(); // Baron invests, no target needed
-        }else if (dynamic_cast<General*>(blocker))
-        {
-           blocker->uniqe(*players[lastPlayer], *coupTarget);
-           game->set_turn(lastPlayer);
-           game->turn_manager();
-
-        }else if (dynamic_cast<Judge*>(blocker))//the turn didnt move yet
-        {
-            blocker->uniqe(*players[game->get_turn()]);
-        }
-        
-         else {
-            blocker->uniqe(*currentPlayer); // Other players block the current player
-        }
+        // The engine applies the blocker's counter effect for the pending action
+        reaction.block();
         
         switch (lastAction) {
             case GameAction::TAX:
@@ -1027,7 +938,7 @@ void GameGui::handleBlock() {
         gamePhase = 0;
         targetPlayer = -1;
         waitingForBlock = false;
-        eligibleBlockers.clear();
+        reaction = Reaction();
         phaseText.setString("Phase: Action Selection");
         instructionText.setString("Choose an action:");
         
@@ -1040,18 +951,17 @@ void GameGui::handleBlock() {
         updateInfoPanel(blockMessage);
         
         // Continue to next blocker or execute action
-        currentBlockerIndex++;
         showCurrentBlockerOption();
     }
 
 }
 
 void GameGui::handleAllow() {
-     //std::vector<Player*>& players = game->get_players();
+     //PlayerList& players = game->get_players();
      updateInfoPanel(currentBlockerName + " allows the action.");
     
     // Move to next blocker
-    currentBlockerIndex++;
+    reaction.allow();
     showCurrentBlockerOption();
     
 }
@@ -1107,7 +1017,7 @@ void GameGui::executeAction(GameAction action) {
                 }
                 
                 // Check for blocking after execution
-                if (hasGovernorToBlock()) {
+                if (openReaction(GameAction::TAX)) {
                     waitingForBlock = true;
                     lastAction = action;
                     gamePhase = 2;
@@ -1140,7 +1050,7 @@ void GameGui::executeAction(GameAction action) {
                 currentPlayer->bribe();
                 
                 // Check for blocking after execution
-                if (hasJudgeToBlock()) {
+                if (openReaction(GameAction::BRIBE)) {
                     waitingForBlock = true;
                     lastAction = action;
                     pendingAction = action;
@@ -1168,7 +1078,7 @@ void GameGui::executeAction(GameAction action) {
 
             // Check if there are any valid arrest targets
             {
-                std::vector<Player*>& players = game->get_players();
+                PlayerList& players = game->get_players();
                 bool hasValidTarget = false;
                 
                 for (int i = 0; i < numPlayers; i++) {
@@ -1276,7 +1186,7 @@ void GameGui::setupTargetSelection() {
     targetButtons.clear();
     targetButtonTexts.clear();
     
-    std::vector<Player*>& players = game->get_players();
+    PlayerList& players = game->get_players();
     int currentTurn = game->get_turn();
     
     for (int i = 0; i < numPlayers; i++) {
@@ -1365,7 +1275,7 @@ void GameGui::updateActionButtonVisibility() {
                 shouldShow = currentPlayer->get_canArrest();
                 if (shouldShow) {
                     // Check if there are any valid arrest targets
-                    std::vector<Player*>& players = game->get_players();
+                    PlayerList& players = game->get_players();
                     bool hasValidTarget = false;
                     
                     for (int j = 0; j < numPlayers; j++) {
@@ -1383,7 +1293,7 @@ void GameGui::updateActionButtonVisibility() {
                 
             case GameAction::SANCTION:{
                 // Hide sanction if player doesn't have enough coins
-                std::vector<Player*>& players = game->get_players();
+                PlayerList& players = game->get_players();
                 bool hasValidTarget = false;
                 
                 for (int j = 0; j < numPlayers; j++) {
@@ -1521,7 +1431,7 @@ void GameGui::resetGame() {
     waitingForBlock = false;
     blockingPlayer = -1;
     lastActionTarget = -1;
-    eligibleBlockers.clear();
+    reaction = Reaction();
     revealedPlayers.clear();
     
     // Clear existing buttons
@@ -1569,8 +1479,7 @@ void GameGui::draw() {
     }
 
      // Draw current blocker highlight (only during blocking phase)
-    if (gamePhase == 2 && !eligibleBlockers.empty() && 
-        currentBlockerIndex < static_cast<int>(eligibleBlockers.size())) {
+    if (gamePhase == 2 && reaction.is_open()) {
         window.draw(currentBlockerHighlight);
     }
     
@@ -1624,7 +1533,7 @@ void GameGui::handleEvents() {
     sf::Event event;
     while (window.pollEvent(event)) {
         if (event.type == sf::Event::Closed) {
-            std::vector<Player*>& players = game->get_players();
+            PlayerList& players = game->get_players();
             for(Player* p : players) {
                 delete p;
             }
@@ -4,8 +4,9 @@
 #include <SFML/Graphics.hpp>
 #include <vector>
 #include <string>
-#include <random>
 #include "../Game.hpp"
+#include "../Engine/Reaction.hpp"
+#include "../Engine/Rng.hpp"
 
 
 struct PlayerGui {
@@ -30,18 +31,15 @@ private:
     GameAction pendingAction;
     int targetPlayer;
     Game* game;
-    std::mt19937 rng;
+    Rng rng;
     bool waitingForBlock;
     int blockingPlayer;
     GameAction lastAction;
     int lastActionTarget;
     int lastPlayer;
-    std::vector<std::string> roleNames;
-    Player* coupTarget;
     //bool isBribe;
     
-    std::vector<int> eligibleBlockers;      // Indices of players who can block
-    int currentBlockerIndex;                // Current blocker being asked
+    Reaction reaction;                      // Engine reaction window (eligible blockers, current one)
     std::string currentBlockerName;         // Name of current blocker for display
     std::vector<int> revealedPlayers;       // Track which players' coins are visible
     
@@ -120,9 +118,7 @@ private:
     void handleMouseClick(sf::Vector2i mousePos);
     void handleMouseMove(sf::Vector2i mousePos);
     void executeTargetedAction(int targetIndex);
-    bool hasGeneralToBlock();
-    bool hasGovernorToBlock();
-    bool hasJudgeToBlock();
+    bool openReaction(GameAction action, int target = -1);
     //bool canPlayerTakeAction();
     //int getActualCurrentIndex();
     bool isValidArrestTarget(Player* target);
@@ -149,7 +145,7 @@ private:
     bool isPointInResetButton(sf::Vector2i point);
     
 public:
-    GameGui(int playerCount);
+    GameGui(int playerCount, std::uint64_t seed = Rng::random_seed());
     void run();
     void draw();
     void handleEvents();
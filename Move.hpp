@@ -0,0 +1,43 @@
+#ifndef MOVE_HPP
+#define MOVE_HPP
+
+#include <cstddef>
+#include "GameAction.hpp"
+
+/**
+ * @brief One turn action addressed by seat, as submitted by bots, replays and servers.
+ */
+struct Move{
+    GameAction action;
+    int actor;
+    int target = -1; // arrest/sanction/coup/Spy reveal only
+};
+
+enum class MoveStatus{
+    OK,
+    NO_PLAYERS,
+    BAD_SEAT,
+    GAME_OVER,
+    INACTIVE,
+    OUT_OF_TURN,
+    MUST_COUP,
+    SANCTIONED,
+    NOT_ENOUGH_COINS,
+    BAD_TARGET,
+    TARGET_NO_COINS,
+    CANNOT_ARREST,
+    NO_ABILITY,
+    BAD_ACTION,
+};
+
+/**
+ * @brief Outcome of Game::apply_batch: moves applied, and where and why it stopped.
+ */
+struct BatchResult{
+    std::size_t applied = 0;
+    int failed_index = -1;       // index of the first illegal move, -1 if all applied
+    MoveStatus status = MoveStatus::OK;
+};
+
+const char* to_string(MoveStatus status);
+#endif
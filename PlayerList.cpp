@@ -0,0 +1,61 @@
+#include "PlayerList.hpp"
+#include "Players/Player.hpp"
+
+PlayerList::PlayerList()
+    : _size(0), _active(0), _sanction(0), _arrested(0), _can_arrest(0), _role_seats{}
+{}
+/**
+ * @brief Seats a player in the next free seat and copies its state into the per-seat arrays.
+ * @param p Player to seat.
+ * @throws std::runtime_error if every seat is taken.
+ */
+void PlayerList::push_back(Player* p){
+    if(_size >= CAPACITY){
+        throw std::runtime_error("Table is full");
+    }
+    _seats[_size] = p;
+    _roles[_size] = p->get_role();
+    _role_seats[static_cast<int>(_roles[_size])] |= seat_bit(_size);
+    p->set_seat(_size);
+    _size++;
+    sync(*p);
+}
+void PlayerList::pop_back(){
+    if(_size > 0){
+        --_size;
+        SeatMask keep = ~seat_bit(_size);
+        _active &= keep;
+        _sanction &= keep;
+        _arrested &= keep;
+        _can_arrest &= keep;
+        _role_seats[static_cast<int>(_roles[_size])] &= keep;
+    }
+}
+/**
+ * @brief Empties the table without touching the players (ownership stays with the caller).
+ */
+void PlayerList::clear(){
+    _size = 0;
+    _active = 0;
+    _sanction = 0;
+    _arrested = 0;
+    _can_arrest = 0;
+    for(SeatMask& m : _role_seats){
+        m = 0;
+    }
+}
+/**
+ * @brief Refreshes the per-seat row of a seated player; ignores players no longer in their seat.
+ * @param p Player whose state changed.
+ */
+void PlayerList::sync(Player& p){
+    int seat = p._seat;
+    if(seat < 0 || seat >= _size || _seats[seat] != &p){
+        return;
+    }
+    _coins[seat] = p._coins;
+    assign(_active, seat, p._is_active);
+    assign(_sanction, seat, p._is_sanction);
+    assign(_arrested, seat, p._last_arrested);
+    assign(_can_arrest, seat, p._can_arrest);
+}
@@ -0,0 +1,102 @@
+#ifndef PLAYERLIST_HPP
+#define PLAYERLIST_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include "Role.hpp"
+
+// Maximum number of seats at one table. The GUI offers 2-6 players;
+// override with -DCOUP_MAX_PLAYERS=<n> (see MAX_PLAYERS in the Makefile).
+#ifndef COUP_MAX_PLAYERS
+#define COUP_MAX_PLAYERS 6
+#endif
+
+class Player;
+
+// One bit per seat, bit i set means seat i.
+using SeatMask = std::uint64_t;
+
+inline SeatMask seat_bit(int seat){
+    return SeatMask(1) << seat;
+}
+inline int mask_count(SeatMask mask){
+    return __builtin_popcountll(mask);
+}
+// Index of the lowest set seat; mask must be non-zero.
+inline int mask_first(SeatMask mask){
+    return __builtin_ctzll(mask);
+}
+
+/**
+ * @brief Fixed-capacity, cache-line-aligned seat array used by Game instead of std::vector.
+ * Seats are stored inline in the Game object, so a full table of 6 pointers fits in one cache line.
+ * Alongside the Player pointers it keeps a structure-of-arrays mirror of the fields the
+ * engine scans every turn (coins, role tag, active/sanction/arrest bits). Seated players
+ * push their changes here through Player::sync(), so scans never chase Player pointers.
+ * Seats are also indexed by role, so "active Generals" is a single AND of two masks.
+ */
+class PlayerList{
+    public:
+        static constexpr int CAPACITY = COUP_MAX_PLAYERS;
+        static_assert(CAPACITY > 0, "COUP_MAX_PLAYERS must be positive");
+        static_assert(CAPACITY <= 64, "COUP_MAX_PLAYERS must fit in a SeatMask");
+
+        using value_type = Player*;
+        using const_iterator = Player* const*;
+        using iterator = const_iterator;
+
+        PlayerList();
+        PlayerList(const PlayerList&) = delete;
+        PlayerList& operator=(const PlayerList&) = delete;
+
+        void push_back(Player* p);
+        void pop_back();
+        void clear();
+        /**
+         * @brief Kept for std::vector compatibility; storage is inline, so this only checks the bound.
+         * @throws std::runtime_error if n exceeds the compile-time capacity.
+         */
+        void reserve(std::size_t n) const{
+            if(n > static_cast<std::size_t>(CAPACITY)){
+                throw std::runtime_error("Requested more seats than COUP_MAX_PLAYERS");
+            }
+        }
+        void sync(Player& p);
+
+        std::size_t size() const { return static_cast<std::size_t>(_size); }
+        static constexpr std::size_t capacity() { return static_cast<std::size_t>(CAPACITY); }
+        bool empty() const { return _size == 0; }
+
+        Player* operator[](std::size_t i) const { return _seats[i]; }
+        const_iterator begin() const { return _seats; }
+        const_iterator end() const { return _seats + _size; }
+
+        // Per-seat state, structure-of-arrays.
+        int coins(int seat) const { return _coins[seat]; }
+        Role role(int seat) const { return _roles[seat]; }
+        bool is_active(int seat) const { return (_active & seat_bit(seat)) != 0; }
+        SeatMask seated_mask() const { return _size == 64 ? ~SeatMask(0) : seat_bit(_size) - 1; }
+        SeatMask active_mask() const { return _active; }
+        SeatMask sanction_mask() const { return _sanction; }
+        SeatMask arrested_mask() const { return _arrested; }
+        SeatMask can_arrest_mask() const { return _can_arrest; }
+        SeatMask role_mask(Role r) const { return _role_seats[static_cast<int>(r)]; }
+        SeatMask active_role_mask(Role r) const { return _role_seats[static_cast<int>(r)] & _active; }
+
+    private:
+        alignas(64) Player* _seats[CAPACITY];
+        int _size;
+        SeatMask _active;
+        SeatMask _sanction;
+        SeatMask _arrested;
+        SeatMask _can_arrest;
+        SeatMask _role_seats[ROLE_COUNT];
+        int _coins[CAPACITY];
+        Role _roles[CAPACITY];
+
+        static void assign(SeatMask& mask, int seat, bool value){
+            mask = value ? (mask | seat_bit(seat)) : (mask & ~seat_bit(seat));
+        }
+};
+#endif
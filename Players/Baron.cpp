@@ -18,5 +18,6 @@ void Baron::uniqe(){
     }
     else{
         _coins += 3;
+        sync();
     }
 }
\ No newline at end of file
@@ -9,6 +9,7 @@ class Baron : public Player{
 
     public:
     Baron (Game& game,const std::string& name):Player(game, name){};
+    Role get_role() const override { return Role::BARON; }
     void uniqe() override;
 
 };
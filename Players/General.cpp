@@ -17,5 +17,6 @@ void General::uniqe(Player& action,Player& target ){
     }
     action.set_lastAction(GameAction::NONE);
     _coins -= 5;
+    sync();
     target.set_isActive(true);
 }
\ No newline at end of file
@@ -9,6 +9,7 @@ class General : public Player{
 
     public:
     General (Game& game,const std::string& name):Player(game ,name){};
+    Role get_role() const override { return Role::GENERAL; }
     void uniqe(Player& action,Player& target) override;
     
 
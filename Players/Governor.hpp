@@ -9,6 +9,7 @@ class Governor : public Player{
 
     public:
     Governor (Game& game,const std::string& name):Player(game ,name){}
+    Role get_role() const override { return Role::GOVERNOR; }
     void uniqe(Player& other) override;
 
 };
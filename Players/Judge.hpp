@@ -9,6 +9,7 @@ class Judge : public Player{
 
     public:
     Judge (Game& game,const std::string& name):Player(game ,name){}
+    Role get_role() const override { return Role::JUDGE; }
     void uniqe(Player& other) override;
 };
 #endif
\ No newline at end of file
@@ -6,5 +6,6 @@
 void Merchant::uniqe(){
     if(_coins > 2){
         _coins++;
+        sync();
     }
 }
\ No newline at end of file
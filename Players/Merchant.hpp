@@ -9,6 +9,7 @@ class Merchant : public Player{
 
     public:
     Merchant (Game& game,const std::string& name):Player(game ,name){}
+    Role get_role() const override { return Role::MERCHANT; }
     void uniqe() override;
 };
 #endif
\ No newline at end of file
@@ -34,6 +34,9 @@
     GameAction Player::get_lastAction(){
         return _last_action;
     }
+    int Player::get_seat() const{
+        return _seat;
+    }
 
 
     void Player::set_name(const std::string& name){
@@ -41,22 +44,54 @@
     }
     void Player::set_coins(const int coins){
         _coins = coins;
+        sync();
     }
      void Player::set_isActive(const bool isActive){
         _is_active = isActive;
+        sync();
     }
      void Player::set_isSanction(const bool isSanction){
         _is_sanction = isSanction;
+        sync();
     }
     void Player::set_canArrest(const bool canArrest){
         _can_arrest = canArrest;
+        sync();
     }
     void Player::set_lastArrested(const bool lastArrest){
         _last_arrested = lastArrest;
+        sync();
     }
     void Player::set_lastAction(GameAction act){
         _last_action = act;
     }
+    /**
+ * @brief Overwrites every per-turn field at once, with a single sync (used by snapshot restore).
+ */
+    void Player::set_state(int coins, bool isActive, bool sanctioned, bool canArrest, bool lastArrested, GameAction act){
+        _coins = coins;
+        _is_active = isActive;
+        _is_sanction = sanctioned;
+        _can_arrest = canArrest;
+        _last_arrested = lastArrested;
+        _last_action = act;
+        sync();
+    }
+    /**
+ * @brief Records the seat index assigned by PlayerList and mirrors this player's state into it.
+ */
+    void Player::set_seat(const int seat){
+        _seat = seat;
+        sync();
+    }
+/**
+ * @brief Pushes this player's coins and flags into the game's per-seat arrays; no-op while unseated.
+ */
+    void Player::sync(){
+        if(_seat >= 0){
+            _game.get_players().sync(*this);
+        }
+    }
 
 /**
  * @brief Performs gather action: adds 1 coin if valid and not sanctioned, then advances turn.
@@ -67,9 +102,7 @@
         if(_is_sanction){
             throw std::runtime_error("Player is sanctioned");
         }
-        _coins++;
-        _last_action = GameAction::GATHER;
-        _game.turn_manager();
+        apply_gather();
     }
     /**
  * @brief Performs tax action: adds coins (3 if Governor, else 2) if valid and not sanctioned, then advances turn.
@@ -80,15 +113,7 @@
          if(_is_sanction){
             throw std::runtime_error("Player is sanctioned");
         }
-        if(dynamic_cast<Governor*>(this)){
-            _coins+= 3;
-        }
-        else{
-            _coins+= 2;
-        }
-
-        _last_action = GameAction::TAX;
-        _game.turn_manager();
+        apply_tax();
     }
 /**
  * @brief Performs bribe action by spending 4 coins and setting bribe state.
@@ -100,10 +125,7 @@
             throw std::runtime_error("Not enough money!");
             
         }
-        _coins-=4;
-        _last_action = GameAction::BRIBE;
-        _game.set_isBribe(true);
-        //_game.turn_manager();
+        apply_bribe();
     }
     void Player::arrest(Player& other){
 
@@ -114,18 +136,7 @@
         if(dynamic_cast<Merchant*>(&other) && other.get_coins() < 2){
             throw std::runtime_error("Merchant doesnt have 2 coins");
         }
-        _coins++;
-        other._coins--;   
-        if(dynamic_cast<General*>(&other)){
-            _coins--;
-            other._coins++;
-        }
-        if(dynamic_cast<Merchant*>(&other)){
-            _coins--;
-            other._coins--;
-        }
-        _last_action = GameAction::ARREST;
-        _game.turn_manager();
+        apply_arrest(other);
     }
     /**
  * @brief Performs arrest on another player, transferring coins with role-specific rules.
@@ -138,16 +149,7 @@
         if(_coins <= 2){
              throw std::runtime_error("Not enough money!");  
         }
-        _coins -=3;
-        if(dynamic_cast<Judge*>(&other)){
-            _coins--;
-        }
-        else if(dynamic_cast<Baron*>(&other)){
-            other._coins++;
-        }
-        other._is_sanction = true;
-        _last_action = GameAction::SANCTION;
-        _game.turn_manager();
+        apply_sanction(other);
     }
     /**
  * @brief Performs a coup on another player by spending 7 coins, deactivates target, and handles General block and win check.
@@ -161,23 +163,90 @@
             _last_action = GameAction::NONE;
             throw std::runtime_error("Not enough money!"); 
         }
+        if(apply_coup(other)){
+            std::cout << "Game over! Winner: " << _game.winner() << std::endl;
+        }
+    }
+
+/**
+ * @brief Effect of gather once the move is known to be legal.
+ */
+    void Player::apply_gather(){
+        _coins++;
+        sync();
+        _last_action = GameAction::GATHER;
+        _game.turn_manager();
+    }
+    void Player::apply_tax(){
+        if(get_role() == Role::GOVERNOR){
+            _coins+= 3;
+        }
+        else{
+            _coins+= 2;
+        }
+        sync();
+
+        _last_action = GameAction::TAX;
+        _game.turn_manager();
+    }
+    void Player::apply_bribe(){
+        _coins-=4;
+        sync();
+        _last_action = GameAction::BRIBE;
+        _game.set_isBribe(true);
+    }
+    void Player::apply_arrest(Player& other){
+        _coins++;
+        other._coins--;   
+        if(other.get_role() == Role::GENERAL){
+            _coins--;
+            other._coins++;
+        }
+        if(other.get_role() == Role::MERCHANT){
+            _coins--;
+            other._coins--;
+        }
+        sync();
+        other.sync();
+        _last_action = GameAction::ARREST;
+        _game.turn_manager();
+    }
+    void Player::apply_sanction(Player& other){
+        _coins -=3;
+        if(other.get_role() == Role::JUDGE){
+            _coins--;
+        }
+        else if(other.get_role() == Role::BARON){
+            other._coins++;
+        }
+        other._is_sanction = true;
+        sync();
+        other.sync();
+        _last_action = GameAction::SANCTION;
+        _game.turn_manager();
+    }
+/**
+ * @brief Effect of coup once the move is known to be legal; a targeted General who can pay blocks it on the spot.
+ * @return true if only one player is left active (game over), in which case the turn does not advance.
+ */
+    bool Player::apply_coup(Player& other){
+        _last_action = GameAction::COUP;
         _coins-=7;
         other._is_active = false;
+        sync();
+        other.sync();
           
-        if(dynamic_cast<General*>(&other)){
+        if(other.get_role() == Role::GENERAL && other.get_coins() >= 5){
              try {
                 other.uniqe(*this, other);
             } catch (const std::exception& e) {
                 std::cerr << "General failed to block: " << e.what() << std::endl;
-    }
+            }
         }
         // Check for a winner after the coup
-        try {
-            std::string win = _game.winner();
-            std::cout << "Game over! Winner: " << win << std::endl;
-            return;  
-        } catch (const std::runtime_error& e) {
-            // No winner yet — continue game
-        }
-            _game.turn_manager();
+        if(_game.has_winner()){
+            return true;
+        }
+        _game.turn_manager();
+        return false;
     }
@@ -3,6 +3,7 @@
 
 #include <iostream>
 #include "../GameAction.hpp"
+#include "../Role.hpp"
 //#include "../Game.hpp"
 class Game;
 
@@ -17,8 +18,12 @@ class Player{
     bool _can_arrest;
     bool _last_arrested;
     GameAction _last_action = GameAction::NONE;
+    int _seat = -1; // index in Game's PlayerList, -1 while unseated
     //Player* _last_arrested;
 
+    void sync();
+    friend class PlayerList;
+
     public:
     Player(Game& game,const std::string& name);
     Player(Player& other) = delete;
@@ -33,6 +38,8 @@ class Player{
     bool get_canArrest();
     bool get_lastArrested();
     GameAction get_lastAction();
+    int get_seat() const;
+    virtual Role get_role() const { return Role::CITIZEN; }
 
     void set_name(const std::string& name);
     void set_coins(const int coins);
@@ -41,6 +48,8 @@ class Player{
     void set_canArrest(const bool canArrest);
     void set_lastArrested(const bool lastArrest);
     void set_lastAction(GameAction act);
+    void set_seat(const int seat);
+    void set_state(int coins, bool isActive, bool sanctioned, bool canArrest, bool lastArrested, GameAction act);
 
 
     void gather();
@@ -49,6 +58,15 @@ class Player{
     void arrest(Player& other);
     void sanction(Player& other);
     void coup(Player& other);
+
+    // Action effects without legality checks; Game::apply runs them after its own validation
+    void apply_gather();
+    void apply_tax();
+    void apply_bribe();
+    void apply_arrest(Player& other);
+    void apply_sanction(Player& other);
+    bool apply_coup(Player& other);
+
     virtual void uniqe(){}
     virtual void uniqe(Player& other){(void)other;}
     virtual void uniqe(Player& action, Player& target){(void)action; (void)target;}
@@ -1,3 +1,6 @@
+#ifndef PLAYERFACTORY_HPP
+#define PLAYERFACTORY_HPP
+
 #include "Governor.hpp"
 #include "Spy.hpp"
 #include "Baron.hpp"
@@ -18,3 +21,4 @@ public:
         return new Player(game,name); 
     }
 };
+#endif
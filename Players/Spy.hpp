@@ -9,6 +9,7 @@ class Spy : public Player{
 
     public:
     Spy (Game& game,const std::string& name):Player(game ,name){}
+    Role get_role() const override { return Role::SPY; }
     void uniqe(Player& other) override;
 
 };
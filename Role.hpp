@@ -0,0 +1,26 @@
+#ifndef ROLE_HPP
+#define ROLE_HPP
+
+enum class Role : unsigned char{
+    CITIZEN,
+    GOVERNOR,
+    SPY,
+    BARON,
+    GENERAL,
+    JUDGE,
+    MERCHANT,
+};
+constexpr int ROLE_COUNT = 7;
+
+inline const char* role_name(Role role){
+    switch(role){
+        case Role::GOVERNOR: return "Governor";
+        case Role::SPY: return "Spy";
+        case Role::BARON: return "Baron";
+        case Role::GENERAL: return "General";
+        case Role::JUDGE: return "Judge";
+        case Role::MERCHANT: return "Merchant";
+        default: return "Citizen";
+    }
+}
+#endif
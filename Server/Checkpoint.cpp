@@ -0,0 +1,187 @@
+#include "Checkpoint.hpp"
+#include <cerrno>
+#include <cstring>
+#include <exception>
+#include <stdexcept>
+#include <thread>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+const char MAGIC[4] = {'C', 'P', 'C', 'K'};
+constexpr std::size_t WRITE_CHUNK = std::size_t(1) << 20;
+
+std::runtime_error sys_error(const std::string& what){
+    return std::runtime_error(what + ": " + std::strerror(errno));
+}
+std::uint32_t fnv1a(const std::uint8_t* data, std::size_t size){
+    std::uint32_t h = 2166136261u;
+    for(std::size_t i = 0; i < size; ++i){
+        h = (h ^ data[i]) * 16777619u;
+    }
+    return h;
+}
+void write_all(int fd, const std::uint8_t* data, std::size_t size){
+    while(size > 0){
+        ssize_t n = ::write(fd, data, size < WRITE_CHUNK ? size : WRITE_CHUNK);
+        if(n < 0){
+            if(errno == EINTR){
+                continue;
+            }
+            throw sys_error("checkpoint write");
+        }
+        data += n;
+        size -= static_cast<std::size_t>(n);
+    }
+}
+// fsync on the directory makes the rename itself durable
+void sync_parent(const std::string& path){
+    std::size_t slash = path.rfind('/');
+    std::string dir = slash == std::string::npos ? "." : (slash == 0 ? "/" : path.substr(0, slash));
+    int fd = ::open(dir.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if(fd >= 0){
+        ::fsync(fd);
+        ::close(fd);
+    }
+}
+}
+
+/**
+ * @brief Replaces the checkpoint at path with the given matches.
+ * @return Bytes written.
+ * @throws std::runtime_error if the file cannot be written or synced; the previous
+ * checkpoint is then left in place.
+ */
+std::size_t Checkpoint::write(const std::string& path, const std::vector<Match*>& matches){
+    std::vector<std::uint8_t> bytes(sizeof(CheckpointHeader));
+    for(Match* m : matches){
+        std::size_t at = bytes.size();
+        bytes.resize(at + 4);
+        m->checkpoint(bytes);
+        std::uint32_t len = static_cast<std::uint32_t>(bytes.size() - at - 4);
+        std::memcpy(bytes.data() + at, &len, 4);
+    }
+    CheckpointHeader header{};
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = VERSION;
+    header.count = static_cast<std::uint32_t>(matches.size());
+    header.checksum = fnv1a(bytes.data() + sizeof(header), bytes.size() - sizeof(header));
+    std::memcpy(bytes.data(), &header, sizeof(header));
+
+    std::string tmp = path + ".tmp";
+    int fd = ::open(tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if(fd < 0){
+        throw sys_error("Cannot create checkpoint " + tmp);
+    }
+    try {
+        write_all(fd, bytes.data(), bytes.size());
+        if(::fsync(fd) != 0){
+            throw sys_error("checkpoint fsync");
+        }
+    } catch (const std::runtime_error&) {
+        ::close(fd);
+        ::unlink(tmp.c_str());
+        throw;
+    }
+    ::close(fd);
+    if(::rename(tmp.c_str(), path.c_str()) != 0){
+        throw sys_error("Cannot replace checkpoint " + path);
+    }
+    sync_parent(path);
+    return bytes.size();
+}
+/**
+ * @brief Loads every match in the checkpoint at path; a missing file is an empty list.
+ * @param threads Threads rebuilding matches (at least one).
+ * @throws std::runtime_error on a bad header, checksum or record.
+ */
+std::vector<std::unique_ptr<Match>> Checkpoint::read(const std::string& path, unsigned threads){
+    std::vector<std::unique_ptr<Match>> matches;
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if(fd < 0){
+        if(errno == ENOENT){
+            return matches;
+        }
+        throw sys_error("Cannot open checkpoint " + path);
+    }
+    struct stat st;
+    if(::fstat(fd, &st) != 0 || static_cast<std::size_t>(st.st_size) < sizeof(CheckpointHeader)){
+        ::close(fd);
+        throw std::runtime_error("Truncated checkpoint: " + path);
+    }
+    std::size_t size = static_cast<std::size_t>(st.st_size);
+    void* map = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if(map == MAP_FAILED){
+        throw sys_error("Cannot map checkpoint " + path);
+    }
+    const std::uint8_t* data = static_cast<const std::uint8_t*>(map);
+    try {
+        CheckpointHeader header;
+        std::memcpy(&header, data, sizeof(header));
+        if(std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0){
+            throw std::runtime_error("Not a checkpoint: " + path);
+        }
+        if(header.version != VERSION){
+            throw std::runtime_error("Unsupported checkpoint version " + std::to_string(header.version));
+        }
+        if(fnv1a(data + sizeof(header), size - sizeof(header)) != header.checksum){
+            throw std::runtime_error("Checkpoint checksum mismatch: " + path);
+        }
+        std::vector<std::size_t> offsets;
+        offsets.reserve(header.count);
+        std::size_t pos = sizeof(header);
+        for(std::uint32_t i = 0; i < header.count; ++i){
+            std::uint32_t len;
+            if(size - pos < 4){
+                throw std::runtime_error("Truncated checkpoint: " + path);
+            }
+            std::memcpy(&len, data + pos, 4);
+            if(size - pos - 4 < len){
+                throw std::runtime_error("Truncated checkpoint: " + path);
+            }
+            offsets.push_back(pos);
+            pos += 4 + len;
+        }
+
+        matches.resize(offsets.size());
+        unsigned workers = threads == 0 ? 1 : threads;
+        if(workers > offsets.size()){
+            workers = offsets.size() == 0 ? 1 : static_cast<unsigned>(offsets.size());
+        }
+        std::vector<std::exception_ptr> errors(workers);
+        auto rebuild = [&](unsigned w){
+            std::size_t begin = offsets.size() * w / workers;
+            std::size_t end = offsets.size() * (w + 1) / workers;
+            try {
+                for(std::size_t i = begin; i < end; ++i){
+                    std::uint32_t len;
+                    std::memcpy(&len, data + offsets[i], 4);
+                    matches[i] = Match::restore(data + offsets[i] + 4, len);
+                }
+            } catch (...) {
+                errors[w] = std::current_exception();
+            }
+        };
+        std::vector<std::thread> pool;
+        for(unsigned w = 1; w < workers; ++w){
+            pool.emplace_back(rebuild, w);
+        }
+        rebuild(0);
+        for(std::thread& t : pool){
+            t.join();
+        }
+        for(std::exception_ptr& e : errors){
+            if(e){
+                std::rethrow_exception(e);
+            }
+        }
+    } catch (...) {
+        ::munmap(map, size);
+        throw;
+    }
+    ::munmap(map, size);
+    return matches;
+}
@@ -0,0 +1,39 @@
+#ifndef CHECKPOINT_HPP
+#define CHECKPOINT_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include "Match.hpp"
+
+/**
+ * @brief File header (16 bytes, host order). checksum is FNV-1a over everything after it.
+ */
+struct CheckpointHeader{
+    char magic[4];
+    std::uint16_t version;
+    std::uint16_t reserved;
+    std::uint32_t count;
+    std::uint32_t checksum;
+};
+static_assert(sizeof(CheckpointHeader) == 16, "CheckpointHeader is an on-disk layout");
+
+/**
+ * @brief Point-in-time copy of a server's live matches: a CheckpointHeader, then per
+ * match a u32 length and that many bytes of Match::checkpoint() output.
+ * write() builds the whole image in memory, streams it to a temporary file in large
+ * writes and commits every match with one fsync before renaming it over the previous
+ * checkpoint, so a crash leaves either the old file or the new one, never a mix.
+ * read() maps the file, indexes the records in one pass and rebuilds the matches on
+ * several threads, since seating the players is most of the cost.
+ */
+class Checkpoint{
+    public:
+        static constexpr std::uint16_t VERSION = 1;
+
+        static std::size_t write(const std::string& path, const std::vector<Match*>& matches);
+        static std::vector<std::unique_ptr<Match>> read(const std::string& path, unsigned threads = 1);
+};
+#endif
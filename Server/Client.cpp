@@ -0,0 +1,85 @@
+#include "Client.hpp"
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+/**
+ * @brief Connects to a server by IPv4 address.
+ * @throws std::runtime_error if the address is invalid or the connection is refused.
+ */
+Client::Client(const std::string& host, std::uint16_t port) : _fd(-1) {
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    if(::inet_pton(AF_INET, host.c_str(), &addr.sin_addr) != 1){
+        throw std::runtime_error("Bad server address: " + host);
+    }
+    _fd = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if(_fd < 0 || ::connect(_fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0){
+        std::string reason = std::strerror(errno);
+        if(_fd >= 0){
+            ::close(_fd);
+        }
+        throw std::runtime_error("Cannot connect to " + host + ": " + reason);
+    }
+    int one = 1;
+    ::setsockopt(_fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+}
+Client::~Client(){
+    ::close(_fd);
+}
+/**
+ * @brief Sends already-encoded frames.
+ * @throws std::runtime_error if the connection is lost.
+ */
+void Client::send(const std::vector<std::uint8_t>& bytes){
+    std::size_t sent = 0;
+    while(sent < bytes.size()){
+        ssize_t n = ::send(_fd, bytes.data() + sent, bytes.size() - sent, MSG_NOSIGNAL);
+        if(n < 0 && errno == EINTR){
+            continue;
+        }
+        if(n <= 0){
+            throw std::runtime_error("Connection lost while sending");
+        }
+        sent += static_cast<std::size_t>(n);
+    }
+}
+/**
+ * @brief Waits up to timeout_ms (-1 forever) for the next frame.
+ * @return false on timeout.
+ * @throws std::runtime_error if the server closes the connection.
+ */
+bool Client::receive(Frame& frame, int timeout_ms){
+    while(!_in.next(frame)){
+        pollfd p{_fd, POLLIN, 0};
+        int ready = ::poll(&p, 1, timeout_ms);
+        if(ready == 0){
+            return false;
+        }
+        if(ready < 0){
+            if(errno == EINTR){
+                continue;
+            }
+            throw std::runtime_error("poll failed");
+        }
+        std::uint8_t buf[4096];
+        ssize_t got = ::recv(_fd, buf, sizeof(buf), 0);
+        if(got <= 0){
+            throw std::runtime_error("Server closed the connection");
+        }
+        _in.append(buf, static_cast<std::size_t>(got));
+    }
+    return true;
+}
+Frame Client::receive(){
+    Frame f;
+    receive(f, -1);
+    return f;
+}
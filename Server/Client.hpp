@@ -0,0 +1,28 @@
+#ifndef CLIENT_HPP
+#define CLIENT_HPP
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "Protocol.hpp"
+
+/**
+ * @brief Blocking TCP client for coup_server, used by tests and tools.
+ */
+class Client{
+    private:
+        int _fd;
+        FrameBuffer _in;
+
+    public:
+        Client(const std::string& host, std::uint16_t port);
+        ~Client();
+        Client(const Client&) = delete;
+        Client& operator=(const Client&) = delete;
+
+        void send(const std::vector<std::uint8_t>& bytes);
+        bool receive(Frame& frame, int timeout_ms);
+        Frame receive();
+        int fd() const { return _fd; }
+};
+#endif
@@ -0,0 +1,114 @@
+#ifndef COMMANDQUEUE_HPP
+#define COMMANDQUEUE_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+
+/**
+ * @brief Bounded lock-free multi-producer single-consumer queue.
+ * Each cell carries a sequence number (Vyukov's bounded queue): a producer claims a slot
+ * with one CAS on the shared enqueue position, writes the value, then publishes it by
+ * bumping the cell's sequence. The one consumer reads cells in order without atomics on
+ * its own position, so draining a batch costs one acquire load per item.
+ * Memory is fixed at construction; a full queue rejects pushes instead of allocating,
+ * which gives the producer a natural point to push back on its client.
+ * @tparam T Default-constructible, movable value.
+ */
+template<typename T>
+class MpscQueue{
+    private:
+        struct Cell{
+            std::atomic<std::size_t> sequence;
+            T value;
+        };
+
+        std::unique_ptr<Cell[]> _cells;
+        std::size_t _mask;
+        alignas(64) std::atomic<std::size_t> _enqueue;
+        alignas(64) std::size_t _dequeue;          // consumer only
+
+    public:
+        /**
+         * @param capacity Rounded up to a power of two.
+         * @throws std::runtime_error if capacity is 0.
+         */
+        explicit MpscQueue(std::size_t capacity) : _enqueue(0), _dequeue(0){
+            if(capacity == 0){
+                throw std::runtime_error("Queue capacity must be positive");
+            }
+            std::size_t size = 1;
+            while(size < capacity){
+                size <<= 1;
+            }
+            _cells = std::make_unique<Cell[]>(size);
+            _mask = size - 1;
+            for(std::size_t i = 0; i < size; ++i){
+                _cells[i].sequence.store(i, std::memory_order_relaxed);
+            }
+        }
+        MpscQueue(const MpscQueue&) = delete;
+        MpscQueue& operator=(const MpscQueue&) = delete;
+
+        /**
+         * @brief Any thread. @return false if the queue is full.
+         */
+        bool try_push(T value){
+            std::size_t pos = _enqueue.load(std::memory_order_relaxed);
+            while(true){
+                Cell& cell = _cells[pos & _mask];
+                std::size_t seq = cell.sequence.load(std::memory_order_acquire);
+                std::intptr_t diff = static_cast<std::intptr_t>(seq) - static_cast<std::intptr_t>(pos);
+                if(diff == 0){
+                    if(_enqueue.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)){
+                        cell.value = std::move(value);
+                        cell.sequence.store(pos + 1, std::memory_order_release);
+                        return true;
+                    }
+                }
+                else if(diff < 0){
+                    return false;                      // the consumer has not freed this cell yet
+                }
+                else{
+                    pos = _enqueue.load(std::memory_order_relaxed);
+                }
+            }
+        }
+        /**
+         * @brief Consumer thread only. @return false if nothing is published yet.
+         */
+        bool try_pop(T& out){
+            Cell& cell = _cells[_dequeue & _mask];
+            if(cell.sequence.load(std::memory_order_acquire) != _dequeue + 1){
+                return false;
+            }
+            out = std::move(cell.value);
+            cell.sequence.store(_dequeue + _mask + 1, std::memory_order_release);
+            _dequeue++;
+            return true;
+        }
+        /**
+         * @brief Consumer thread only: pops up to max items into f, in order.
+         * @return Number of items handled.
+         */
+        template<typename F>
+        std::size_t drain(F&& f, std::size_t max = SIZE_MAX){
+            std::size_t n = 0;
+            T value;
+            while(n < max && try_pop(value)){
+                f(value);
+                n++;
+            }
+            return n;
+        }
+        std::size_t capacity() const { return _mask + 1; }
+        /**
+         * @brief Consumer thread only; a push in flight may land right after.
+         */
+        bool empty() const{
+            return _cells[_dequeue & _mask].sequence.load(std::memory_order_acquire) != _dequeue + 1;
+        }
+};
+#endif
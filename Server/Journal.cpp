@@ -0,0 +1,52 @@
+#include "Journal.hpp"
+#include <vector>
+
+/**
+ * @brief Opens (or continues) the log at path.
+ * @param commit_ms Interval of the loop's commit timer, 0 for none.
+ * @throws std::runtime_error if the log cannot be opened.
+ */
+Journal::Journal(const std::string& path, std::uint32_t commit_ms, std::size_t commit_bytes)
+    : _wal(path, commit_bytes), _commit_ms(commit_ms), _urgent(false)
+{}
+/**
+ * @brief Hands the match's events logged since the last call to the WAL.
+ */
+void Journal::log_changes(Match& m){
+    const std::vector<std::uint8_t>& bytes = m.log().get_bytes();
+    if(m.logged() >= bytes.size()){
+        return;
+    }
+    WalKind kind = m.logged() == 0 ? WalKind::BEGIN : WalKind::EVENTS;
+    _wal.append(kind, m.id(), m.version(), bytes.data() + m.logged(), bytes.size() - m.logged());
+    m.set_logged(bytes.size());
+}
+/**
+ * @brief Logs the state about to be pushed, and the result if the match just finished.
+ * @return Whether the push must wait for the next commit (a result).
+ */
+bool Journal::record(Match& m){
+    log_changes(m);
+    if(!m.finished()){
+        return false;
+    }
+    std::string name = m.game().winner();
+    std::vector<std::uint8_t> body;
+    body.push_back(static_cast<std::uint8_t>(m.game().winner_seat()));
+    body.insert(body.end(), name.begin(), name.end());
+    _wal.append(WalKind::FINISH, m.id(), m.version(), body.data(), body.size());
+    _urgent = true;
+    return true;
+}
+/**
+ * @brief Logs a seat that left a match in play.
+ */
+void Journal::record_forfeit(Match& m, int seat){
+    log_changes(m);
+    std::uint8_t body = static_cast<std::uint8_t>(seat);
+    _wal.append(WalKind::FORFEIT, m.id(), m.version(), &body, 1);
+}
+void Journal::commit(){
+    _wal.commit();
+    _urgent = false;
+}
@@ -0,0 +1,35 @@
+#ifndef JOURNAL_HPP
+#define JOURNAL_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include "Match.hpp"
+#include "Wal.hpp"
+
+/**
+ * @brief What a server loop writes to its write-ahead log, and when it commits.
+ * Each match's new events go in as the loop pushes its state, as do forfeits and results.
+ * The log is group-committed on a timer (commit_ms), once commit_bytes are buffered, and
+ * at the end of any batch that finished a match: a final state is held back from its
+ * players until the commit that covers it is durable.
+ */
+class Journal{
+    private:
+        Wal _wal;
+        std::uint32_t _commit_ms;
+        bool _urgent;                           // a result in the buffer: commit before flushing
+
+    public:
+        Journal(const std::string& path, std::uint32_t commit_ms, std::size_t commit_bytes);
+
+        void log_changes(Match& m);
+        bool record(Match& m);
+        void record_forfeit(Match& m, int seat);
+        bool due() const { return _urgent || _wal.full(); }
+        void commit();
+
+        std::uint32_t commit_ms() const { return _commit_ms; }
+        const Wal& wal() const { return _wal; }
+};
+#endif
@@ -0,0 +1,231 @@
+#include "Match.hpp"
+#include "Protocol.hpp"
+#include "../Engine/Deal.hpp"
+#include "../Engine/Snapshot.hpp"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include "../Players/PlayerFactory.hpp"
+
+Match::Match(std::uint32_t id, int players)
+    : _id(id), _players(players), _logged(0), _version(0), _started(false), _inbox(INBOX_CAPACITY)
+{}
+/**
+ * @brief Binds a connection to the first free seat: one given up by a client that left
+ * the lobby, else the next new one. Names are cut to what a Snapshot holds.
+ * @return The seat index.
+ */
+int Match::join(int conn, const std::string& name){
+    for(std::size_t i = 0; i < _conns.size() && !_started; ++i){
+        if(_conns[i] == LEFT){
+            _conns[i] = conn;
+            _names[i] = name.substr(0, SeatRecord::NAME_CAPACITY);
+            return static_cast<int>(i);
+        }
+    }
+    _conns.push_back(conn);
+    _names.push_back(name.substr(0, SeatRecord::NAME_CAPACITY));
+    return static_cast<int>(_conns.size()) - 1;
+}
+/**
+ * @brief Every seat is bound to a client, so the match can start.
+ */
+bool Match::full() const{
+    return static_cast<int>(_conns.size()) == _players && std::find(_conns.begin(), _conns.end(), LEFT) == _conns.end();
+}
+/**
+ * @brief Deals roles and seats the joined players with STARTING_COINS each.
+ */
+void Match::start(Rng& rng){
+    std::vector<Role> roles = deal_roles(rng, _players);
+    for(int i = 0; i < _players; ++i){
+        Player* p = PlayerFactory::createPlayer(role_name(roles[i]), _game, _names[i]);
+        p->set_coins(STARTING_COINS);
+        _game.get_players().push_back(p);
+    }
+    _game.set_turn(0);
+    _started = true;
+    _log.begin(_game);
+    _game.set_log(&_log);
+    _flow = TurnFlow::play(_game);
+    _version++;
+}
+/**
+ * @brief Plays a seat's turn action; a blockable one leaves the flow waiting on answers.
+ */
+std::uint8_t Match::act(int seat, GameAction action, int target){
+    if(!_started){
+        return static_cast<std::uint8_t>(ServerError::NOT_STARTED);
+    }
+    if(_flow.waiting() == TurnFlow::Waiting::ANSWER){
+        return static_cast<std::uint8_t>(ServerError::REACTION_PENDING);
+    }
+    if(_flow.waiting() != TurnFlow::Waiting::MOVE){
+        return static_cast<std::uint8_t>(MoveStatus::GAME_OVER);
+    }
+    MoveStatus status = _flow.submit({action, seat, target});
+    if(status != MoveStatus::OK){
+        return static_cast<std::uint8_t>(status);
+    }
+    skip_absent();
+    _version++;
+    return 0;
+}
+/**
+ * @brief Blocks or allows for the seat the open reaction window is waiting on.
+ */
+std::uint8_t Match::answer(int seat, bool block){
+    if(_flow.waiting() != TurnFlow::Waiting::ANSWER || _flow.seat() != seat){
+        return static_cast<std::uint8_t>(ServerError::NOT_YOUR_REACTION);
+    }
+    _flow.answer(block);
+    skip_absent();
+    _version++;
+    return 0;
+}
+std::uint8_t Match::apply(const Command& c){
+    if(c.kind == CommandKind::ACT){
+        return act(c.seat, c.action, c.target);
+    }
+    return answer(c.seat, c.kind == CommandKind::BLOCK);
+}
+/**
+ * @brief Deadline passed with nobody answering: the pending blocker allows, or the seat
+ * to move plays its first legal move (Game::first_legal_move).
+ */
+std::uint8_t Match::time_out(){
+    if(!_started || finished()){
+        return static_cast<std::uint8_t>(ServerError::NOT_STARTED);
+    }
+    if(_flow.waiting() == TurnFlow::Waiting::ANSWER){
+        return answer(_flow.seat(), false);
+    }
+    int seat = _game.get_turn();
+    Move m{GameAction::NONE, seat};
+    if(!_game.first_legal_move(seat, m)){
+        _game.pass_stuck_turns();
+        _version++;
+        return 0;
+    }
+    return act(seat, m.action, m.target);
+}
+/**
+ * @brief A client disconnected. In the lobby its seat is free for the next join; in play
+ * the seat forfeits and any answer it owed becomes an allow.
+ */
+void Match::leave(int seat){
+    _conns[seat] = LEFT;
+    if(!_started || finished()){
+        return;
+    }
+    skip_absent();
+    forfeit(seat);
+    if(_flow.waiting() == TurnFlow::Waiting::MOVE){
+        _game.pass_stuck_turns();              // the turn may have passed to a stuck seat
+    }
+    _version++;
+}
+/**
+ * @brief Binds a returning client to its seat in a restored match, checked by name.
+ */
+std::uint8_t Match::rejoin(int seat, int conn, const std::string& name){
+    if(seat < 0 || seat >= static_cast<int>(_conns.size()) || _conns[seat] != RESERVED || _names[seat] != name){
+        return static_cast<std::uint8_t>(ServerError::NO_SUCH_SEAT);
+    }
+    _conns[seat] = conn;
+    return 0;
+}
+/**
+ * @brief Adds a spectator; it takes no seat and does not change the game.
+ */
+void Match::watch(int conn){
+    _spectators.push_back(conn);
+}
+void Match::unwatch(int conn){
+    std::erase(_spectators, conn);
+}
+/**
+ * @brief Deactivates a seat, passing the turn on if it was theirs.
+ */
+void Match::forfeit(int seat){
+    PlayerList& players = _game.get_players();
+    if(!players.is_active(seat)){
+        return;
+    }
+    players[seat]->set_isActive(false);
+    if(_game.get_turn() == seat && !_game.has_winner()){
+        _game.set_isBribe(false);
+        _game.turn_manager();
+    }
+}
+/**
+ * @brief Answers allow for blockers whose clients are gone.
+ */
+void Match::skip_absent(){
+    while(_flow.waiting() == TurnFlow::Waiting::ANSWER && _conns[_flow.seat()] == LEFT){
+        _flow.answer(false);
+    }
+}
+/**
+ * @brief Appends a MatchRecord and the game's Snapshot: everything restore() needs to
+ * carry on from the current version, including a half-answered reaction window.
+ */
+void Match::checkpoint(std::vector<std::uint8_t>& out){
+    MatchRecord r{};
+    r.id = _id;
+    r.version = _version;
+    r.players = static_cast<std::uint8_t>(_players);
+    r.action = static_cast<std::uint8_t>(GameAction::NONE);
+    r.target = NO_SEAT;
+    const Reaction& reaction = _flow.reaction();
+    if(_flow.waiting() == TurnFlow::Waiting::ANSWER){
+        r.action = static_cast<std::uint8_t>(reaction.get_action());
+        r.actor = static_cast<std::uint8_t>(reaction.get_actor());
+        r.target = reaction.get_target() < 0 ? NO_SEAT : static_cast<std::uint8_t>(reaction.get_target());
+        r.pending = reaction.get_pending();
+    }
+    std::size_t at = out.size();
+    out.resize(at + sizeof(r) + Snapshot::size(_game));
+    std::memcpy(out.data() + at, &r, sizeof(r));
+    Snapshot::save(_game, out.data() + at + sizeof(r), out.size() - at - sizeof(r));
+}
+/**
+ * @brief Rebuilds a started match from one checkpoint() record. Every seat comes back
+ * RESERVED for rejoin(); deadlines keep an abandoned match moving.
+ * @throws std::runtime_error if the record is malformed.
+ */
+std::unique_ptr<Match> Match::restore(const std::uint8_t* data, std::size_t size){
+    MatchRecord r;
+    if(size < sizeof(r)){
+        throw std::runtime_error("Truncated match record");
+    }
+    std::memcpy(&r, data, sizeof(r));
+    if(r.players < 2 || r.players > PlayerList::CAPACITY){
+        throw std::runtime_error("Bad table size in match record");
+    }
+    auto m = std::make_unique<Match>(r.id, r.players);
+    Snapshot::load(m->_game, data + sizeof(r), size - sizeof(r));
+    PlayerList& players = m->_game.get_players();
+    if(static_cast<int>(players.size()) != r.players){
+        throw std::runtime_error("Match record and snapshot disagree on the table size");
+    }
+    for(std::size_t i = 0; i < players.size(); ++i){
+        m->_names.push_back(players[i]->get_name());
+        m->_conns.push_back(RESERVED);
+    }
+    Reaction open;
+    GameAction action = static_cast<GameAction>(r.action);
+    if(action != GameAction::NONE){
+        if(r.actor >= r.players || (action != GameAction::TAX && action != GameAction::BRIBE && action != GameAction::COUP)){
+            throw std::runtime_error("Bad reaction window in match record");
+        }
+        open = Reaction(m->_game, action, r.actor, r.target == NO_SEAT ? -1 : r.target);
+        open.set_pending(r.pending);
+    }
+    m->_log.begin(m->_game);                   // the WAL restarts this match's log from here
+    m->_game.set_log(&m->_log);
+    m->_version = r.version;
+    m->_started = true;
+    m->_flow = TurnFlow::play(m->_game, open);
+    return m;
+}
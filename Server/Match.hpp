@@ -0,0 +1,126 @@
+#ifndef MATCH_HPP
+#define MATCH_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include "../Game.hpp"
+#include "../Engine/EventLog.hpp"
+#include "../Engine/Reaction.hpp"
+#include "../Engine/Rng.hpp"
+#include "../Engine/TurnFlow.hpp"
+#include "CommandQueue.hpp"
+
+enum class CommandKind : std::uint8_t{
+    ACT,
+    BLOCK,
+    ALLOW,
+};
+
+/**
+ * @brief A player's request, queued for the thread that owns the match.
+ * tag is opaque to the match and handed back with the result (the server puts the
+ * connection there; benchmarks put a timestamp).
+ */
+struct Command{
+    CommandKind kind = CommandKind::ACT;
+    int seat = -1;
+    GameAction action = GameAction::NONE;
+    int target = -1;
+    std::uint64_t tag = 0;
+};
+
+/**
+ * @brief Fixed part of a checkpointed match (24 bytes, host order), followed by the
+ * game's Snapshot blob.
+ */
+struct MatchRecord{
+    std::uint32_t id;
+    std::uint32_t version;
+    std::uint8_t players;
+    std::uint8_t action;      // action of the open reaction window, NONE if there is none
+    std::uint8_t actor;
+    std::uint8_t target;      // 0xff for none
+    std::uint32_t reserved;
+    std::uint64_t pending;    // blockers still owed an answer
+};
+static_assert(sizeof(MatchRecord) == 24, "MatchRecord is an on-disk layout");
+
+/**
+ * @brief One hosted game: its own Game, the connection bound to each seat and the
+ * TurnFlow that holds whose move or answer the game is waiting on between messages.
+ * Knows nothing about sockets; the server maps results to messages.
+ * Methods return 0 on success, otherwise a MoveStatus or ServerError code.
+ * Any thread may post() commands; only the owning thread drains and applies them.
+ */
+class Match{
+    private:
+        std::uint32_t _id;
+        int _players;
+        Game _game;
+        EventLog _log;                         // every move and answer since start (or restore)
+        std::size_t _logged;                   // bytes of _log already handed to the WAL
+        TurnFlow _flow;                        // after _game: its frame points into it
+        std::vector<int> _conns;               // per seat: connection, LEFT or RESERVED
+        std::vector<std::string> _names;
+        std::vector<int> _spectators;
+        std::uint32_t _version;
+        bool _started;
+        MpscQueue<Command> _inbox;
+
+        void forfeit(int seat);
+        void skip_absent();
+
+    public:
+        static constexpr std::size_t INBOX_CAPACITY = 16;
+        static constexpr int LEFT = -1;        // the client left: free again in the lobby, forfeited once started
+        static constexpr int RESERVED = -2;    // restored from a checkpoint, held for its client
+
+
+        Match(std::uint32_t id, int players);
+        Match(const Match&) = delete;
+        Match& operator=(const Match&) = delete;
+
+        int join(int conn, const std::string& name);
+        void start(Rng& rng);
+        std::uint8_t act(int seat, GameAction action, int target);
+        std::uint8_t answer(int seat, bool block);
+        void leave(int seat);
+        std::uint8_t rejoin(int seat, int conn, const std::string& name);
+        std::uint8_t apply(const Command& c);
+        std::uint8_t time_out();
+        /**
+         * @brief Thread-safe. @return false if the inbox is full.
+         */
+        bool post(const Command& c){ return _inbox.try_push(c); }
+        /**
+         * @brief Owning thread: applies up to max queued commands in arrival order and
+         * calls done(command, result code) after each.
+         * @return Number of commands applied.
+         */
+        template<typename F>
+        std::size_t drain(F&& done, std::size_t max = SIZE_MAX){
+            return _inbox.drain([&](const Command& c){ done(c, apply(c)); }, max);
+        }
+        void watch(int conn);
+        void unwatch(int conn);
+        void checkpoint(std::vector<std::uint8_t>& out);
+        static std::unique_ptr<Match> restore(const std::uint8_t* data, std::size_t size);
+
+        std::uint32_t id() const { return _id; }
+        bool full() const;
+        bool started() const { return _started; }
+        bool finished() const { return _started && _game.has_winner(); }
+        std::uint32_t version() const { return _version; }
+        int players() const { return _players; }
+        const std::vector<int>& conns() const { return _conns; }
+        const std::vector<int>& spectators() const { return _spectators; }
+        Game& game() { return _game; }
+        const EventLog& log() const { return _log; }
+        std::size_t logged() const { return _logged; }
+        void set_logged(std::size_t bytes) { _logged = bytes; }
+        const Reaction& reaction() const { return _flow.reaction(); }
+};
+#endif
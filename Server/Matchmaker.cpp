@@ -0,0 +1,66 @@
+#include "Matchmaker.hpp"
+#include <algorithm>
+#include <stdexcept>
+
+/**
+ * @throws std::runtime_error if bucket_width is not positive.
+ */
+Matchmaker::Matchmaker(int bucket_width, std::uint32_t widen_ms)
+    : _bucket_width(bucket_width), _widen_ms(widen_ms), _waiting(0), _serial(0), _formed(0), _seated(0), _waited(0)
+{
+    if(bucket_width <= 0){
+        throw std::runtime_error("Rating bucket width must be positive");
+    }
+}
+/**
+ * @brief Queues a ticket for the next tick.
+ * @throws std::runtime_error on a seat count outside 2..CAPACITY.
+ */
+void Matchmaker::enqueue(const Ticket& ticket){
+    if(ticket.seats < 2 || ticket.seats > PlayerList::CAPACITY){
+        throw std::runtime_error("Table size out of range");
+    }
+    _queues[ticket.seats].push_back(ticket);
+    _queues[ticket.seats].back().serial = _serial++;
+    _waiting++;
+}
+/**
+ * @brief Withdraws the tickets queued so far with this tag (a client that left before
+ * being seated); one it queues after this call stands.
+ */
+void Matchmaker::cancel(std::uint64_t tag){
+    _cancelled[tag] = _serial;
+}
+std::size_t Matchmaker::waiting(int seats) const{
+    return seats >= 2 && seats <= PlayerList::CAPACITY ? _queues[seats].size() : 0;
+}
+/**
+ * @brief Mean ticks a seated ticket waited, 0 before the first table.
+ */
+double Matchmaker::mean_wait() const{
+    return _seated == 0 ? 0.0 : static_cast<double>(_waited) / static_cast<double>(_seated);
+}
+int Matchmaker::tolerance(const Ticket& t, std::uint64_t now) const{
+    std::uint64_t widened = _widen_ms == 0 ? 0 : (now - t.since) / _widen_ms;
+    return _bucket_width * static_cast<int>(std::min<std::uint64_t>(widened + 1, 1000));
+}
+void Matchmaker::drop_cancelled(std::vector<Ticket>& queue){
+    if(_cancelled.empty()){
+        return;
+    }
+    std::size_t before = queue.size();
+    queue.erase(std::remove_if(queue.begin(), queue.end(), [this](const Ticket& t){
+        auto it = _cancelled.find(t.tag);
+        return it != _cancelled.end() && t.serial < it->second;
+    }), queue.end());
+    _waiting -= before - queue.size();
+}
+void Matchmaker::sort_by_bucket(std::vector<Ticket>& queue) const{
+    std::stable_sort(queue.begin(), queue.end(), [this](const Ticket& a, const Ticket& b){
+        int ba = bucket(a.rating), bb = bucket(b.rating);
+        return ba != bb ? ba < bb : a.since < b.since;
+    });
+}
+void Matchmaker::sort_by_rating(std::vector<Ticket>& queue){
+    std::stable_sort(queue.begin(), queue.end(), [](const Ticket& a, const Ticket& b){ return a.rating < b.rating; });
+}
@@ -0,0 +1,133 @@
+#ifndef MATCHMAKER_HPP
+#define MATCHMAKER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "../PlayerList.hpp"
+
+/**
+ * @brief A player waiting for a match. tag is opaque to the matchmaker and handed back
+ * with the group (the server puts the connection in it).
+ */
+struct Ticket{
+    std::uint64_t tag = 0;
+    std::string name;
+    int rating = 0;
+    int seats = 0;
+    std::uint64_t since = 0;            // tick it was queued
+    std::uint64_t serial = 0;           // set by enqueue(), so a cancel spares later tickets of its tag
+};
+
+/**
+ * @brief Batched matchmaking: tickets queue by seat count and are grouped once per tick().
+ * A tick sorts each queue by rating bucket (rating / bucket_width), then by waiting time,
+ * and first fills whole tables inside each bucket, oldest tickets first. What is left is
+ * scanned in rating order for tables whose spread every member tolerates: one bucket width
+ * to start with, and one more for every widen_ms waited, so nobody waits forever in a thin
+ * bucket but nobody new is thrown in with players far from their rating either.
+ * Cancelled tickets are dropped lazily at the next tick; a cancel only covers the tickets
+ * its tag had queued by then, so a player may cancel and queue again within one tick.
+ */
+class Matchmaker{
+    private:
+        std::vector<Ticket> _queues[PlayerList::CAPACITY + 1];    // by seat count
+        std::vector<Ticket> _left;
+        std::vector<Ticket> _group;
+        std::unordered_map<std::uint64_t, std::uint64_t> _cancelled;    // tag: first serial it spares
+        int _bucket_width;
+        std::uint32_t _widen_ms;
+        std::size_t _waiting;
+        std::uint64_t _serial;
+        std::uint64_t _formed;
+        std::uint64_t _seated;
+        std::uint64_t _waited;                  // ticks waited by every ticket seated so far
+
+        int bucket(int rating) const { return rating / _bucket_width; }
+        int tolerance(const Ticket& t, std::uint64_t now) const;
+        void drop_cancelled(std::vector<Ticket>& queue);
+        void sort_by_bucket(std::vector<Ticket>& queue) const;
+        static void sort_by_rating(std::vector<Ticket>& queue);
+        template<typename F>
+        void seat(std::vector<Ticket>& from, std::size_t at, int seats, std::uint64_t now, F& form){
+            _group.assign(from.begin() + static_cast<std::ptrdiff_t>(at), from.begin() + static_cast<std::ptrdiff_t>(at + seats));
+            for(const Ticket& t : _group){
+                _waited += now - t.since;
+            }
+            _waiting -= static_cast<std::size_t>(seats);
+            _seated += static_cast<std::uint64_t>(seats);
+            _formed++;
+            form(_group);
+        }
+
+    public:
+        static constexpr int DEFAULT_RATING = 1500;
+        static constexpr int DEFAULT_BUCKET_WIDTH = 100;
+        static constexpr std::uint32_t DEFAULT_WIDEN_MS = 2000;
+
+        explicit Matchmaker(int bucket_width = DEFAULT_BUCKET_WIDTH, std::uint32_t widen_ms = DEFAULT_WIDEN_MS);
+
+        void enqueue(const Ticket& ticket);
+        void cancel(std::uint64_t tag);
+
+        /**
+         * @brief Forms every table it can from the tickets queued so far; form(group) is
+         * called with each one, in seat order, and must not enqueue() from inside the call.
+         * @param now Current tick, in the same units as Ticket::since.
+         * @return Number of tables formed.
+         */
+        template<typename F>
+        std::size_t tick(std::uint64_t now, F&& form){
+            std::uint64_t before = _formed;
+            for(int seats = 2; seats <= PlayerList::CAPACITY; ++seats){
+                std::vector<Ticket>& queue = _queues[seats];
+                drop_cancelled(queue);
+                if(queue.size() < static_cast<std::size_t>(seats)){
+                    continue;
+                }
+                sort_by_bucket(queue);
+                _left.clear();
+                std::size_t run = 0;
+                while(run < queue.size()){
+                    std::size_t end = run;
+                    while(end < queue.size() && bucket(queue[end].rating) == bucket(queue[run].rating)){
+                        ++end;
+                    }
+                    std::size_t full = run + (end - run) / seats * seats;
+                    for(std::size_t at = run; at < full; at += seats){
+                        seat(queue, at, seats, now, form);
+                    }
+                    _left.insert(_left.end(), queue.begin() + static_cast<std::ptrdiff_t>(full), queue.begin() + static_cast<std::ptrdiff_t>(end));
+                    run = end;
+                }
+                queue.clear();
+                sort_by_rating(_left);
+                std::size_t at = 0;
+                while(at + seats <= _left.size()){
+                    int spread = _left[at + seats - 1].rating - _left[at].rating;
+                    bool fits = true;
+                    for(std::size_t i = at; i < at + seats && fits; ++i){
+                        fits = spread <= tolerance(_left[i], now);
+                    }
+                    if(fits){
+                        seat(_left, at, seats, now, form);
+                        at += seats;
+                    }
+                    else{
+                        queue.push_back(_left[at++]);
+                    }
+                }
+                queue.insert(queue.end(), _left.begin() + static_cast<std::ptrdiff_t>(at), _left.end());
+            }
+            _cancelled.clear();
+            return static_cast<std::size_t>(_formed - before);
+        }
+
+        std::size_t waiting() const { return _waiting; }
+        std::size_t waiting(int seats) const;
+        std::uint64_t formed() const { return _formed; }
+        double mean_wait() const;
+};
+#endif
@@ -0,0 +1,9 @@
+#include "Matchmaking.hpp"
+
+/**
+ * @param tick_ms Ticks apart, at least 1.
+ * @throws std::runtime_error if bucket_width is not positive.
+ */
+Matchmaking::Matchmaking(std::uint32_t tick_ms, int bucket_width, std::uint32_t widen_ms)
+    : _matchmaker(bucket_width, widen_ms), _tick_ms(tick_ms == 0 ? 1 : tick_ms)
+{}
@@ -0,0 +1,57 @@
+#ifndef MATCHMAKING_HPP
+#define MATCHMAKING_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "Matchmaker.hpp"
+
+/**
+ * @brief A server loop's matchmaking: JOINs queue as tickets in a Matchmaker ticked every
+ * tick_ms, and a formed table is only passed on if every player on it is still waiting.
+ * When someone left in the meantime, the others are queued again once the tick is over,
+ * keeping the time they were first queued.
+ */
+class Matchmaking{
+    private:
+        Matchmaker _matchmaker;
+        std::uint32_t _tick_ms;
+        std::vector<Ticket> _requeue;
+
+    public:
+        Matchmaking(std::uint32_t tick_ms, int bucket_width, std::uint32_t widen_ms);
+
+        void enqueue(const Ticket& ticket) { _matchmaker.enqueue(ticket); }
+        void cancel(std::uint64_t tag) { _matchmaker.cancel(tag); }
+        /**
+         * @brief Forms this tick's tables and calls form(group) with each one whose players
+         * all pass waiting(tag).
+         * @return Number of tables passed to form.
+         */
+        template<typename W, typename F>
+        std::size_t tick(std::uint64_t now, W&& waiting, F&& form){
+            std::size_t formed = 0;
+            _matchmaker.tick(now, [&](const std::vector<Ticket>& group){
+                if(std::all_of(group.begin(), group.end(), [&](const Ticket& t){ return waiting(t.tag); })){
+                    form(group);
+                    formed++;
+                    return;
+                }
+                for(const Ticket& t : group){
+                    if(waiting(t.tag)){
+                        _requeue.push_back(t);
+                    }
+                }
+            });
+            for(const Ticket& t : _requeue){
+                _matchmaker.enqueue(t);
+            }
+            _requeue.clear();
+            return formed;
+        }
+
+        std::uint32_t tick_ms() const { return _tick_ms; }
+        const Matchmaker& matchmaker() const { return _matchmaker; }
+};
+#endif
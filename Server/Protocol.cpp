@@ -0,0 +1,395 @@
+#include "Protocol.hpp"
+#include "../Game.hpp"
+#include "../Engine/Reaction.hpp"
+#include <stdexcept>
+
+namespace {
+void put_u8(std::vector<std::uint8_t>& out, unsigned v){
+    out.push_back(static_cast<std::uint8_t>(v));
+}
+void put_u16(std::vector<std::uint8_t>& out, unsigned v){
+    put_u8(out, v & 0xff);
+    put_u8(out, (v >> 8) & 0xff);
+}
+void put_u32(std::vector<std::uint8_t>& out, std::uint32_t v){
+    put_u16(out, v & 0xffff);
+    put_u16(out, v >> 16);
+}
+// Reserves the length prefix and type byte; finish_frame fills the length in
+std::size_t start_frame(std::vector<std::uint8_t>& out, MsgType type){
+    std::size_t at = out.size();
+    put_u32(out, 0);
+    put_u8(out, static_cast<unsigned>(type));
+    return at;
+}
+void finish_frame(std::vector<std::uint8_t>& out, std::size_t at){
+    std::uint32_t len = static_cast<std::uint32_t>(out.size() - at - 4);
+    for(int i = 0; i < 4; ++i){
+        out[at + i] = static_cast<std::uint8_t>(len >> (8 * i));
+    }
+}
+std::uint8_t seat_byte(int seat){
+    return seat < 0 ? NO_SEAT : static_cast<std::uint8_t>(seat);
+}
+int seat_value(std::uint8_t b){
+    return b == NO_SEAT ? -1 : b;
+}
+
+/**
+ * @brief Bounds-checked cursor over a frame payload.
+ */
+class PayloadReader{
+    private:
+        const std::vector<std::uint8_t>& _p;
+        std::size_t _pos;
+
+    public:
+        explicit PayloadReader(const Frame& f) : _p(f.payload), _pos(0) {}
+        std::uint8_t u8(){
+            if(_pos >= _p.size()){
+                throw std::runtime_error("Truncated message");
+            }
+            return _p[_pos++];
+        }
+        unsigned u16(){
+            unsigned lo = u8();
+            return lo | (static_cast<unsigned>(u8()) << 8);
+        }
+        std::uint32_t u32(){
+            std::uint32_t lo = u16();
+            return lo | (static_cast<std::uint32_t>(u16()) << 16);
+        }
+        std::size_t left() const{
+            return _p.size() - _pos;
+        }
+        std::string text(std::size_t len){
+            if(_p.size() - _pos < len){
+                throw std::runtime_error("Truncated message");
+            }
+            std::string s(reinterpret_cast<const char*>(_p.data() + _pos), len);
+            _pos += len;
+            return s;
+        }
+};
+void expect(const Frame& f, MsgType type){
+    if(f.type != type){
+        throw std::runtime_error("Unexpected message type " + std::to_string(static_cast<int>(f.type)));
+    }
+}
+}
+
+void put_join(std::vector<std::uint8_t>& out, int players, const std::string& name, int rating){
+    std::size_t at = start_frame(out, MsgType::JOIN);
+    put_u8(out, static_cast<unsigned>(players));
+    std::size_t len = name.size() < 255 ? name.size() : 255;
+    put_u8(out, static_cast<unsigned>(len));
+    out.insert(out.end(), name.begin(), name.begin() + static_cast<std::ptrdiff_t>(len));
+    if(rating >= 0){
+        put_u16(out, static_cast<unsigned>(rating > 0xffff ? 0xffff : rating));
+    }
+    finish_frame(out, at);
+}
+void put_act(std::vector<std::uint8_t>& out, GameAction action, int target){
+    std::size_t at = start_frame(out, MsgType::ACT);
+    put_u8(out, static_cast<unsigned>(action));
+    put_u8(out, seat_byte(target));
+    finish_frame(out, at);
+}
+void put_empty(std::vector<std::uint8_t>& out, MsgType type){
+    finish_frame(out, start_frame(out, type));
+}
+void put_joined(std::vector<std::uint8_t>& out, std::uint32_t match, int seat, int players){
+    std::size_t at = start_frame(out, MsgType::JOINED);
+    put_u32(out, match);
+    put_u8(out, seat_byte(seat));
+    put_u8(out, static_cast<unsigned>(players));
+    finish_frame(out, at);
+}
+void put_ack(std::vector<std::uint8_t>& out, std::uint32_t version){
+    std::size_t at = start_frame(out, MsgType::ACK);
+    put_u32(out, version);
+    finish_frame(out, at);
+}
+void put_watch(std::vector<std::uint8_t>& out, std::uint32_t match){
+    std::size_t at = start_frame(out, MsgType::WATCH);
+    put_u32(out, match);
+    finish_frame(out, at);
+}
+void put_resume(std::vector<std::uint8_t>& out, std::uint32_t match, int seat, const std::string& name){
+    std::size_t at = start_frame(out, MsgType::RESUME);
+    put_u32(out, match);
+    put_u8(out, seat_byte(seat));
+    std::size_t len = name.size() < 255 ? name.size() : 255;
+    put_u8(out, static_cast<unsigned>(len));
+    out.insert(out.end(), name.begin(), name.begin() + static_cast<std::ptrdiff_t>(len));
+    finish_frame(out, at);
+}
+/**
+ * @brief Reads the table straight from the per-seat arrays.
+ * @param reaction Window of the last action; its current blocker is told to answer.
+ */
+StateMsg make_state(std::uint32_t match, std::uint32_t version, Game& game, const Reaction& reaction){
+    PlayerList& players = game.get_players();
+    StateMsg m;
+    m.match = match;
+    m.version = version;
+    m.turn = game.get_turn();
+    m.bribe = game.get_isBribe();
+    m.winner = game.winner_seat();
+    if(reaction.is_open()){
+        m.pending = reaction.get_action();
+        m.blocker = reaction.current_blocker();
+    }
+    m.seats.resize(players.size());
+    for(std::size_t i = 0; i < players.size(); ++i){
+        int seat = static_cast<int>(i);
+        SeatMask bit = seat_bit(seat);
+        SeatView& v = m.seats[i];
+        v.role = players.role(seat);
+        v.flags = static_cast<std::uint8_t>(((players.active_mask() & bit) ? 1u : 0u) | ((players.sanction_mask() & bit) ? 2u : 0u) |
+                                            ((players.can_arrest_mask() & bit) ? 4u : 0u) | ((players.arrested_mask() & bit) ? 8u : 0u));
+        v.coins = players.coins(seat);
+    }
+    return m;
+}
+void put_state(std::vector<std::uint8_t>& out, const StateMsg& state){
+    std::size_t at = start_frame(out, MsgType::STATE);
+    put_u32(out, state.match);
+    put_u32(out, state.version);
+    put_u8(out, seat_byte(state.turn));
+    put_u8(out, state.bribe ? 1 : 0);
+    put_u8(out, seat_byte(state.winner));
+    put_u8(out, static_cast<unsigned>(state.pending));
+    put_u8(out, seat_byte(state.blocker));
+    put_u8(out, static_cast<unsigned>(state.seats.size()));
+    for(const SeatView& v : state.seats){
+        put_u8(out, static_cast<unsigned>(v.role));
+        put_u8(out, v.flags);
+        put_u16(out, static_cast<unsigned>(v.coins));
+    }
+    finish_frame(out, at);
+}
+void put_state(std::vector<std::uint8_t>& out, std::uint32_t match, std::uint32_t version, Game& game, const Reaction& reaction){
+    put_state(out, make_state(match, version, game, reaction));
+}
+/**
+ * @throws std::runtime_error if the states are from different tables.
+ */
+StateDiff diff_states(const StateMsg& from, const StateMsg& to){
+    if(from.match != to.match || from.seats.size() != to.seats.size()){
+        throw std::runtime_error("Delta between different tables");
+    }
+    StateDiff d;
+    d.fields = (from.turn != to.turn ? StateDiff::TURN : 0u) | (from.bribe != to.bribe ? StateDiff::BRIBE : 0u) |
+               (from.winner != to.winner ? StateDiff::WINNER : 0u) |
+               ((from.pending != to.pending || from.blocker != to.blocker) ? StateDiff::REACTION : 0u);
+    for(std::size_t i = 0; i < to.seats.size(); ++i){
+        if(from.seats[i].flags != to.seats[i].flags || from.seats[i].coins != to.seats[i].coins){
+            d.seats |= seat_bit(static_cast<int>(i));
+        }
+    }
+    return d;
+}
+/**
+ * @brief Encodes the fields of `to` named by diff as a DELTA frame:
+ * u32 match, u32 base version, u32 version, u8 field mask, the masked fields
+ * (u8 turn, u8 bribe, u8 winner, u8 pending + u8 blocker), u8 count, then per
+ * changed seat u8 seat, u8 flags, u16 coins. Values are absolute and diff must cover
+ * every version after base, so the delta brings any state from base onwards up to date.
+ */
+void put_delta(std::vector<std::uint8_t>& out, std::uint32_t base, const StateMsg& to, const StateDiff& diff){
+    std::size_t at = start_frame(out, MsgType::DELTA);
+    put_u32(out, to.match);
+    put_u32(out, base);
+    put_u32(out, to.version);
+    put_u8(out, diff.fields);
+    if(diff.fields & StateDiff::TURN){
+        put_u8(out, seat_byte(to.turn));
+    }
+    if(diff.fields & StateDiff::BRIBE){
+        put_u8(out, to.bribe ? 1 : 0);
+    }
+    if(diff.fields & StateDiff::WINNER){
+        put_u8(out, seat_byte(to.winner));
+    }
+    if(diff.fields & StateDiff::REACTION){
+        put_u8(out, static_cast<unsigned>(to.pending));
+        put_u8(out, seat_byte(to.blocker));
+    }
+    SeatMask seats = diff.seats & (to.seats.size() >= 64 ? ~SeatMask(0) : seat_bit(static_cast<int>(to.seats.size())) - 1);
+    put_u8(out, static_cast<unsigned>(mask_count(seats)));
+    for(; seats != 0; seats &= seats - 1){
+        int seat = mask_first(seats);
+        put_u8(out, static_cast<unsigned>(seat));
+        put_u8(out, to.seats[seat].flags);
+        put_u16(out, static_cast<unsigned>(to.seats[seat].coins));
+    }
+    finish_frame(out, at);
+}
+void put_delta(std::vector<std::uint8_t>& out, const StateMsg& from, const StateMsg& to){
+    put_delta(out, from.version, to, diff_states(from, to));
+}
+void put_error(std::vector<std::uint8_t>& out, std::uint8_t code, const std::string& text){
+    std::size_t at = start_frame(out, MsgType::ERROR);
+    put_u8(out, code);
+    std::size_t len = text.size() < 255 ? text.size() : 255;
+    put_u8(out, static_cast<unsigned>(len));
+    out.insert(out.end(), text.begin(), text.begin() + static_cast<std::ptrdiff_t>(len));
+    finish_frame(out, at);
+}
+
+JoinedMsg read_joined(const Frame& f){
+    expect(f, MsgType::JOINED);
+    PayloadReader r(f);
+    JoinedMsg m;
+    m.match = r.u32();
+    m.seat = seat_value(r.u8());
+    m.players = r.u8();
+    return m;
+}
+StateMsg read_state(const Frame& f){
+    expect(f, MsgType::STATE);
+    PayloadReader r(f);
+    StateMsg m;
+    m.match = r.u32();
+    m.version = r.u32();
+    m.turn = seat_value(r.u8());
+    m.bribe = r.u8() != 0;
+    m.winner = seat_value(r.u8());
+    m.pending = static_cast<GameAction>(r.u8());
+    m.blocker = seat_value(r.u8());
+    m.seats.resize(r.u8());
+    for(SeatView& s : m.seats){
+        s.role = static_cast<Role>(r.u8());
+        s.flags = r.u8();
+        s.coins = static_cast<int>(r.u16());
+    }
+    return m;
+}
+std::uint32_t read_ack(const Frame& f){
+    expect(f, MsgType::ACK);
+    PayloadReader r(f);
+    return r.u32();
+}
+std::uint32_t read_watch(const Frame& f){
+    expect(f, MsgType::WATCH);
+    PayloadReader r(f);
+    return r.u32();
+}
+JoinMsg read_join(const Frame& f){
+    expect(f, MsgType::JOIN);
+    PayloadReader r(f);
+    JoinMsg m;
+    m.players = r.u8();
+    m.name = r.text(r.u8());
+    m.rating = r.left() > 0 ? static_cast<int>(r.u16()) : -1;
+    if(r.left() > 0){
+        throw std::runtime_error("Bad JOIN payload");
+    }
+    return m;
+}
+ResumeMsg read_resume(const Frame& f){
+    expect(f, MsgType::RESUME);
+    PayloadReader r(f);
+    ResumeMsg m;
+    m.match = r.u32();
+    m.seat = seat_value(r.u8());
+    m.name = r.text(r.u8());
+    return m;
+}
+/**
+ * @brief Applies a DELTA frame to the client's copy of the table.
+ * @return false if the delta is for another match or starts after state.version;
+ * the state is left untouched and the client should wait for a full STATE.
+ * @throws std::runtime_error on a malformed frame.
+ */
+bool apply_delta(StateMsg& state, const Frame& f){
+    expect(f, MsgType::DELTA);
+    PayloadReader r(f);
+    std::uint32_t match = r.u32();
+    std::uint32_t base = r.u32();
+    std::uint32_t version = r.u32();
+    if(match != state.match || base > state.version || version < state.version){
+        return false;
+    }
+    StateMsg next = state;
+    next.version = version;
+    unsigned fields = r.u8();
+    if(fields & StateDiff::TURN){
+        next.turn = seat_value(r.u8());
+    }
+    if(fields & StateDiff::BRIBE){
+        next.bribe = r.u8() != 0;
+    }
+    if(fields & StateDiff::WINNER){
+        next.winner = seat_value(r.u8());
+    }
+    if(fields & StateDiff::REACTION){
+        next.pending = static_cast<GameAction>(r.u8());
+        next.blocker = seat_value(r.u8());
+    }
+    for(unsigned count = r.u8(); count > 0; --count){
+        std::size_t seat = r.u8();
+        if(seat >= next.seats.size()){
+            throw std::runtime_error("Delta seat out of range");
+        }
+        next.seats[seat].flags = r.u8();
+        next.seats[seat].coins = static_cast<int>(r.u16());
+    }
+    state = std::move(next);
+    return true;
+}
+ErrorMsg read_error(const Frame& f){
+    expect(f, MsgType::ERROR);
+    PayloadReader r(f);
+    ErrorMsg m;
+    m.code = r.u8();
+    m.text = r.text(r.u8());
+    return m;
+}
+
+FrameBuffer::FrameBuffer() : _read(0) {}
+
+void FrameBuffer::append(const std::uint8_t* data, std::size_t size){
+    if(_read > 0 && _read == _bytes.size()){
+        _bytes.clear();
+        _read = 0;
+    }
+    _bytes.insert(_bytes.end(), data, data + size);
+}
+/**
+ * @brief Pops the next complete frame.
+ * @return false if more bytes are needed.
+ */
+bool FrameBuffer::next(Frame& frame){
+    std::size_t available = _bytes.size() - _read;
+    if(available < 4){
+        return false;
+    }
+    const std::uint8_t* p = _bytes.data() + _read;
+    std::uint32_t len = static_cast<std::uint32_t>(p[0]) | (static_cast<std::uint32_t>(p[1]) << 8) |
+                        (static_cast<std::uint32_t>(p[2]) << 16) | (static_cast<std::uint32_t>(p[3]) << 24);
+    if(len == 0 || len > MAX_FRAME){
+        throw std::runtime_error("Bad frame length " + std::to_string(len));
+    }
+    if(available < 4 + static_cast<std::size_t>(len)){
+        return false;
+    }
+    frame.type = static_cast<MsgType>(p[4]);
+    frame.payload.assign(p + 5, p + 4 + len);
+    _read += 4 + len;
+    if(_read > 4096 && _read * 2 > _bytes.size()){
+        _bytes.erase(_bytes.begin(), _bytes.begin() + static_cast<std::ptrdiff_t>(_read));
+        _read = 0;
+    }
+    return true;
+}
+std::size_t FrameBuffer::buffered() const{
+    return _bytes.size() - _read;
+}
+/**
+ * @brief The buffered() bytes not yet returned as frames.
+ */
+const std::uint8_t* FrameBuffer::unread() const{
+    return _bytes.data() + _read;
+}
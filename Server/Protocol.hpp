@@ -0,0 +1,176 @@
+#ifndef PROTOCOL_HPP
+#define PROTOCOL_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "../Move.hpp"
+#include "../PlayerList.hpp"
+#include "../Role.hpp"
+
+class Game;
+class Reaction;
+
+/**
+ * Wire format shared by coup_server and its clients. Every message is a frame:
+ * a little-endian u32 length, then that many bytes: a type byte and its payload.
+ *
+ *   JOIN    u8 table size, u8 name length, name,     client -> server
+ *           [u16 rating] (for matchmaking)
+ *   ACT     u8 action, u8 target (0xff for none)     client -> server
+ *   BLOCK   (empty)                                   client -> server
+ *   ALLOW   (empty)                                   client -> server
+ *   ACK     u32 version of the last state applied      client -> server
+ *   WATCH   u32 match to spectate                     client -> server
+ *   RESUME  u32 match, u8 seat, u8 name length, name  client -> server
+ *           (takes a seat back after a server restart)
+ *   JOINED  u32 match, u8 seat, u8 table size         server -> client
+ *           (seat 0xff for a spectator)
+ *   STATE   see StateMsg                              server -> client
+ *   DELTA   see put_delta                             server -> client
+ *   ERROR   u8 code, u8 text length, text             server -> client
+ */
+enum class MsgType : std::uint8_t{
+    JOIN = 1,
+    ACT,
+    BLOCK,
+    ALLOW,
+    ACK,
+    WATCH,
+    RESUME,
+    JOINED = 16,
+    STATE,
+    ERROR,
+    DELTA,
+};
+
+// ERROR codes: MoveStatus values for illegal moves, these for everything else
+enum class ServerError : std::uint8_t{
+    BAD_MESSAGE = 64,
+    ALREADY_JOINED,
+    BAD_TABLE_SIZE,
+    NOT_SEATED,
+    NOT_STARTED,
+    REACTION_PENDING,
+    NOT_YOUR_REACTION,
+    NO_SUCH_MATCH,
+    BUSY,
+    NO_SUCH_SEAT,
+};
+
+constexpr std::uint8_t NO_SEAT = 0xff;
+constexpr std::size_t MAX_FRAME = 4096;
+// Versions per match the server remembers; clients acking anything older get a full STATE
+constexpr std::uint32_t SYNC_WINDOW = 32;
+
+struct Frame{
+    MsgType type;
+    std::vector<std::uint8_t> payload;
+};
+
+struct SeatView{
+    Role role;
+    std::uint8_t flags;      // 1 active, 2 sanctioned, 4 can arrest, 8 last arrested
+    int coins;
+};
+
+/**
+ * @brief Full table state pushed after every change:
+ * u32 match, u32 version, u8 turn, u8 bribe, u8 winner, u8 pending action, u8 blocker,
+ * u8 seats, then per seat u8 role, u8 flags, u16 coins.
+ */
+struct StateMsg{
+    std::uint32_t match = 0;
+    std::uint32_t version = 0;
+    int turn = 0;
+    bool bribe = false;
+    int winner = -1;
+    GameAction pending = GameAction::NONE;   // action whose reaction window is open
+    int blocker = -1;                        // seat that must answer it
+    std::vector<SeatView> seats;
+};
+
+/**
+ * @brief What changed between two versions of a table: a mask of the top-level fields
+ * and one bit per seat whose coins or flags differ. Diffs of consecutive versions are
+ * OR-ed together to cover a longer span.
+ */
+struct StateDiff{
+    static constexpr unsigned TURN = 1;
+    static constexpr unsigned BRIBE = 2;
+    static constexpr unsigned WINNER = 4;
+    static constexpr unsigned REACTION = 8;   // pending action and blocker
+
+    unsigned fields = 0;
+    SeatMask seats = 0;
+
+    StateDiff& operator|=(const StateDiff& other){
+        fields |= other.fields;
+        seats |= other.seats;
+        return *this;
+    }
+};
+
+struct JoinMsg{
+    int players;
+    std::string name;
+    int rating;                         // -1 if the client sent none
+};
+struct JoinedMsg{
+    std::uint32_t match;
+    int seat;
+    int players;
+};
+
+struct ResumeMsg{
+    std::uint32_t match;
+    int seat;
+    std::string name;
+};
+struct ErrorMsg{
+    std::uint8_t code;
+    std::string text;
+};
+
+void put_join(std::vector<std::uint8_t>& out, int players, const std::string& name, int rating = -1);
+void put_act(std::vector<std::uint8_t>& out, GameAction action, int target = -1);
+void put_empty(std::vector<std::uint8_t>& out, MsgType type);
+void put_joined(std::vector<std::uint8_t>& out, std::uint32_t match, int seat, int players);
+void put_ack(std::vector<std::uint8_t>& out, std::uint32_t version);
+void put_watch(std::vector<std::uint8_t>& out, std::uint32_t match);
+void put_resume(std::vector<std::uint8_t>& out, std::uint32_t match, int seat, const std::string& name);
+StateMsg make_state(std::uint32_t match, std::uint32_t version, Game& game, const Reaction& reaction);
+void put_state(std::vector<std::uint8_t>& out, const StateMsg& state);
+void put_state(std::vector<std::uint8_t>& out, std::uint32_t match, std::uint32_t version, Game& game, const Reaction& reaction);
+StateDiff diff_states(const StateMsg& from, const StateMsg& to);
+void put_delta(std::vector<std::uint8_t>& out, std::uint32_t base, const StateMsg& to, const StateDiff& diff);
+void put_delta(std::vector<std::uint8_t>& out, const StateMsg& from, const StateMsg& to);
+void put_error(std::vector<std::uint8_t>& out, std::uint8_t code, const std::string& text);
+
+JoinMsg read_join(const Frame& f);
+JoinedMsg read_joined(const Frame& f);
+StateMsg read_state(const Frame& f);
+std::uint32_t read_ack(const Frame& f);
+std::uint32_t read_watch(const Frame& f);
+ResumeMsg read_resume(const Frame& f);
+bool apply_delta(StateMsg& state, const Frame& f);
+ErrorMsg read_error(const Frame& f);
+
+/**
+ * @brief Reassembles frames from a byte stream that may split or merge them.
+ * @throws std::runtime_error on a frame longer than MAX_FRAME or an empty frame.
+ */
+class FrameBuffer{
+    private:
+        std::vector<std::uint8_t> _bytes;
+        std::size_t _read;
+
+    public:
+        FrameBuffer();
+        void append(const std::uint8_t* data, std::size_t size);
+        bool next(Frame& frame);
+        std::size_t buffered() const;
+        const std::uint8_t* unread() const;
+};
+#endif
@@ -0,0 +1,998 @@
+#include "Server.hpp"
+#include "Checkpoint.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+namespace {
+constexpr int MAX_EVENTS = 256;
+constexpr int MAX_IOV = 64;
+// Timer payloads of the loop's own jobs: match id 0 (real ids start at 1) and a job number
+constexpr std::uint64_t CHECKPOINT_TIMER = 0;
+constexpr std::uint64_t WAL_TIMER = 1;
+constexpr std::uint64_t MATCHMAKER_TIMER = 2;
+
+std::runtime_error sys_error(const std::string& what){
+    return std::runtime_error(what + ": " + std::strerror(errno));
+}
+Server::Buffer freeze(std::vector<std::uint8_t>&& bytes){
+    return std::make_shared<const std::vector<std::uint8_t>>(std::move(bytes));
+}
+}
+
+/**
+ * @brief Listens on all interfaces at the given port (0 picks a free one).
+ * @throws std::runtime_error if the socket cannot be set up.
+ */
+Server::Server(std::uint16_t port, std::uint64_t seed)
+    : _listen_fd(-1), _epoll_fd(-1), _wake_fd(-1), _port(0), _stopping(false), _next_match(1), _rng(seed), _coalesced(0), _next_serial(1),
+      _epoch(std::chrono::steady_clock::now()), _timers(0), _reaction_ms(DEFAULT_REACTION_MS), _turn_ms(DEFAULT_TURN_MS),
+      _checkpoint_ms(0)
+{
+    _listen_fd = ::socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if(_listen_fd < 0){
+        throw sys_error("socket");
+    }
+    int one = 1;
+    ::setsockopt(_listen_fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    ::setsockopt(_listen_fd, SOL_SOCKET, SO_REUSEPORT, &one, sizeof(one));
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    addr.sin_port = htons(port);
+    if(::bind(_listen_fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 || ::listen(_listen_fd, SOMAXCONN) != 0){
+        ::close(_listen_fd);
+        throw sys_error("bind/listen on port " + std::to_string(port));
+    }
+    socklen_t len = sizeof(addr);
+    ::getsockname(_listen_fd, reinterpret_cast<sockaddr*>(&addr), &len);
+    _port = ntohs(addr.sin_port);
+
+    _epoll_fd = ::epoll_create1(EPOLL_CLOEXEC);
+    _wake_fd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if(_epoll_fd < 0 || _wake_fd < 0){
+        throw sys_error("epoll/eventfd");
+    }
+    epoll_event ev{};
+    ev.events = EPOLLIN;
+    ev.data.fd = _listen_fd;
+    ::epoll_ctl(_epoll_fd, EPOLL_CTL_ADD, _listen_fd, &ev);
+    ev.data.fd = _wake_fd;
+    ::epoll_ctl(_epoll_fd, EPOLL_CTL_ADD, _wake_fd, &ev);
+}
+Server::~Server(){
+    for(auto& entry : _conns){
+        ::close(entry.first);
+    }
+    ::close(_wake_fd);
+    ::close(_epoll_fd);
+    ::close(_listen_fd);
+}
+std::uint16_t Server::port() const{
+    return _port;
+}
+std::size_t Server::connections() const{
+    return _conns.size();
+}
+std::size_t Server::matches() const{
+    return _matches.size();
+}
+/**
+ * @brief Number of times a slow connection's backlog was replaced by the latest state.
+ */
+std::uint64_t Server::coalesced() const{
+    return _coalesced;
+}
+/**
+ * @brief Runs until stop() is called (from any thread).
+ */
+void Server::run(){
+    while(!_stopping.load(std::memory_order_relaxed)){
+        poll(-1);
+    }
+}
+/**
+ * @brief Wakes the loop and makes run() return.
+ */
+void Server::stop(){
+    _stopping.store(true, std::memory_order_relaxed);
+    std::uint64_t one = 1;
+    ssize_t ignored = ::write(_wake_fd, &one, sizeof(one));
+    (void)ignored;
+}
+/**
+ * @brief Sets the block window and idle turn deadlines (0 disables one); applies to
+ * deadlines armed from now on.
+ */
+void Server::set_timeouts(std::uint32_t reaction_ms, std::uint32_t turn_ms){
+    _reaction_ms = reaction_ms;
+    _turn_ms = turn_ms;
+}
+/**
+ * @brief Checkpoints every interval_ms to path from the loop thread (0 turns it off;
+ * a timer already pending still fires once).
+ */
+void Server::set_checkpoint(const std::string& path, std::uint32_t interval_ms){
+    _checkpoint_path = path;
+    _checkpoint_ms = interval_ms;
+    if(interval_ms > 0){
+        _timers.schedule(ticks() + interval_ms, CHECKPOINT_TIMER);
+    }
+}
+/**
+ * @brief Writes every started, unfinished match to path. Call from the loop thread, or
+ * after run() has returned.
+ * @return Number of matches saved.
+ * @throws std::runtime_error if the file cannot be written.
+ */
+std::size_t Server::checkpoint(const std::string& path){
+    std::vector<Match*> live;
+    live.reserve(_matches.size());
+    for(auto& entry : _matches){
+        if(entry.second->started() && !entry.second->finished()){
+            live.push_back(entry.second.get());
+        }
+    }
+    Checkpoint::write(path, live);
+    return live.size();
+}
+/**
+ * @brief Adopts the matches checkpointed at path (none if the file is missing), each with
+ * its seats RESERVED and a fresh deadline. Call before run().
+ * @return Number of matches restored.
+ * @throws std::runtime_error on a corrupt checkpoint or a match id already in use.
+ */
+std::size_t Server::restore(const std::string& path, unsigned threads){
+    std::vector<std::unique_ptr<Match>> restored = Checkpoint::read(path, threads);
+    _matches.reserve(_matches.size() + restored.size());
+    for(std::unique_ptr<Match>& m : restored){
+        std::uint32_t id = m->id();
+        if(!_matches.emplace(id, std::move(m)).second){
+            throw std::runtime_error("Restored match " + std::to_string(id) + " is already hosted");
+        }
+        if(id >= _next_match){
+            _next_match = id + 1;
+        }
+        if(_link){
+            _link->claim(id);
+        }
+        arm(*_matches[id]);
+    }
+    return restored.size();
+}
+/**
+ * @brief Opens (or continues) the write-ahead log at path, committed every commit_ms
+ * (0: only by size and on results) or once commit_bytes are buffered. Call before run().
+ * @throws std::runtime_error if the log cannot be opened.
+ */
+void Server::set_wal(const std::string& path, std::uint32_t commit_ms, std::size_t commit_bytes){
+    _journal = std::make_unique<Journal>(path, commit_ms, commit_bytes);
+    if(commit_ms > 0){
+        _timers.schedule(ticks() + commit_ms, WAL_TIMER);
+    }
+}
+/**
+ * @brief Makes this loop shard shard of directory: new matches take their ids from it, and
+ * connections asking for another shard's match are sent down that shard's entry of
+ * outboxes. Connections handed to this shard arrive on inbox. Call before restore() and
+ * run(); the descriptors stay the caller's.
+ */
+void Server::set_shard(ShardDirectory& directory, unsigned shard, int inbox, const std::vector<int>& outboxes){
+    _link = std::make_unique<ShardLink>(directory, shard, inbox, outboxes);
+    epoll_event ev{};
+    ev.events = EPOLLIN;
+    ev.data.fd = inbox;
+    ::epoll_ctl(_epoll_fd, EPOLL_CTL_ADD, inbox, &ev);
+}
+/**
+ * @brief Queues JOINs in a Matchmaker and forms tables every tick_ms (at least 1) instead
+ * of seating players first come, first served. Call before run().
+ */
+void Server::set_matchmaking(std::uint32_t tick_ms, int bucket_width, std::uint32_t widen_ms){
+    _matchmaking = std::make_unique<Matchmaking>(tick_ms, bucket_width, widen_ms);
+    _timers.schedule(ticks() + _matchmaking->tick_ms(), MATCHMAKER_TIMER);
+}
+std::uint64_t Server::ticks() const{
+    return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - _epoch).count());
+}
+/**
+ * @brief Handles whatever is ready within timeout_ms (-1 waits indefinitely), then any
+ * deadlines that passed; the wait is cut short for the next one.
+ * @return Number of ready descriptors.
+ */
+int Server::poll(int timeout_ms){
+    epoll_event events[MAX_EVENTS];
+    std::uint64_t due = _timers.next_due();
+    if(due != UINT64_MAX){
+        std::uint64_t now = ticks();
+        std::uint64_t at = _timers.now() + due;
+        int wait = at > now ? static_cast<int>(std::min<std::uint64_t>(at - now, 60000)) : 0;
+        timeout_ms = timeout_ms < 0 ? wait : std::min(timeout_ms, wait);
+    }
+    int n = ::epoll_wait(_epoll_fd, events, MAX_EVENTS, timeout_ms);
+    if(n < 0){
+        if(errno == EINTR){
+            return 0;
+        }
+        throw sys_error("epoll_wait");
+    }
+    for(int i = 0; i < n; ++i){
+        int fd = events[i].data.fd;
+        if(fd == _listen_fd){
+            accept_all();
+            continue;
+        }
+        if(_link && fd == _link->inbox()){
+            take_over();
+            continue;
+        }
+        if(fd == _wake_fd){
+            std::uint64_t count;
+            ssize_t ignored = ::read(_wake_fd, &count, sizeof(count));
+            (void)ignored;
+            continue;
+        }
+        auto it = _conns.find(fd);
+        if(it == _conns.end()){
+            continue;                               // closed earlier in this batch
+        }
+        if(events[i].events & (EPOLLHUP | EPOLLERR)){
+            close_conn(fd);
+            continue;
+        }
+        if(events[i].events & EPOLLOUT){
+            send(it->second);
+        }
+        if(events[i].events & EPOLLIN){
+            on_readable(it->second);
+        }
+    }
+    apply_ready();
+    run_timers();
+    for(std::uint32_t id : _finished){
+        _pushed.erase(id);
+        _matches.erase(id);
+        if(_link){
+            _link->release(id);
+        }
+    }
+    _finished.clear();
+    if(_journal && _journal->due()){
+        _journal->commit();                         // one sync for the batch, before results go out
+    }
+    flush_dirty();
+    return n;
+}
+/**
+ * @brief Replaces the match's deadline: the block window if one is open, else the turn.
+ * The payload carries the version, so a deadline only acts on the state it was armed for.
+ */
+void Server::arm(Match& m){
+    auto it = _deadlines.find(m.id());
+    if(it != _deadlines.end()){
+        _timers.cancel(it->second);
+        _deadlines.erase(it);
+    }
+    std::uint32_t ms = m.reaction().is_open() ? _reaction_ms : _turn_ms;
+    if(m.finished() || !m.started() || ms == 0){
+        return;
+    }
+    std::uint64_t payload = (static_cast<std::uint64_t>(m.id()) << 32) | m.version();
+    _deadlines.emplace(m.id(), _timers.schedule(ticks() + ms, payload));
+}
+void Server::run_timers(){
+    if(_timers.size() == 0){
+        return;
+    }
+    _timers.advance(ticks(), _expired);
+    for(std::uint64_t payload : _expired){
+        std::uint32_t id = static_cast<std::uint32_t>(payload >> 32);
+        if(payload == CHECKPOINT_TIMER){
+            if(_checkpoint_ms > 0){
+                checkpoint(_checkpoint_path);
+                _timers.schedule(ticks() + _checkpoint_ms, payload);
+            }
+            continue;
+        }
+        if(payload == MATCHMAKER_TIMER){
+            auto waiting = [this](std::uint64_t tag){
+                Connection* c = find_conn(tag);
+                return c != nullptr && c->queued;
+            };
+            _matchmaking->tick(ticks(), waiting, [this](const std::vector<Ticket>& group){ form(group); });
+            _timers.schedule(ticks() + _matchmaking->tick_ms(), payload);
+            continue;
+        }
+        if(payload == WAL_TIMER){
+            if(_journal && _journal->commit_ms() > 0){
+                _journal->commit();
+                _timers.schedule(ticks() + _journal->commit_ms(), payload);
+            }
+            continue;
+        }
+        auto it = _matches.find(id);
+        if(it == _matches.end() || it->second->version() != static_cast<std::uint32_t>(payload)){
+            continue;
+        }
+        _deadlines.erase(id);
+        if(it->second->time_out() == 0){
+            push_state(*it->second);
+        }
+        else{
+            arm(*it->second);
+        }
+    }
+    _expired.clear();
+}
+void Server::flush_dirty(){
+    for(int fd : _dirty){
+        auto it = _conns.find(fd);
+        if(it != _conns.end()){
+            it->second.dirty = false;
+            send(it->second);
+        }
+    }
+    _dirty.clear();
+}
+void Server::accept_all(){
+    while(true){
+        int fd = ::accept4(_listen_fd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if(fd < 0){
+            return;                                 // EAGAIN, or a client that already left
+        }
+        int one = 1;
+        ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        add_conn(fd);
+    }
+}
+Server::Connection& Server::add_conn(int fd){
+    epoll_event ev{};
+    ev.events = EPOLLIN;
+    ev.data.fd = fd;
+    ::epoll_ctl(_epoll_fd, EPOLL_CTL_ADD, fd, &ev);
+    Connection& c = _conns[fd];
+    c.fd = fd;
+    c.serial = _next_serial++;
+    return c;
+}
+/**
+ * @brief Tells a reused fd from the connection a command or ticket came from.
+ */
+std::uint64_t Server::tag_of(const Connection& c){
+    return (static_cast<std::uint64_t>(c.serial) << 32) | static_cast<std::uint32_t>(c.fd);
+}
+Server::Connection* Server::find_conn(std::uint64_t tag){
+    auto it = _conns.find(static_cast<int>(static_cast<std::uint32_t>(tag)));
+    if(it == _conns.end() || it->second.serial != static_cast<std::uint32_t>(tag >> 32)){
+        return nullptr;
+    }
+    return &it->second;
+}
+void Server::on_readable(Connection& c){
+    std::uint8_t buf[4096];
+    int fd = c.fd;
+    while(true){
+        ssize_t got = ::recv(fd, buf, sizeof(buf), 0);
+        if(got == 0 || (got < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)){
+            close_conn(fd);
+            return;
+        }
+        if(got < 0){
+            break;
+        }
+        c.in.append(buf, static_cast<std::size_t>(got));
+    }
+    on_frames(c);
+}
+/**
+ * @brief Handles every complete frame buffered on the connection, stopping early if one
+ * of them moves it to another shard.
+ */
+void Server::on_frames(Connection& c){
+    int fd = c.fd;
+    Frame f;
+    try {
+        while(c.move_to < 0 && c.in.next(f)){
+            on_frame(c, f);
+        }
+    } catch (const std::runtime_error& e) {
+        // Garbled stream: tell the client and hang up
+        error(c, static_cast<std::uint8_t>(ServerError::BAD_MESSAGE), e.what());
+        close_conn(fd);
+        return;
+    }
+    if(c.move_to >= 0){
+        hand_off(c);
+    }
+}
+/**
+ * @brief Whether match id is hosted by another shard that is up. If so the connection is
+ * marked to move there with frame, the request that shard should answer.
+ */
+bool Server::route(Connection& c, std::uint32_t id, std::vector<std::uint8_t>&& frame){
+    return _link && move(c, _link->host(id), std::move(frame));
+}
+/**
+ * @brief Marks the connection to move to shard with frame if shard is another one and up.
+ */
+bool Server::move(Connection& c, int shard, std::vector<std::uint8_t>&& frame){
+    if(!_link || _link->other(shard) < 0){
+        return false;
+    }
+    c.move_to = shard;
+    c.forward = std::move(frame);
+    return true;
+}
+/**
+ * @brief Passes the connection, with the frame that asked for the move and anything the
+ * client sent after it, to the shard it was routed to, and forgets it here without
+ * hanging up. If the connection still has output queued or the channel is full, a JOIN
+ * is queued here instead and anything else gets BUSY.
+ */
+void Server::hand_off(Connection& c){
+    int fd = c.fd;
+    int shard = c.move_to;
+    c.move_to = -1;
+    std::vector<std::uint8_t> bytes = std::move(c.forward);
+    bytes.insert(bytes.end(), c.in.unread(), c.in.unread() + c.in.buffered());
+    if(!c.out.empty() || !_link->send_move(shard, fd, bytes)){
+        c.in = FrameBuffer();
+        if(bytes.size() > 4 && bytes[4] == static_cast<std::uint8_t>(MsgType::JOIN)){
+            c.pinned = true;
+            c.in.append(bytes.data(), bytes.size());
+            on_frames(c);
+            return;
+        }
+        error(c, static_cast<std::uint8_t>(ServerError::BUSY), "Shard is busy");
+        return;
+    }
+    auto m = _matches.find(c.match);
+    if(c.watching && m != _matches.end()){
+        m->second->unwatch(fd);
+    }
+    ::epoll_ctl(_epoll_fd, EPOLL_CTL_DEL, fd, nullptr);   // the receiver may be this process
+    ::close(fd);
+    _conns.erase(fd);
+}
+/**
+ * @brief Adopts the connections other shards handed to this one and answers what they
+ * had asked for.
+ */
+void Server::take_over(){
+    Arrival arrival;
+    while(_link->receive(arrival)){
+        if(arrival.table){
+            open_table(arrival.seats);
+            continue;
+        }
+        Connection& c = add_conn(arrival.seats[0].fd);
+        c.in.append(arrival.seats[0].pending.data(), arrival.seats[0].pending.size());
+        on_frames(c);
+    }
+}
+/**
+ * @brief Opens a match for a table the matchmaker formed on another shard, then handles
+ * whatever its players had already sent.
+ */
+void Server::open_table(const std::vector<TableSeat>& seats){
+    Match& m = open_match(static_cast<int>(seats.size()));
+    for(const TableSeat& s : seats){
+        seat(add_conn(s.fd), m, s.name);
+    }
+    m.start(_rng);
+    push_state(m);
+    for(const TableSeat& s : seats){
+        auto it = _conns.find(s.fd);
+        if(it != _conns.end() && !s.pending.empty()){
+            it->second.in.append(s.pending.data(), s.pending.size());
+            on_frames(it->second);
+        }
+    }
+}
+/**
+ * @brief Creates an empty match with an id from the directory (or this loop's counter).
+ */
+Match& Server::open_match(int players){
+    std::uint32_t id = _link ? _link->allocate() : _next_match++;
+    return *_matches.emplace(id, std::make_unique<Match>(id, players)).first->second;
+}
+/**
+ * @brief Seats the client in the next free seat of m and tells it where it sits.
+ */
+void Server::seat(Connection& c, Match& m, const std::string& name){
+    c.match = m.id();
+    c.acked = 0;
+    c.seat = m.join(c.fd, name);
+    std::vector<std::uint8_t> joined;
+    put_joined(joined, m.id(), c.seat, m.players());
+    queue(c, freeze(std::move(joined)));
+    send(c);
+}
+/**
+ * @brief Withdraws the client's matchmaking ticket, if it has one.
+ */
+void Server::leave_queue(Connection& c){
+    if(c.queued){
+        _matchmaking->cancel(tag_of(c));
+        c.queued = false;
+    }
+}
+/**
+ * @brief Opens a match for a formed table on the least-loaded shard: here, or by handing
+ * every player's connection to that shard in one message. Falls back to this shard if the
+ * hand-over fails.
+ */
+void Server::form(const std::vector<Ticket>& group){
+    std::vector<Connection*> conns;
+    for(const Ticket& t : group){
+        Connection* c = find_conn(t.tag);
+        c->queued = false;
+        conns.push_back(c);
+    }
+    int shard = _link ? _link->least_loaded() : -1;
+    if(shard >= 0){
+        std::vector<TableSeat> seats;
+        bool fits = true;
+        for(std::size_t i = 0; i < group.size(); ++i){
+            Connection& c = *conns[i];
+            fits = fits && c.out.empty();
+            seats.push_back(TableSeat{c.fd, group[i].name, std::vector<std::uint8_t>(c.in.unread(), c.in.unread() + c.in.buffered())});
+        }
+        if(fits && _link->send_table(shard, seats)){
+            for(const TableSeat& s : seats){
+                ::epoll_ctl(_epoll_fd, EPOLL_CTL_DEL, s.fd, nullptr);
+                ::close(s.fd);
+                _conns.erase(s.fd);
+            }
+            return;
+        }
+    }
+    Match& m = open_match(static_cast<int>(group.size()));
+    for(std::size_t i = 0; i < group.size(); ++i){
+        seat(*conns[i], m, group[i].name);
+    }
+    m.start(_rng);
+    push_state(m);
+}
+void Server::on_frame(Connection& c, const Frame& f){
+    if(f.type == MsgType::JOIN){
+        on_join(c, f);
+        return;
+    }
+    if(f.type == MsgType::ACK){
+        on_ack(c, f);
+        return;
+    }
+    if(f.type == MsgType::WATCH){
+        on_watch(c, f);
+        return;
+    }
+    if(f.type == MsgType::RESUME){
+        on_resume(c, f);
+        return;
+    }
+    auto it = _matches.find(c.match);
+    if(c.seat < 0 || it == _matches.end()){
+        error(c, static_cast<std::uint8_t>(ServerError::NOT_SEATED), "Join a match first");
+        return;
+    }
+    Command cmd;
+    cmd.seat = c.seat;
+    cmd.tag = tag_of(c);
+    switch(f.type){
+        case MsgType::ACT:
+            if(f.payload.size() != 2){
+                throw std::runtime_error("Bad ACT payload");
+            }
+            cmd.action = static_cast<GameAction>(f.payload[0]);
+            cmd.target = f.payload[1] == NO_SEAT ? -1 : f.payload[1];
+            break;
+        case MsgType::BLOCK:
+        case MsgType::ALLOW:
+            cmd.kind = f.type == MsgType::BLOCK ? CommandKind::BLOCK : CommandKind::ALLOW;
+            break;
+        default:
+            throw std::runtime_error("Unexpected message type " + std::to_string(static_cast<int>(f.type)));
+    }
+    if(!it->second->post(cmd)){
+        error(c, static_cast<std::uint8_t>(ServerError::BUSY), "Match is busy");
+        return;
+    }
+    _ready.push_back(c.match);
+}
+/**
+ * @brief Applies the commands queued on each match touched by this batch, pushing the
+ * state after every one that succeeds and answering the rest with an ERROR.
+ */
+void Server::apply_ready(){
+    for(std::uint32_t id : _ready){
+        auto it = _matches.find(id);
+        if(it == _matches.end()){
+            continue;
+        }
+        Match& m = *it->second;
+        m.drain([&](const Command& cmd, std::uint8_t code){
+            if(code == 0){
+                push_state(m);
+                return;
+            }
+            Connection* conn = find_conn(cmd.tag);
+            if(conn != nullptr){
+                error(*conn, code, code < 64 ? to_string(static_cast<MoveStatus>(code)) : "Request refused");
+            }
+        });
+    }
+    _ready.clear();
+}
+/**
+ * @brief Seats the client in the filling match of its table size, starting it once full.
+ */
+void Server::on_join(Connection& c, const Frame& f){
+    JoinMsg msg = read_join(f);
+    if(c.queued){
+        error(c, static_cast<std::uint8_t>(ServerError::ALREADY_JOINED), "Already waiting for a match");
+        return;
+    }
+    if(c.seat >= 0){
+        auto it = _matches.find(c.match);
+        if(it != _matches.end() && !it->second->finished()){
+            error(c, static_cast<std::uint8_t>(ServerError::ALREADY_JOINED), "Already in a match");
+            return;
+        }
+    }
+    int players = msg.players;
+    if(players < 2 || players > PlayerList::CAPACITY){
+        error(c, static_cast<std::uint8_t>(ServerError::BAD_TABLE_SIZE), "Table size out of range");
+        return;
+    }
+    if(c.watching){
+        auto it = _matches.find(c.match);
+        if(it != _matches.end()){
+            it->second->unwatch(c.fd);
+        }
+        c.watching = false;
+    }
+    if(_matchmaking){
+        std::vector<std::uint8_t> frame;
+        put_join(frame, players, msg.name, msg.rating);
+        bool pinned = c.pinned;
+        c.pinned = false;
+        if(!pinned && move(c, static_cast<int>(MATCHMAKER_SHARD), std::move(frame))){
+            return;                                 // one pool for every shard
+        }
+        Ticket t;
+        t.tag = tag_of(c);
+        t.name = msg.name;
+        t.rating = msg.rating < 0 ? Matchmaker::DEFAULT_RATING : msg.rating;
+        t.seats = players;
+        t.since = ticks();
+        _matchmaking->enqueue(t);
+        c.queued = true;
+        c.seat = -1;
+        return;
+    }
+    auto lobby = _lobby.find(players);
+    if(lobby == _lobby.end()){
+        lobby = _lobby.emplace(players, open_match(players).id()).first;
+    }
+    Match& m = *_matches[lobby->second];
+    seat(c, m, msg.name);
+    if(m.full()){
+        _lobby.erase(lobby);
+        m.start(_rng);
+        push_state(m);
+    }
+}
+/**
+ * @brief Adds the client as a spectator of a match, seated players excepted. A match in
+ * progress is sent in full straight away; after that spectators get the same frames as
+ * players, tracked by the last version queued to them.
+ */
+void Server::on_watch(Connection& c, const Frame& f){
+    std::uint32_t id = read_watch(f);
+    leave_queue(c);
+    auto current = _matches.find(c.match);
+    if(c.seat >= 0 && current != _matches.end() && !current->second->finished()){
+        error(c, static_cast<std::uint8_t>(ServerError::ALREADY_JOINED), "Already in a match");
+        return;
+    }
+    auto it = _matches.find(id);
+    if(it == _matches.end() || it->second->finished()){
+        std::vector<std::uint8_t> frame;
+        put_watch(frame, id);
+        if(it == _matches.end() && route(c, id, std::move(frame))){
+            return;
+        }
+        error(c, static_cast<std::uint8_t>(ServerError::NO_SUCH_MATCH), "No such match");
+        return;
+    }
+    if(c.watching && current != _matches.end()){
+        current->second->unwatch(c.fd);
+    }
+    Match& m = *it->second;
+    m.watch(c.fd);
+    c.match = id;
+    c.seat = -1;
+    c.watching = true;
+    c.acked = 0;
+    std::vector<std::uint8_t> bytes;
+    put_joined(bytes, id, -1, m.players());
+    auto pushed = _pushed.find(id);
+    if(pushed != _pushed.end()){
+        const StateMsg& latest = pushed->second[m.version() % SYNC_WINDOW].state;
+        if(latest.version == m.version()){
+            put_state(bytes, latest);
+            c.acked = latest.version;
+        }
+    }
+    queue(c, freeze(std::move(bytes)));
+    send(c);
+}
+/**
+ * @brief Puts a client back in the seat it held before a restart: JOINED, then the
+ * current state in full.
+ */
+void Server::on_resume(Connection& c, const Frame& f){
+    ResumeMsg msg = read_resume(f);
+    leave_queue(c);
+    auto current = _matches.find(c.match);
+    if(c.seat >= 0 && current != _matches.end() && !current->second->finished()){
+        error(c, static_cast<std::uint8_t>(ServerError::ALREADY_JOINED), "Already in a match");
+        return;
+    }
+    auto it = _matches.find(msg.match);
+    if(it == _matches.end() || it->second->finished()){
+        std::vector<std::uint8_t> frame;
+        put_resume(frame, msg.match, msg.seat, msg.name);
+        if(it == _matches.end() && route(c, msg.match, std::move(frame))){
+            return;
+        }
+        error(c, static_cast<std::uint8_t>(ServerError::NO_SUCH_MATCH), "No such match");
+        return;
+    }
+    Match& m = *it->second;
+    std::uint8_t code = m.rejoin(msg.seat, c.fd, msg.name);
+    if(code != 0){
+        error(c, code, "Seat is not held for you");
+        return;
+    }
+    if(c.watching && current != _matches.end()){
+        current->second->unwatch(c.fd);
+    }
+    c.match = m.id();
+    c.seat = msg.seat;
+    c.watching = false;
+    c.acked = 0;
+    std::vector<std::uint8_t> bytes;
+    put_joined(bytes, m.id(), c.seat, m.players());
+    put_state(bytes, make_state(m.id(), m.version(), m.game(), m.reaction()));
+    queue(c, freeze(std::move(bytes)));
+    send(c);
+}
+/**
+ * @brief Records the version the client has applied; acks for a finished match, or for
+ * versions never sent, are ignored.
+ */
+void Server::on_ack(Connection& c, const Frame& f){
+    std::uint32_t version = read_ack(f);
+    auto it = _matches.find(c.match);
+    if(c.seat >= 0 && it != _matches.end() && version <= it->second->version() && version > c.acked){
+        c.acked = version;
+    }
+}
+/**
+ * @brief ORs the diffs of every version after acked up to version.
+ * @return false if one of them has left the window (or was never pushed).
+ */
+bool Server::diff_since(const std::vector<Pushed>& pushed, std::uint32_t acked, std::uint32_t version, StateDiff& diff) const{
+    if(acked == 0 || version - acked >= SYNC_WINDOW){
+        return false;
+    }
+    for(std::uint32_t v = acked + 1; v <= version; ++v){
+        const Pushed& p = pushed[v % SYNC_WINDOW];
+        if(p.state.version != v){
+            return false;
+        }
+        diff |= p.diff;
+    }
+    return true;
+}
+/**
+ * @brief Sends the match's new state to each of its players, encoding each frame once:
+ * one full STATE, and one DELTA per distinct acked version still in the window.
+ * A delta covers every change since the ack, not just since the last push, so it is
+ * correct whichever pushes the client had already applied when its ack was sent.
+ */
+void Server::push_state(Match& m){
+    bool hold = _journal && _journal->record(m);    // final state waits for the WAL commit
+    std::vector<Pushed>& pushed = _pushed[m.id()];
+    if(pushed.empty()){
+        pushed.resize(SYNC_WINDOW);
+    }
+    std::uint32_t version = m.version();
+    Pushed& now = pushed[version % SYNC_WINDOW];
+    now.state = make_state(m.id(), version, m.game(), m.reaction());
+    const Pushed& previous = pushed[(version - 1) % SYNC_WINDOW];
+    if(version > 1 && previous.state.version == version - 1){
+        now.diff = diff_states(previous.state, now.state);
+    }
+    else{
+        now.diff.fields = ~0u;                      // unknown predecessor: everything changed
+        now.diff.seats = ~SeatMask(0);
+    }
+    Buffer full;
+    auto latest = [&](){
+        if(!full){
+            std::vector<std::uint8_t> bytes;
+            put_state(bytes, now.state);
+            full = freeze(std::move(bytes));
+        }
+        return full;
+    };
+    std::vector<std::pair<std::uint32_t, Buffer>> deltas;
+    auto deliver = [&](Connection& c){
+        if(c.out.size() >= MAX_QUEUED){
+            coalesce(c, latest());
+            return;
+        }
+        auto d = std::find_if(deltas.begin(), deltas.end(), [&](const auto& e){ return e.first == c.acked; });
+        StateDiff diff;
+        if(d != deltas.end()){
+            queue(c, d->second);
+        }
+        else if(diff_since(pushed, c.acked, version, diff)){
+            std::vector<std::uint8_t> bytes;
+            put_delta(bytes, c.acked, now.state, diff);
+            deltas.emplace_back(c.acked, freeze(std::move(bytes)));
+            queue(c, deltas.back().second);
+        }
+        else{
+            queue(c, latest());
+        }
+    };
+    for(int fd : m.conns()){
+        auto it = _conns.find(fd);
+        if(fd >= 0 && it != _conns.end()){
+            deliver(it->second);
+            if(!hold){
+                send(it->second);
+            }
+            else if(!it->second.dirty){
+                it->second.dirty = true;
+                _dirty.push_back(fd);
+            }
+        }
+    }
+    for(int fd : m.spectators()){
+        auto it = _conns.find(fd);
+        if(it != _conns.end()){
+            Connection& c = it->second;
+            deliver(c);
+            c.acked = version;                      // TCP delivers what is queued, in order
+            if(!c.dirty){
+                c.dirty = true;
+                _dirty.push_back(fd);
+            }
+        }
+    }
+    if(m.finished()){
+        for(int fd : m.conns()){
+            auto it = _conns.find(fd);
+            if(fd >= 0 && it != _conns.end()){
+                it->second.seat = -1;
+            }
+        }
+        for(int fd : m.spectators()){
+            auto it = _conns.find(fd);
+            if(it != _conns.end()){
+                it->second.watching = false;
+            }
+        }
+        _finished.push_back(m.id());            // erased at the end of the batch, once nothing refers to it
+    }
+    arm(m);
+}
+void Server::error(Connection& c, std::uint8_t code, const std::string& text){
+    std::vector<std::uint8_t> bytes;
+    put_error(bytes, code, text);
+    queue(c, freeze(std::move(bytes)));
+    send(c);
+}
+void Server::queue(Connection& c, Buffer frame){
+    c.out.push_back(std::move(frame));
+}
+/**
+ * @brief Replaces a backlog with the latest full state, keeping a partly written frame
+ * so the stream stays aligned.
+ */
+void Server::coalesce(Connection& c, Buffer latest){
+    c.out.erase(c.out.begin() + (c.sent > 0 ? 1 : 0), c.out.end());
+    c.out.push_back(std::move(latest));
+    _coalesced++;
+}
+/**
+ * @brief Writes as much queued output as the socket takes, gathering up to MAX_IOV
+ * shared buffers per call; waits for EPOLLOUT for the rest.
+ */
+void Server::send(Connection& c){
+    while(!c.out.empty()){
+        iovec iov[MAX_IOV];
+        int count = 0;
+        for(auto it = c.out.begin(); it != c.out.end() && count < MAX_IOV; ++it, ++count){
+            std::size_t skip = count == 0 ? c.sent : 0;
+            iov[count].iov_base = const_cast<std::uint8_t*>((*it)->data() + skip);
+            iov[count].iov_len = (*it)->size() - skip;
+        }
+        msghdr msg{};
+        msg.msg_iov = iov;
+        msg.msg_iovlen = static_cast<std::size_t>(count);
+        ssize_t n = ::sendmsg(c.fd, &msg, MSG_NOSIGNAL);
+        if(n < 0){
+            if(errno == EINTR){
+                continue;
+            }
+            if(errno != EAGAIN && errno != EWOULDBLOCK){
+                c.out.clear();                      // peer is gone; EPOLLHUP/EPOLLERR closes it
+                c.sent = 0;
+                return;
+            }
+            break;
+        }
+        std::size_t written = static_cast<std::size_t>(n) + c.sent;
+        while(!c.out.empty() && written >= c.out.front()->size()){
+            written -= c.out.front()->size();
+            c.out.pop_front();
+        }
+        c.sent = written;
+    }
+    bool want = !c.out.empty();
+    if(want != c.writing){
+        epoll_event ev{};
+        ev.events = EPOLLIN | (want ? EPOLLOUT : 0u);
+        ev.data.fd = c.fd;
+        ::epoll_ctl(_epoll_fd, EPOLL_CTL_MOD, c.fd, &ev);
+        c.writing = want;
+    }
+}
+/**
+ * @brief Drops a connection; its seat forfeits and the rest of its match is told.
+ */
+void Server::close_conn(int fd){
+    auto it = _conns.find(fd);
+    if(it == _conns.end()){
+        return;
+    }
+    std::uint32_t match = it->second.match;
+    int seat = it->second.seat;
+    bool watching = it->second.watching;
+    leave_queue(it->second);
+    ::epoll_ctl(_epoll_fd, EPOLL_CTL_DEL, fd, nullptr);
+    ::close(fd);
+    _conns.erase(it);
+    auto m = _matches.find(match);
+    if(watching && m != _matches.end()){
+        m->second->unwatch(fd);
+    }
+    if(seat >= 0 && m != _matches.end()){
+        Match& left = *m->second;
+        bool live = left.started() && !left.finished();
+        left.leave(seat);
+        if(live && _journal){
+            _journal->record_forfeit(left, seat);
+        }
+        if(left.started()){
+            push_state(left);
+        }
+    }
+}
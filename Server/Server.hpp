@@ -0,0 +1,169 @@
+#ifndef SERVER_HPP
+#define SERVER_HPP
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "Journal.hpp"
+#include "Match.hpp"
+#include "Matchmaking.hpp"
+#include "Protocol.hpp"
+#include "ShardLink.hpp"
+#include "TimerWheel.hpp"
+#include "../Engine/Rng.hpp"
+
+/**
+ * @brief Single-threaded epoll loop hosting many matches over TCP.
+ * Run one Server per core on the same port; SO_REUSEPORT lets the kernel spread
+ * incoming connections across them, and no state is shared between loops.
+ * Clients JOIN a table size and are seated in the next match of that size; the match
+ * starts when it is full and every change is pushed to its players. Clients that ACK the
+ * versions they applied get a DELTA against their last ack; the rest, and anyone more than
+ * SYNC_WINDOW versions behind, get a full STATE.
+ * Spectators WATCH a match by id. Every frame of a push is encoded once into an immutable
+ * shared buffer and the same buffer is queued on each connection that needs it, then
+ * written with writev; a connection with more than MAX_QUEUED frames waiting is
+ * coalesced to the latest full STATE so slow readers cost memory for one frame, not many.
+ * Spectator output is flushed once per event batch, so several pushes share one writev.
+ * Player requests go through each match's lock-free inbox (Match::post) and are applied
+ * in a batch per match after the socket events, so the same path serves network threads
+ * that do not own the match.
+ * Every push arms one deadline per match on a timer wheel ticking in milliseconds: an open
+ * block window is allowed after reaction_ms, an idle turn is auto-played after turn_ms.
+ * checkpoint() saves every live match to one file (see Checkpoint) and restore() brings
+ * them back after a restart with their seats held until the players RESUME; with
+ * set_checkpoint() the loop also checkpoints itself on a timer.
+ * The rest is delegated, and the loop only ties it to its connections and timers:
+ * set_wal() logs every match to a write-ahead log (Journal); set_shard() makes the loop one
+ * shard of several, handing connections to the shard hosting their match (ShardLink); and
+ * set_matchmaking() queues JOINs for tables formed in batches (Matchmaking), on
+ * MATCHMAKER_SHARD when sharded and each opened on the least-loaded shard.
+ */
+class Server{
+    public:
+        using Buffer = std::shared_ptr<const std::vector<std::uint8_t>>;
+        static constexpr std::size_t MAX_QUEUED = 64;
+        static constexpr std::uint32_t DEFAULT_REACTION_MS = 10000;
+        static constexpr std::uint32_t DEFAULT_TURN_MS = 30000;
+        static constexpr unsigned MATCHMAKER_SHARD = 0;
+
+    private:
+        struct Connection{
+            int fd;
+            std::uint32_t serial = 0;      // tells a reused fd from the connection a command came from
+            FrameBuffer in;
+            std::deque<Buffer> out;
+            std::size_t sent = 0;          // bytes of out.front() already written
+            std::uint32_t match = 0;
+            int seat = -1;
+            bool watching = false;
+            bool writing = false;
+            bool dirty = false;            // queued spectator output, flushed after the event batch
+            std::uint32_t acked = 0;       // last version the client applied (spectators: last queued), 0 for none
+            bool queued = false;           // waiting in the matchmaker
+            bool pinned = false;           // its next JOIN could not be handed over: queue it here
+            int move_to = -1;              // shard to hand the connection to after this frame
+            std::vector<std::uint8_t> forward;  // the frame that shard should answer
+        };
+
+        int _listen_fd;
+        int _epoll_fd;
+        int _wake_fd;
+        std::uint16_t _port;
+        std::atomic<bool> _stopping;
+        std::unordered_map<int, Connection> _conns;
+        std::unordered_map<std::uint32_t, std::unique_ptr<Match>> _matches;
+        std::map<int, std::uint32_t> _lobby;      // table size -> match still filling
+        // A pushed state and what changed since the version before it
+        struct Pushed{
+            StateMsg state;
+            StateDiff diff;
+        };
+        // Recently pushed states per match, indexed by version % SYNC_WINDOW
+        std::unordered_map<std::uint32_t, std::vector<Pushed>> _pushed;
+        std::uint32_t _next_match;
+        Rng _rng;
+        std::uint64_t _coalesced;
+        std::vector<int> _dirty;
+        std::uint32_t _next_serial;
+        std::vector<std::uint32_t> _ready;        // matches with queued commands
+        std::vector<std::uint32_t> _finished;     // matches to erase after the batch
+        std::chrono::steady_clock::time_point _epoch;
+        TimerWheel _timers;                        // one tick per millisecond since _epoch
+        std::unordered_map<std::uint32_t, TimerWheel::TimerId> _deadlines;
+        std::vector<std::uint64_t> _expired;
+        std::uint32_t _reaction_ms;
+        std::uint32_t _turn_ms;
+        std::string _checkpoint_path;
+        std::uint32_t _checkpoint_ms;
+        std::unique_ptr<Journal> _journal;
+        std::unique_ptr<ShardLink> _link;
+        std::unique_ptr<Matchmaking> _matchmaking;
+
+        void accept_all();
+        Connection& add_conn(int fd);
+        Connection* find_conn(std::uint64_t tag);
+        static std::uint64_t tag_of(const Connection& c);
+        void on_readable(Connection& c);
+        void on_frames(Connection& c);
+        void on_frame(Connection& c, const Frame& f);
+        void on_join(Connection& c, const Frame& f);
+        void on_ack(Connection& c, const Frame& f);
+        void on_watch(Connection& c, const Frame& f);
+        void on_resume(Connection& c, const Frame& f);
+        bool route(Connection& c, std::uint32_t id, std::vector<std::uint8_t>&& frame);
+        bool move(Connection& c, int shard, std::vector<std::uint8_t>&& frame);
+        void hand_off(Connection& c);
+        void take_over();
+        void open_table(const std::vector<TableSeat>& seats);
+        Match& open_match(int players);
+        void seat(Connection& c, Match& m, const std::string& name);
+        void leave_queue(Connection& c);
+        void form(const std::vector<Ticket>& group);
+        void apply_ready();
+        std::uint64_t ticks() const;
+        void arm(Match& m);
+        void run_timers();
+        void queue(Connection& c, Buffer frame);
+        void coalesce(Connection& c, Buffer latest);
+        void send(Connection& c);
+        void flush_dirty();
+        void push_state(Match& m);
+        bool diff_since(const std::vector<Pushed>& pushed, std::uint32_t acked, std::uint32_t version, StateDiff& diff) const;
+        void close_conn(int fd);
+        void error(Connection& c, std::uint8_t code, const std::string& text);
+
+    public:
+        explicit Server(std::uint16_t port = 0, std::uint64_t seed = Rng::random_seed());
+        ~Server();
+        Server(const Server&) = delete;
+        Server& operator=(const Server&) = delete;
+
+        std::uint16_t port() const;
+        int poll(int timeout_ms);
+        void run();
+        void stop();
+        void set_timeouts(std::uint32_t reaction_ms, std::uint32_t turn_ms);
+        void set_checkpoint(const std::string& path, std::uint32_t interval_ms);
+        std::size_t checkpoint(const std::string& path);
+        std::size_t restore(const std::string& path, unsigned threads = 1);
+        void set_wal(const std::string& path, std::uint32_t commit_ms, std::size_t commit_bytes = Wal::DEFAULT_COMMIT_BYTES);
+        const Wal* wal() const { return _journal ? &_journal->wal() : nullptr; }
+        void set_shard(ShardDirectory& directory, unsigned shard, int inbox, const std::vector<int>& outboxes);
+        std::uint64_t handed_off() const { return _link ? _link->handed_off() : 0; }
+        std::uint64_t taken_over() const { return _link ? _link->taken_over() : 0; }
+        void set_matchmaking(std::uint32_t tick_ms, int bucket_width = Matchmaker::DEFAULT_BUCKET_WIDTH,
+                             std::uint32_t widen_ms = Matchmaker::DEFAULT_WIDEN_MS);
+        const Matchmaker* matchmaker() const { return _matchmaking ? &_matchmaking->matchmaker() : nullptr; }
+        std::size_t connections() const;
+        std::size_t matches() const;
+        std::uint64_t coalesced() const;
+};
+#endif
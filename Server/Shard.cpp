@@ -0,0 +1,228 @@
+#include "Shard.hpp"
+#include <cerrno>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+static_assert(std::atomic<std::uint64_t>::is_always_lock_free, "directory slots are shared between processes");
+static_assert(std::atomic<std::uint32_t>::is_always_lock_free, "shard counters are shared between processes");
+
+namespace {
+std::runtime_error sys_error(const std::string& what){
+    return std::runtime_error(what + ": " + std::strerror(errno));
+}
+std::uint64_t pack(std::uint32_t id, unsigned shard){
+    return (static_cast<std::uint64_t>(id) << 32) | (shard + 1);
+}
+}
+
+/**
+ * @brief Maps a zeroed directory for shards shards with capacity slots (rounded up to a
+ * power of two), shared with every process forked afterwards.
+ * @throws std::runtime_error on a bad shard count or if the mapping fails.
+ */
+ShardDirectory::ShardDirectory(unsigned shards, std::size_t capacity)
+    : _map(nullptr), _bytes(0), _layout(nullptr), _slots(nullptr), _mask(0)
+{
+    if(shards == 0 || shards > MAX_SHARDS){
+        throw std::runtime_error("Shard count must be 1-" + std::to_string(MAX_SHARDS));
+    }
+    std::size_t slots = 1;
+    while(slots < capacity || slots < shards){
+        slots <<= 1;
+    }
+    _bytes = sizeof(Layout) + slots * sizeof(std::atomic<std::uint64_t>);
+    _map = ::mmap(nullptr, _bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if(_map == MAP_FAILED){
+        throw sys_error("Cannot map shard directory");
+    }
+    _layout = new (_map) Layout();
+    _layout->shards = shards;
+    _layout->capacity = static_cast<std::uint32_t>(slots);
+    _slots = reinterpret_cast<std::atomic<std::uint64_t>*>(static_cast<std::uint8_t*>(_map) + sizeof(Layout));
+    for(std::size_t i = 0; i < slots; ++i){
+        new (&_slots[i]) std::atomic<std::uint64_t>(0);
+    }
+    _mask = slots - 1;
+}
+ShardDirectory::~ShardDirectory(){
+    ::munmap(_map, _bytes);
+}
+/**
+ * @brief Registers a new match on shard and returns its id.
+ * @throws std::runtime_error if every slot the shard can use is taken, or ids run out.
+ */
+std::uint32_t ShardDirectory::allocate(unsigned shard){
+    ShardInfo& s = info(shard);
+    for(std::size_t tries = 0; tries <= _mask; ++tries){
+        std::uint64_t id = static_cast<std::uint64_t>(s.next.fetch_add(1, std::memory_order_relaxed)) * shards() + shard + 1;
+        if(id > UINT32_MAX){
+            throw std::runtime_error("Match ids exhausted on shard " + std::to_string(shard));
+        }
+        std::uint64_t empty = 0;
+        if(slot(static_cast<std::uint32_t>(id)).compare_exchange_strong(empty, pack(static_cast<std::uint32_t>(id), shard), std::memory_order_acq_rel)){
+            s.matches.fetch_add(1, std::memory_order_relaxed);
+            return static_cast<std::uint32_t>(id);
+        }
+    }
+    throw std::runtime_error("Shard directory full");
+}
+/**
+ * @brief Registers a match restored with its old id, and moves the shard's ids past it.
+ * @return false if the id is not shard's or its slot holds another live match; the match
+ * can then only be reached on the loop it was accepted on.
+ */
+bool ShardDirectory::claim(std::uint32_t id, unsigned shard){
+    if(id == 0 || (id - 1) % shards() != shard){
+        return false;
+    }
+    std::uint64_t empty = 0;
+    if(!slot(id).compare_exchange_strong(empty, pack(id, shard), std::memory_order_acq_rel)){
+        return empty == pack(id, shard);
+    }
+    ShardInfo& s = info(shard);
+    s.matches.fetch_add(1, std::memory_order_relaxed);
+    std::uint32_t after = (id - 1) / shards() + 1;
+    std::uint32_t next = s.next.load(std::memory_order_relaxed);
+    while(next < after && !s.next.compare_exchange_weak(next, after, std::memory_order_relaxed)){
+    }
+    return true;
+}
+/**
+ * @brief Shard hosting match id, or -1 if it is not registered.
+ */
+int ShardDirectory::lookup(std::uint32_t id) const{
+    std::uint64_t entry = slot(id).load(std::memory_order_acquire);
+    if(static_cast<std::uint32_t>(entry >> 32) != id || static_cast<std::uint32_t>(entry) == 0){
+        return -1;
+    }
+    return static_cast<int>(static_cast<std::uint32_t>(entry)) - 1;
+}
+/**
+ * @brief Unregisters a finished match.
+ */
+void ShardDirectory::release(std::uint32_t id){
+    std::uint64_t entry = slot(id).load(std::memory_order_acquire);
+    if(static_cast<std::uint32_t>(entry >> 32) != id || static_cast<std::uint32_t>(entry) == 0){
+        return;
+    }
+    if(slot(id).compare_exchange_strong(entry, 0, std::memory_order_acq_rel)){
+        info(static_cast<std::uint32_t>(entry) - 1).matches.fetch_sub(1, std::memory_order_relaxed);
+    }
+}
+/**
+ * @brief Unregisters every match of a shard whose worker died.
+ * @return Number of entries cleared.
+ */
+std::size_t ShardDirectory::drop(unsigned shard){
+    std::size_t cleared = 0;
+    for(std::size_t i = 0; i <= _mask; ++i){
+        std::uint64_t entry = _slots[i].load(std::memory_order_relaxed);
+        if(static_cast<std::uint32_t>(entry) == shard + 1 && _slots[i].compare_exchange_strong(entry, 0, std::memory_order_acq_rel)){
+            cleared++;
+        }
+    }
+    info(shard).matches.store(0, std::memory_order_relaxed);
+    return cleared;
+}
+
+/**
+ * @brief The up shard hosting the fewest matches, prefer on a tie; -1 if none is up.
+ */
+int ShardDirectory::least_loaded(unsigned prefer) const{
+    int best = prefer < shards() && up(prefer) ? static_cast<int>(prefer) : -1;
+    std::uint32_t fewest = best >= 0 ? info(prefer).matches.load(std::memory_order_relaxed) : UINT32_MAX;
+    for(unsigned shard = 0; shard < shards(); ++shard){
+        std::uint32_t matches = info(shard).matches.load(std::memory_order_relaxed);
+        if(up(shard) && matches < fewest){
+            best = static_cast<int>(shard);
+            fewest = matches;
+        }
+    }
+    return best;
+}
+
+/**
+ * @brief Creates a non-blocking channel: fds[0] sends, fds[1] receives.
+ * @throws std::runtime_error if the socket pair cannot be created.
+ */
+void Handoff::channel(int fds[2]){
+    if(::socketpair(AF_UNIX, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0, fds) != 0){
+        throw sys_error("handoff socketpair");
+    }
+}
+/**
+ * @brief Sends fds and bytes as one datagram; the caller still owns (and should close)
+ * its copies of fds.
+ * @return false if the channel is full, or bytes or fds exceed MAX_BYTES or MAX_FDS.
+ */
+bool Handoff::send(int channel, const std::vector<int>& fds, const std::vector<std::uint8_t>& bytes){
+    if(bytes.size() > MAX_BYTES || fds.empty() || fds.size() > MAX_FDS){
+        return false;
+    }
+    std::uint8_t marker = 0;
+    iovec iov[2];
+    iov[0].iov_base = &marker;                        // a datagram always carries at least one byte
+    iov[0].iov_len = 1;
+    iov[1].iov_base = const_cast<std::uint8_t*>(bytes.data());
+    iov[1].iov_len = bytes.size();
+    alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int) * MAX_FDS)] = {};
+    msghdr msg{};
+    msg.msg_iov = iov;
+    msg.msg_iovlen = bytes.empty() ? 1 : 2;
+    msg.msg_control = control;
+    msg.msg_controllen = CMSG_SPACE(sizeof(int) * fds.size());
+    cmsghdr* cm = CMSG_FIRSTHDR(&msg);
+    cm->cmsg_level = SOL_SOCKET;
+    cm->cmsg_type = SCM_RIGHTS;
+    cm->cmsg_len = CMSG_LEN(sizeof(int) * fds.size());
+    std::memcpy(CMSG_DATA(cm), fds.data(), sizeof(int) * fds.size());
+    while(::sendmsg(channel, &msg, MSG_DONTWAIT | MSG_NOSIGNAL) < 0){
+        if(errno != EINTR){
+            return false;
+        }
+    }
+    return true;
+}
+/**
+ * @brief Takes the next message off the channel. fds may come back short (or empty) if
+ * the receiver ran out of descriptors.
+ * @return false if nothing is waiting.
+ */
+bool Handoff::receive(int channel, std::vector<int>& fds, std::vector<std::uint8_t>& bytes){
+    bytes.resize(MAX_BYTES + 1);
+    std::uint8_t marker;
+    iovec iov[2];
+    iov[0].iov_base = &marker;
+    iov[0].iov_len = 1;
+    iov[1].iov_base = bytes.data();
+    iov[1].iov_len = bytes.size();
+    alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int) * MAX_FDS)];
+    msghdr msg{};
+    msg.msg_iov = iov;
+    msg.msg_iovlen = 2;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+    ssize_t got;
+    while((got = ::recvmsg(channel, &msg, MSG_DONTWAIT | MSG_CMSG_CLOEXEC)) < 0){
+        if(errno != EINTR){
+            bytes.clear();
+            return false;
+        }
+    }
+    bytes.resize(got > 0 ? static_cast<std::size_t>(got) - 1 : 0);
+    fds.clear();
+    for(cmsghdr* cm = CMSG_FIRSTHDR(&msg); cm != nullptr; cm = CMSG_NXTHDR(&msg, cm)){
+        if(cm->cmsg_level == SOL_SOCKET && cm->cmsg_type == SCM_RIGHTS){
+            std::size_t count = (cm->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+            std::size_t at = fds.size();
+            fds.resize(at + count);
+            std::memcpy(fds.data() + at, CMSG_DATA(cm), sizeof(int) * count);
+        }
+    }
+    return true;
+}
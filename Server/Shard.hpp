@@ -0,0 +1,82 @@
+#ifndef SHARD_HPP
+#define SHARD_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @brief What every process knows about one shard (one Server loop), on its own cache line.
+ */
+struct alignas(64) ShardInfo{
+    std::atomic<std::int32_t> pid;          // worker process hosting it, 0 while down
+    std::atomic<std::uint32_t> matches;     // matches registered in the directory
+    std::atomic<std::uint32_t> next;        // sequence number of its next match id
+    std::atomic<std::uint32_t> restarts;
+};
+
+/**
+ * @brief Match id -> shard table in a shared anonymous mapping, created by the supervisor
+ * before it forks so every worker sees the same memory at the same address.
+ * Shard s hands out ids s + 1, s + 1 + shards, ... so ids never collide across shards, and
+ * registers each live match in slot id % capacity as one 64-bit word (id, shard + 1);
+ * every operation is a single atomic on that word, so workers never lock each other and a
+ * worker killed mid-update leaves no lock behind. A slot still taken by an older live match
+ * is skipped and the next id tried. When a worker dies the supervisor drops its shards'
+ * entries, so their matches read as gone until a restarted worker claims them again.
+ */
+class ShardDirectory{
+    public:
+        static constexpr unsigned MAX_SHARDS = 256;
+        static constexpr std::size_t DEFAULT_CAPACITY = std::size_t(1) << 20;
+
+    private:
+        struct Layout{
+            std::uint32_t shards;
+            std::uint32_t capacity;
+            ShardInfo info[MAX_SHARDS];
+        };
+        void* _map;
+        std::size_t _bytes;
+        Layout* _layout;
+        std::atomic<std::uint64_t>* _slots;
+        std::size_t _mask;
+
+        std::atomic<std::uint64_t>& slot(std::uint32_t id) const { return _slots[id & _mask]; }
+
+    public:
+        explicit ShardDirectory(unsigned shards, std::size_t capacity = DEFAULT_CAPACITY);
+        ~ShardDirectory();
+        ShardDirectory(const ShardDirectory&) = delete;
+        ShardDirectory& operator=(const ShardDirectory&) = delete;
+
+        unsigned shards() const { return _layout->shards; }
+        std::size_t capacity() const { return _mask + 1; }
+        std::uint32_t allocate(unsigned shard);
+        bool claim(std::uint32_t id, unsigned shard);
+        int lookup(std::uint32_t id) const;
+        void release(std::uint32_t id);
+        std::size_t drop(unsigned shard);
+        int least_loaded(unsigned prefer) const;
+        ShardInfo& info(unsigned shard) const { return _layout->info[shard]; }
+        bool up(unsigned shard) const { return info(shard).pid.load(std::memory_order_acquire) != 0; }
+};
+
+/**
+ * @brief Moves client connections to the shard that hosts their match instead of moving the
+ * match: the sockets are passed over a Unix datagram channel (SCM_RIGHTS) in one message
+ * with whatever the sender needs the receiver to know, such as the bytes already read
+ * from them, and the receiving loop carries on as if it had accepted them.
+ * Each shard reads one channel; every process holds the sending end of all of them.
+ */
+class Handoff{
+    public:
+        static constexpr std::size_t MAX_BYTES = 16 * 1024;
+        static constexpr std::size_t MAX_FDS = 8;
+
+        static void channel(int fds[2]);
+        static bool send(int channel, const std::vector<int>& fds, const std::vector<std::uint8_t>& bytes);
+        static bool receive(int channel, std::vector<int>& fds, std::vector<std::uint8_t>& bytes);
+};
+#endif
@@ -0,0 +1,123 @@
+#include "ShardLink.hpp"
+#include <utility>
+#include <unistd.h>
+
+namespace {
+// First byte of a handoff: one connection and the bytes read from it, or a formed table
+constexpr std::uint8_t HANDOFF_MOVE = 0;
+constexpr std::uint8_t HANDOFF_TABLE = 1;
+
+void close_all(const std::vector<int>& fds){
+    for(int fd : fds){
+        ::close(fd);
+    }
+}
+}
+
+/**
+ * @brief Joins shard shard of directory: connections for it arrive on inbox, and
+ * outboxes[s] reaches shard s. The descriptors stay the caller's.
+ */
+ShardLink::ShardLink(ShardDirectory& directory, unsigned shard, int inbox, std::vector<int> outboxes)
+    : _directory(directory), _shard(shard), _inbox(inbox), _outboxes(std::move(outboxes)), _handed_off(0), _taken_over(0)
+{}
+/**
+ * @return shard if it is another shard that is up and has a channel, else -1.
+ */
+int ShardLink::other(int shard) const{
+    if(shard < 0 || static_cast<unsigned>(shard) == _shard || static_cast<std::size_t>(shard) >= _outboxes.size() ||
+       !_directory.up(static_cast<unsigned>(shard))){
+        return -1;
+    }
+    return shard;
+}
+/**
+ * @brief Sends one connection and the bytes its new shard should read from it first.
+ * @return false if the channel is full; the connection is still the caller's.
+ */
+bool ShardLink::send_move(int shard, int fd, const std::vector<std::uint8_t>& bytes){
+    std::vector<std::uint8_t> message;
+    message.reserve(bytes.size() + 1);
+    message.push_back(HANDOFF_MOVE);
+    message.insert(message.end(), bytes.begin(), bytes.end());
+    if(!Handoff::send(_outboxes[shard], std::vector<int>(1, fd), message)){
+        return false;
+    }
+    _handed_off++;
+    return true;
+}
+/**
+ * @brief Sends every seat of a table in one message (names cut to 255 bytes).
+ * @return false if a seat has more than 64 KiB pending or the channel is full.
+ */
+bool ShardLink::send_table(int shard, const std::vector<TableSeat>& seats){
+    std::vector<int> fds;
+    std::vector<std::uint8_t> message{HANDOFF_TABLE, static_cast<std::uint8_t>(seats.size())};
+    for(const TableSeat& s : seats){
+        if(s.pending.size() > 0xffff){
+            return false;
+        }
+        std::size_t len = s.name.size() < 255 ? s.name.size() : 255;
+        message.push_back(static_cast<std::uint8_t>(len));
+        message.insert(message.end(), s.name.begin(), s.name.begin() + static_cast<std::ptrdiff_t>(len));
+        message.push_back(static_cast<std::uint8_t>(s.pending.size() & 0xff));
+        message.push_back(static_cast<std::uint8_t>(s.pending.size() >> 8));
+        message.insert(message.end(), s.pending.begin(), s.pending.end());
+        fds.push_back(s.fd);
+    }
+    if(!Handoff::send(_outboxes[shard], fds, message)){
+        return false;
+    }
+    _handed_off += fds.size();
+    return true;
+}
+/**
+ * @brief Takes the next well-formed message off the inbox; the sockets of malformed ones
+ * are closed and skipped.
+ * @return false once the inbox is empty.
+ */
+bool ShardLink::receive(Arrival& out){
+    std::vector<int> fds;
+    std::vector<std::uint8_t> bytes;
+    while(Handoff::receive(_inbox, fds, bytes)){
+        out.seats.clear();
+        if(!bytes.empty() && bytes[0] == HANDOFF_MOVE && fds.size() == 1){
+            out.table = false;
+            out.seats.push_back(TableSeat{fds[0], std::string(), std::vector<std::uint8_t>(bytes.begin() + 1, bytes.end())});
+            _taken_over++;
+            return true;
+        }
+        if(bytes.empty() || bytes[0] != HANDOFF_TABLE){
+            close_all(fds);
+            continue;
+        }
+        std::size_t pos = 2;
+        std::size_t seats = bytes.size() > 1 ? bytes[1] : 0;
+        for(std::size_t i = 0; i < seats && i < fds.size() && pos < bytes.size(); ++i){
+            std::size_t len = bytes[pos++];
+            if(bytes.size() - pos < len + 2){
+                break;
+            }
+            TableSeat s;
+            s.fd = fds[i];
+            s.name.assign(reinterpret_cast<const char*>(bytes.data() + pos), len);
+            pos += len;
+            std::size_t count = bytes[pos] | (static_cast<std::size_t>(bytes[pos + 1]) << 8);
+            pos += 2;
+            if(bytes.size() - pos < count){
+                break;
+            }
+            s.pending.assign(bytes.begin() + static_cast<std::ptrdiff_t>(pos), bytes.begin() + static_cast<std::ptrdiff_t>(pos + count));
+            pos += count;
+            out.seats.push_back(std::move(s));
+        }
+        if(seats < 2 || fds.size() != seats || out.seats.size() != seats){
+            close_all(fds);
+            continue;
+        }
+        out.table = true;
+        _taken_over += seats;
+        return true;
+    }
+    return false;
+}
@@ -0,0 +1,65 @@
+#ifndef SHARDLINK_HPP
+#define SHARDLINK_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "Shard.hpp"
+
+/**
+ * @brief One connection travelling between shards: its socket, the player's name (tables
+ * only) and the bytes read from it that the receiving loop should handle first.
+ */
+struct TableSeat{
+    int fd = -1;
+    std::string name;
+    std::vector<std::uint8_t> pending;
+};
+
+/**
+ * @brief What arrived on a shard's channel: one connection routed there, or every seat of
+ * a table formed elsewhere, in seat order, for this shard to open.
+ */
+struct Arrival{
+    bool table = false;
+    std::vector<TableSeat> seats;
+};
+
+/**
+ * @brief A server loop's place among the shards of a ShardDirectory: where its match ids
+ * come from, which shard hosts a match, and the channels connections travel on (see
+ * Handoff). A message starts with its kind: MOVE carries one connection and its bytes;
+ * TABLE carries u8 seats, then per seat a u8 name length, the name, a u16 count and that
+ * many bytes, with the fds in seat order. The loop keeps its own connection state; this
+ * only encodes, sends, decodes and counts what crosses.
+ */
+class ShardLink{
+    private:
+        ShardDirectory& _directory;
+        unsigned _shard;
+        int _inbox;
+        std::vector<int> _outboxes;            // sending end of every shard's channel
+        std::uint64_t _handed_off;
+        std::uint64_t _taken_over;
+
+    public:
+        ShardLink(ShardDirectory& directory, unsigned shard, int inbox, std::vector<int> outboxes);
+
+        unsigned shard() const { return _shard; }
+        int inbox() const { return _inbox; }
+        std::uint32_t allocate() { return _directory.allocate(_shard); }
+        void claim(std::uint32_t id) { _directory.claim(id, _shard); }
+        void release(std::uint32_t id) { _directory.release(id); }
+        int other(int shard) const;
+        int host(std::uint32_t id) const { return other(_directory.lookup(id)); }
+        int least_loaded() const { return other(_directory.least_loaded(_shard)); }
+
+        bool send_move(int shard, int fd, const std::vector<std::uint8_t>& bytes);
+        bool send_table(int shard, const std::vector<TableSeat>& seats);
+        bool receive(Arrival& out);
+
+        std::uint64_t handed_off() const { return _handed_off; }
+        std::uint64_t taken_over() const { return _taken_over; }
+};
+#endif
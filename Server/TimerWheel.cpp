@@ -0,0 +1,189 @@
+#include "TimerWheel.hpp"
+
+namespace {
+int level_of(std::uint64_t expires, std::uint64_t now){
+    std::uint64_t differ = expires ^ now;
+    int level = 0;
+    while(level < TimerWheel::LEVELS - 1 && (differ >> (8 * (level + 1))) != 0){
+        level++;
+    }
+    return level;
+}
+}
+
+TimerWheel::TimerWheel(std::uint64_t now)
+    : _free(NIL), _occupied{}, _counts{}, _size(0), _now(now)
+{
+    for(std::uint32_t& head : _heads){
+        head = NIL;
+    }
+}
+/**
+ * @brief Files a node in the slot its deadline maps to from the current tick.
+ * Deadlines past the current 2^32-tick epoch park in slot 0 of the top level, which
+ * cascades at every epoch boundary and re-files them.
+ */
+void TimerWheel::link(std::uint32_t i){
+    Node& n = _nodes[i];
+    std::uint64_t expires = n.expires;
+    int level = level_of(expires, _now);
+    std::uint64_t index = (expires >> (8 * level)) & (SLOTS - 1);
+    if(level == LEVELS - 1 && (expires >> (8 * LEVELS)) != (_now >> (8 * LEVELS))){
+        index = 0;
+    }
+    std::uint16_t slot = static_cast<std::uint16_t>(level * SLOTS + static_cast<int>(index));
+    n.slot = slot;
+    n.prev = NIL;
+    n.next = _heads[slot];
+    if(n.next != NIL){
+        _nodes[n.next].prev = i;
+    }
+    _heads[slot] = i;
+    _occupied[level][index / 64] |= std::uint64_t(1) << (index % 64);
+    _counts[level]++;
+}
+void TimerWheel::unlink(std::uint32_t i){
+    Node& n = _nodes[i];
+    int level = n.slot / SLOTS;
+    int index = n.slot % SLOTS;
+    if(n.prev != NIL){
+        _nodes[n.prev].next = n.next;
+    }
+    else{
+        _heads[n.slot] = n.next;
+    }
+    if(n.next != NIL){
+        _nodes[n.next].prev = n.prev;
+    }
+    if(_heads[n.slot] == NIL){
+        _occupied[level][index / 64] &= ~(std::uint64_t(1) << (index % 64));
+    }
+    _counts[level]--;
+    n.slot = NO_SLOT;
+}
+/**
+ * @brief Adds a timer firing at tick `at`; deadlines not after now() fire on the next advance.
+ * @param payload Handed back by advance() when the timer fires.
+ * @return Id for cancel(); never NONE.
+ */
+TimerWheel::TimerId TimerWheel::schedule(std::uint64_t at, std::uint64_t payload){
+    std::uint32_t i;
+    if(_free != NIL){
+        i = _free;
+        _free = _nodes[i].next;
+    }
+    else{
+        i = static_cast<std::uint32_t>(_nodes.size());
+        _nodes.push_back(Node{0, 0, NIL, NIL, 0, NO_SLOT});
+    }
+    Node& n = _nodes[i];
+    n.expires = at > _now ? at : _now + 1;
+    n.payload = payload;
+    n.generation++;
+    if(n.generation == 0){
+        n.generation = 1;
+    }
+    link(i);
+    _size++;
+    return (static_cast<TimerId>(n.generation) << 32) | i;
+}
+/**
+ * @return false if the timer already fired or was cancelled.
+ */
+bool TimerWheel::cancel(TimerId id){
+    std::uint32_t i = static_cast<std::uint32_t>(id);
+    if(id == NONE || i >= _nodes.size()){
+        return false;
+    }
+    Node& n = _nodes[i];
+    if(n.slot == NO_SLOT || n.generation != static_cast<std::uint32_t>(id >> 32)){
+        return false;
+    }
+    unlink(i);
+    n.next = _free;
+    _free = i;
+    _size--;
+    return true;
+}
+/**
+ * @brief Re-files every timer in one slot of a level; they land in lower levels.
+ */
+void TimerWheel::cascade(int level, std::uint64_t tick){
+    int index = static_cast<int>((tick >> (8 * level)) & (SLOTS - 1));
+    std::uint32_t i = _heads[level * SLOTS + index];
+    _heads[level * SLOTS + index] = NIL;
+    _occupied[level][index / 64] &= ~(std::uint64_t(1) << (index % 64));
+    while(i != NIL){
+        std::uint32_t next = _nodes[i].next;
+        _counts[level]--;
+        link(i);
+        i = next;
+    }
+}
+void TimerWheel::tick(std::vector<std::uint64_t>& expired){
+    _now++;
+    for(int level = LEVELS - 1; level > 0; --level){
+        if((_now & ((std::uint64_t(1) << (8 * level)) - 1)) == 0 && _counts[level] > 0){
+            cascade(level, _now);
+        }
+    }
+    int index = static_cast<int>(_now & (SLOTS - 1));
+    std::uint32_t i = _heads[index];
+    while(i != NIL){
+        Node& n = _nodes[i];
+        std::uint32_t next = n.next;
+        expired.push_back(n.payload);
+        _counts[0]--;
+        n.slot = NO_SLOT;
+        n.next = _free;
+        _free = i;
+        _size--;
+        i = next;
+    }
+    _heads[index] = NIL;
+    _occupied[0][index / 64] &= ~(std::uint64_t(1) << (index % 64));
+}
+/**
+ * @brief Moves the wheel to tick `now`, appending the payloads of the timers due by then
+ * in deadline order. Runs of ticks that cannot fire or cascade anything are skipped, so
+ * catching up costs one step per occupied period of the lowest non-empty level.
+ */
+void TimerWheel::advance(std::uint64_t now, std::vector<std::uint64_t>& expired){
+    while(_now < now){
+        if(_size == 0){
+            _now = now;
+            return;
+        }
+        int lowest = 0;
+        while(_counts[lowest] == 0){
+            lowest++;
+        }
+        if(lowest > 0){
+            std::uint64_t last = _now | ((std::uint64_t(1) << (8 * lowest)) - 1);   // tick before its next cascade
+            if(last >= now){
+                _now = now;
+                return;
+            }
+            _now = last;
+        }
+        tick(expired);
+    }
+}
+/**
+ * @brief Lower bound on the ticks until the next timer fires (a cascade may come first,
+ * after which it is exact again); 0 if one is overdue, UINT64_MAX if none are pending.
+ */
+std::uint64_t TimerWheel::next_due() const{
+    if(_size == 0){
+        return UINT64_MAX;
+    }
+    if(_counts[0] > 0){
+        for(std::uint64_t d = 1; d <= SLOTS; ++d){
+            std::uint64_t index = (_now + d) & (SLOTS - 1);
+            if(_occupied[0][index / 64] & (std::uint64_t(1) << (index % 64))){
+                return d;
+            }
+        }
+    }
+    return SLOTS - (_now & (SLOTS - 1));
+}
@@ -0,0 +1,60 @@
+#ifndef TIMERWHEEL_HPP
+#define TIMERWHEEL_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @brief Hierarchical timer wheel: 4 levels of 256 slots over integer ticks (2^32 ticks of range).
+ * A timer sits in the level of the highest byte in which its deadline differs from now, and
+ * moves down a level each time the wheel below it wraps, so schedule and cancel are O(1)
+ * (an intrusive doubly linked list per slot) and each timer is touched at most 4 times.
+ * Nodes live in one pooled vector with a free list; ids carry a generation so a stale id
+ * never cancels the node's next occupant. Owned and driven by one thread (the event loop).
+ */
+class TimerWheel{
+    public:
+        using TimerId = std::uint64_t;
+        static constexpr TimerId NONE = 0;
+        static constexpr int LEVELS = 4;
+        static constexpr int SLOTS = 256;
+
+    private:
+        static constexpr std::uint32_t NIL = 0xffffffffu;
+
+        struct Node{
+            std::uint64_t expires;
+            std::uint64_t payload;
+            std::uint32_t prev;
+            std::uint32_t next;           // also links the free list
+            std::uint32_t generation;
+            std::uint16_t slot;           // level * SLOTS + index; NO_SLOT when free
+        };
+        static constexpr std::uint16_t NO_SLOT = 0xffff;
+
+        std::vector<Node> _nodes;
+        std::uint32_t _free;
+        std::uint32_t _heads[LEVELS * SLOTS];
+        std::uint64_t _occupied[LEVELS][SLOTS / 64];
+        std::size_t _counts[LEVELS];
+        std::size_t _size;
+        std::uint64_t _now;
+
+        void link(std::uint32_t i);
+        void unlink(std::uint32_t i);
+        void cascade(int level, std::uint64_t tick);
+        void tick(std::vector<std::uint64_t>& expired);
+
+    public:
+        explicit TimerWheel(std::uint64_t now = 0);
+
+        TimerId schedule(std::uint64_t at, std::uint64_t payload);
+        bool cancel(TimerId id);
+        void advance(std::uint64_t now, std::vector<std::uint64_t>& expired);
+        std::uint64_t next_due() const;
+
+        std::uint64_t now() const { return _now; }
+        std::size_t size() const { return _size; }
+};
+#endif
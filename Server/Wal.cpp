@@ -0,0 +1,205 @@
+#include "Wal.hpp"
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <unordered_map>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+std::runtime_error sys_error(const std::string& what){
+    return std::runtime_error(what + ": " + std::strerror(errno));
+}
+std::uint32_t fnv1a(const std::uint8_t* data, std::size_t size){
+    std::uint32_t h = 2166136261u;
+    for(std::size_t i = 0; i < size; ++i){
+        h = (h ^ data[i]) * 16777619u;
+    }
+    return h;
+}
+void put_u32(std::uint8_t* out, std::uint32_t v){
+    std::memcpy(out, &v, 4);
+}
+std::uint32_t get_u32(const std::uint8_t* in){
+    std::uint32_t v;
+    std::memcpy(&v, in, 4);
+    return v;
+}
+}
+
+/**
+ * @brief Opens (or creates) the log at path for appending, first cutting any torn tail.
+ * @param commit_bytes Buffered size at which full() asks the owner to commit.
+ * @throws std::runtime_error if the file cannot be opened.
+ */
+Wal::Wal(const std::string& path, std::size_t commit_bytes)
+    : _fd(-1), _path(path), _commit_bytes(commit_bytes), _file_bytes(0), _appended(0), _durable(0), _commits(0), _pending(0)
+{
+    repair(path);
+    _fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    if(_fd < 0){
+        throw sys_error("Cannot open write-ahead log " + path);
+    }
+    struct stat st;
+    if(::fstat(_fd, &st) == 0){
+        _file_bytes = static_cast<std::size_t>(st.st_size);
+    }
+    _buffer.reserve(commit_bytes < (std::size_t(1) << 20) ? commit_bytes : (std::size_t(1) << 20));
+}
+Wal::~Wal(){
+    try {
+        commit();
+    } catch (const std::exception&) {
+        // Destructors must not throw; call commit() to see write errors
+    }
+    if(_fd >= 0){
+        ::close(_fd);
+    }
+}
+/**
+ * @brief Buffers one record; it is durable once the next commit() returns.
+ */
+void Wal::append(WalKind kind, std::uint32_t match, std::uint32_t version, const std::uint8_t* body, std::size_t size){
+    std::size_t at = _buffer.size();
+    _buffer.resize(at + HEADER_SIZE + size);
+    std::uint8_t* rec = _buffer.data() + at;
+    put_u32(rec, static_cast<std::uint32_t>(HEADER_SIZE - 4 + size));
+    rec[8] = static_cast<std::uint8_t>(kind);
+    put_u32(rec + 9, match);
+    put_u32(rec + 13, version);
+    if(size > 0){
+        std::memcpy(rec + HEADER_SIZE, body, size);
+    }
+    put_u32(rec + 4, fnv1a(rec + 8, HEADER_SIZE - 8 + size));
+    _appended++;
+    _pending++;
+}
+/**
+ * @brief Writes everything buffered and syncs it: one fdatasync for the whole group.
+ * @return false if there was nothing to commit.
+ * @throws std::runtime_error on a write or sync error; the file is cut back to its last
+ * durable size and the buffer kept for a retry.
+ */
+bool Wal::commit(){
+    if(_buffer.empty()){
+        return false;
+    }
+    const std::uint8_t* data = _buffer.data();
+    std::size_t left = _buffer.size();
+    while(left > 0){
+        ssize_t n = ::write(_fd, data, left);
+        if(n < 0){
+            if(errno == EINTR){
+                continue;
+            }
+            std::runtime_error e = sys_error("write-ahead log write");
+            ::ftruncate(_fd, static_cast<off_t>(_file_bytes));
+            throw e;
+        }
+        data += n;
+        left -= static_cast<std::size_t>(n);
+    }
+    if(::fdatasync(_fd) != 0){
+        std::runtime_error e = sys_error("write-ahead log sync");
+        ::ftruncate(_fd, static_cast<off_t>(_file_bytes));
+        throw e;
+    }
+    _file_bytes += _buffer.size();
+    _buffer.clear();
+    _durable += _pending;
+    _pending = 0;
+    _commits++;
+    return true;
+}
+/**
+ * @brief Reads every intact record of the log at path, stopping at the first short or
+ * corrupt one. A missing file is an empty log.
+ */
+WalScan Wal::scan(const std::string& path){
+    WalScan result;
+    std::ifstream in(path, std::ios::binary);
+    if(!in){
+        return result;
+    }
+    std::vector<std::uint8_t> bytes((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    result.file_bytes = bytes.size();
+    std::size_t pos = 0;
+    while(bytes.size() - pos >= HEADER_SIZE){
+        const std::uint8_t* rec = bytes.data() + pos;
+        std::size_t len = get_u32(rec);
+        if(len < HEADER_SIZE - 4 || bytes.size() - pos - 4 < len){
+            break;
+        }
+        if(fnv1a(rec + 8, len - 4) != get_u32(rec + 4)){
+            break;
+        }
+        WalRecord r;
+        r.kind = static_cast<WalKind>(rec[8]);
+        r.match = get_u32(rec + 9);
+        r.version = get_u32(rec + 13);
+        r.body.assign(rec + HEADER_SIZE, rec + 4 + len);
+        result.records.push_back(std::move(r));
+        pos += 4 + len;
+    }
+    result.valid_bytes = pos;
+    return result;
+}
+/**
+ * @brief Truncates the log at path to its intact prefix.
+ * @return Bytes cut off (0 if the log was clean or missing).
+ * @throws std::runtime_error if the file cannot be truncated.
+ */
+std::size_t Wal::repair(const std::string& path){
+    WalScan s = scan(path);
+    if(s.valid_bytes == s.file_bytes){
+        return 0;
+    }
+    if(::truncate(path.c_str(), static_cast<off_t>(s.valid_bytes)) != 0){
+        throw sys_error("Cannot truncate write-ahead log " + path);
+    }
+    return s.file_bytes - s.valid_bytes;
+}
+/**
+ * @brief Folds the records of a scan into one entry per match, in order of first record.
+ * Ids restart with the server, so a BEGIN for an id whose match already finished opens a
+ * new entry; a BEGIN for an unfinished one (a match restored from a checkpoint) replaces
+ * its log and keeps the rest.
+ */
+std::vector<WalMatch> Wal::recover(const WalScan& scan){
+    std::vector<WalMatch> matches;
+    std::unordered_map<std::uint32_t, std::size_t> current;
+    for(const WalRecord& r : scan.records){
+        auto it = current.find(r.match);
+        if(it == current.end() || (r.kind == WalKind::BEGIN && matches[it->second].finished)){
+            matches.emplace_back();
+            matches.back().match = r.match;
+            it = current.insert_or_assign(r.match, matches.size() - 1).first;
+        }
+        WalMatch& m = matches[it->second];
+        m.version = r.version;
+        switch(r.kind){
+            case WalKind::BEGIN:
+                m.log = r.body;
+                break;
+            case WalKind::EVENTS:
+                m.log.insert(m.log.end(), r.body.begin(), r.body.end());
+                break;
+            case WalKind::FORFEIT:
+                if(!r.body.empty()){
+                    m.forfeits.push_back(r.body[0]);
+                }
+                break;
+            case WalKind::FINISH:
+                if(!r.body.empty()){
+                    m.finished = true;
+                    m.winner = r.body[0];
+                    m.winner_name.assign(r.body.begin() + 1, r.body.end());
+                }
+                break;
+        }
+    }
+    return matches;
+}
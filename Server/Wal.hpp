@@ -0,0 +1,97 @@
+#ifndef WAL_HPP
+#define WAL_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * @brief What a log record says about its match.
+ */
+enum class WalKind : std::uint8_t{
+    BEGIN = 1,      // body starts the match's EventLog (header included)
+    EVENTS,         // body continues it with whole event records
+    FORFEIT,        // body: u8 seat that left
+    FINISH,         // body: u8 winner seat, winner name
+};
+
+struct WalRecord{
+    WalKind kind;
+    std::uint32_t match;
+    std::uint32_t version;
+    std::vector<std::uint8_t> body;
+};
+
+/**
+ * @brief Result of reading a log back: its intact records and where they end.
+ * A crash mid-commit can leave a torn last record; valid_bytes is the prefix that
+ * checks out and everything after it was never acknowledged.
+ */
+struct WalScan{
+    std::vector<WalRecord> records;
+    std::size_t valid_bytes = 0;
+    std::size_t file_bytes = 0;
+};
+
+/**
+ * @brief One match as the log tells it. log holds the match's EventLog bytes from its
+ * last BEGIN (a restored match starts a new log), so EventReader can decode it.
+ */
+struct WalMatch{
+    std::uint32_t match = 0;
+    std::uint32_t version = 0;            // last version logged
+    std::vector<std::uint8_t> log;
+    std::vector<int> forfeits;
+    bool finished = false;
+    int winner = -1;
+    std::string winner_name;
+};
+
+/**
+ * @brief Append-only write-ahead log shared by every match of a server loop.
+ * Records are framed as u32 length, u32 FNV-1a checksum of the rest, u8 kind, u32 match,
+ * u32 version, then the body (host order). append() only copies into a memory buffer;
+ * commit() writes the whole buffer and makes it durable with a single fdatasync, so one
+ * sync covers every record appended since the last one, from any number of matches.
+ * The owner decides when to commit: on a timer, once commit_bytes are buffered, or when
+ * a record must be durable before the client hears about it.
+ * Opening a log drops a torn tail left by a crash, so new records follow intact ones.
+ */
+class Wal{
+    private:
+        int _fd;
+        std::string _path;
+        std::vector<std::uint8_t> _buffer;
+        std::size_t _commit_bytes;
+        std::size_t _file_bytes;       // durable size; a failed commit is cut back to it
+        std::uint64_t _appended;
+        std::uint64_t _durable;
+        std::uint64_t _commits;
+        std::uint64_t _pending;        // records in _buffer
+
+    public:
+        static constexpr std::size_t HEADER_SIZE = 17;
+        static constexpr std::size_t DEFAULT_COMMIT_BYTES = std::size_t(1) << 20;
+
+        explicit Wal(const std::string& path, std::size_t commit_bytes = DEFAULT_COMMIT_BYTES);
+        ~Wal();
+        Wal(const Wal&) = delete;
+        Wal& operator=(const Wal&) = delete;
+
+        void append(WalKind kind, std::uint32_t match, std::uint32_t version,
+                    const std::uint8_t* body = nullptr, std::size_t size = 0);
+        bool commit();
+
+        std::size_t buffered() const { return _buffer.size(); }
+        bool full() const { return _buffer.size() >= _commit_bytes; }
+        std::uint64_t appended() const { return _appended; }
+        std::uint64_t durable() const { return _durable; }
+        std::uint64_t commits() const { return _commits; }
+        const std::string& path() const { return _path; }
+
+        static WalScan scan(const std::string& path);
+        static std::size_t repair(const std::string& path);
+        static std::vector<WalMatch> recover(const WalScan& scan);
+};
+#endif
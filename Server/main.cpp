@@ -0,0 +1,282 @@
+#include "Server.hpp"
+#include "Shard.hpp"
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace {
+struct Options{
+    int port = 7777;
+    unsigned loops = 1;
+    std::uint32_t reaction_ms = Server::DEFAULT_REACTION_MS;
+    std::uint32_t turn_ms = Server::DEFAULT_TURN_MS;
+    std::string checkpoint;
+    std::uint32_t checkpoint_ms = 0;
+    std::string wal;
+    std::uint32_t wal_ms = 10;
+    unsigned workers = 1;
+    std::uint32_t match_tick_ms = 0;
+};
+
+std::vector<std::unique_ptr<Server>>* running = nullptr;
+volatile std::sig_atomic_t stopping = 0;
+volatile pid_t children[ShardDirectory::MAX_SHARDS] = {};
+
+// stop() only stores an atomic and writes an eventfd, both safe in a signal handler
+void on_signal(int){
+    stopping = 1;
+    if(running){
+        for(auto& server : *running){
+            server->stop();
+        }
+    }
+}
+// The supervisor passes the signal on; kill() is safe in a signal handler too
+void on_supervisor_signal(int){
+    stopping = 1;
+    for(pid_t pid : children){
+        if(pid > 0){
+            ::kill(pid, SIGTERM);
+        }
+    }
+}
+void handle_signals(void (*handler)(int)){
+    struct sigaction sa{};
+    sa.sa_handler = handler;
+    sigemptyset(&sa.sa_mask);
+    ::sigaction(SIGINT, &sa, nullptr);
+    ::sigaction(SIGTERM, &sa, nullptr);
+}
+
+// Workers each bind their own SO_REUSEPORT sockets, so port 0 is resolved once up front
+std::uint16_t free_port(){
+    int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    socklen_t len = sizeof(addr);
+    ::bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr));
+    ::getsockname(fd, reinterpret_cast<sockaddr*>(&addr), &len);
+    ::close(fd);
+    return ntohs(addr.sin_port);
+}
+
+/**
+ * @brief Hosts shards first .. first + loops - 1, one epoll loop each, until stopped.
+ * @return Exit status.
+ */
+int run_worker(const Options& o, ShardDirectory& directory, const std::vector<int>& inboxes,
+               const std::vector<int>& outboxes, unsigned first){
+    try {
+        std::vector<std::unique_ptr<Server>> servers;
+        for(unsigned i = 0; i < o.loops; ++i){
+            servers.push_back(std::make_unique<Server>(static_cast<std::uint16_t>(o.port)));
+        }
+        for(unsigned i = 0; i < o.loops; ++i){
+            unsigned shard = first + i;
+            Server& server = *servers[i];
+            server.set_timeouts(o.reaction_ms, o.turn_ms);
+            server.set_shard(directory, shard, inboxes[shard], outboxes);
+            if(!o.checkpoint.empty()){
+                std::string path = o.checkpoint + "." + std::to_string(shard);
+                std::size_t restored = server.restore(path, std::thread::hardware_concurrency());
+                if(restored > 0){
+                    std::cout << "shard " << shard << ": restored " << restored << " matches from " << path << std::endl;
+                }
+                server.set_checkpoint(path, o.checkpoint_ms);
+            }
+            if(!o.wal.empty()){
+                server.set_wal(o.wal + "." + std::to_string(shard), o.wal_ms);
+            }
+            if(o.match_tick_ms > 0){
+                server.set_matchmaking(o.match_tick_ms);
+            }
+            directory.info(shard).pid.store(static_cast<std::int32_t>(::getpid()), std::memory_order_release);
+        }
+        running = &servers;
+        handle_signals(on_signal);
+        if(stopping){
+            on_signal(SIGTERM);                      // signalled before the servers existed
+        }
+        std::cout << "pid " << ::getpid() << " hosting shards " << first << "-" << first + o.loops - 1
+                  << " on port " << servers[0]->port() << std::endl;
+        std::vector<std::thread> threads;
+        for(unsigned i = 1; i < o.loops; ++i){
+            threads.emplace_back([&servers, i](){ servers[i]->run(); });
+        }
+        servers[0]->run();
+        for(std::thread& t : threads){
+            t.join();
+        }
+        running = nullptr;
+        for(unsigned i = 0; i < o.loops; ++i){
+            unsigned shard = first + i;
+            if(!o.checkpoint.empty()){
+                std::size_t saved = servers[i]->checkpoint(o.checkpoint + "." + std::to_string(shard));
+                std::cout << "shard " << shard << ": checkpointed " << saved << " matches" << std::endl;
+            }
+            directory.info(shard).pid.store(0, std::memory_order_release);
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "coup_server: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
+pid_t spawn(const Options& o, ShardDirectory& directory, const std::vector<int>& inboxes,
+            const std::vector<int>& outboxes, unsigned worker){
+    std::cout.flush();
+    pid_t pid = ::fork();
+    if(pid == 0){
+        for(volatile pid_t& child : children){
+            child = 0;
+        }
+        handle_signals(on_signal);
+        int status = run_worker(o, directory, inboxes, outboxes, worker * o.loops);
+        std::cout.flush();
+        ::_exit(status);
+    }
+    if(pid < 0){
+        throw std::runtime_error("fork failed");
+    }
+    children[worker] = pid;
+    return pid;
+}
+
+/**
+ * @brief Forks the workers and restarts any that dies, after dropping its shards from the
+ * directory; the other workers and their matches carry on. Returns once all have exited
+ * after SIGINT/SIGTERM, which is passed on to them.
+ */
+int supervise(const Options& o, ShardDirectory& directory, const std::vector<int>& inboxes, const std::vector<int>& outboxes){
+    using Clock = std::chrono::steady_clock;
+    handle_signals(on_supervisor_signal);
+    std::vector<Clock::time_point> started(o.workers);
+    for(unsigned w = 0; w < o.workers && !stopping; ++w){
+        spawn(o, directory, inboxes, outboxes, w);
+        started[w] = Clock::now();
+    }
+    unsigned alive = 0;
+    for(unsigned w = 0; w < o.workers; ++w){
+        alive += children[w] > 0 ? 1 : 0;
+    }
+    while(alive > 0){
+        int status = 0;
+        pid_t pid = ::waitpid(-1, &status, 0);
+        if(pid < 0){
+            if(errno == EINTR){
+                continue;
+            }
+            break;
+        }
+        unsigned w = 0;
+        while(w < o.workers && children[w] != pid){
+            ++w;
+        }
+        if(w == o.workers){
+            continue;
+        }
+        children[w] = 0;
+        std::size_t dropped = 0;
+        for(unsigned shard = w * o.loops; shard < (w + 1) * o.loops; ++shard){
+            directory.info(shard).pid.store(0, std::memory_order_release);
+            dropped += directory.drop(shard);
+        }
+        if(stopping){
+            alive--;
+            continue;
+        }
+        std::cout << "worker " << w << " (pid " << pid << ") "
+                  << (WIFSIGNALED(status) ? "killed by signal " + std::to_string(WTERMSIG(status))
+                                          : "exited with " + std::to_string(WEXITSTATUS(status)))
+                  << ", " << dropped << " matches lost until it restores; restarting" << std::endl;
+        if(Clock::now() - started[w] < std::chrono::seconds(1)){
+            std::this_thread::sleep_for(std::chrono::seconds(1));     // do not spin on a worker that cannot start
+        }
+        for(unsigned shard = w * o.loops; shard < (w + 1) * o.loops; ++shard){
+            directory.info(shard).restarts.fetch_add(1, std::memory_order_relaxed);
+        }
+        if(stopping){
+            alive--;
+            continue;
+        }
+        spawn(o, directory, inboxes, outboxes, w);
+        started[w] = Clock::now();
+    }
+    return 0;
+}
+}
+
+/**
+ * coup_server [port] [loops] [reaction_ms] [turn_ms] [checkpoint] [checkpoint_ms] [wal] [wal_ms] [workers] [match_tick_ms]
+ * Starts one epoll loop per core (or per the given count), all accepting on the same port.
+ * Unanswered block windows are allowed after reaction_ms and idle turns auto-played after
+ * turn_ms (0 waits forever).
+ * Every loop is a shard of one match directory: a WATCH or RESUME that lands on the wrong
+ * loop is handed to the loop hosting the match, connection and all.
+ * With workers > 1 a supervisor forks that many processes of loops shards each and
+ * restarts any that dies; only the matches of the dead worker's shards are lost (or, with
+ * a checkpoint, restored by its replacement).
+ * With a checkpoint path, shard i restores the matches saved in "<checkpoint>.<i>" on start,
+ * saves them again every checkpoint_ms (0: only on exit) and on SIGINT/SIGTERM.
+ * With a WAL path, shard i appends every move, forfeit and result to "<wal>.<i>", committed
+ * every wal_ms (0: by size, and whenever a match ends); inspect it with coup_wal.
+ * With match_tick_ms, JOINs are matchmade instead of seated first come, first served: shard
+ * 0 queues every shard's players by table size and rating (the optional u16 after the name)
+ * and forms tables every match_tick_ms, each on the shard hosting the fewest matches.
+ * Restart with the same loop and worker counts.
+ */
+int main(int argc, char* argv[]){
+    Options o;
+    o.port = argc > 1 ? std::atoi(argv[1]) : o.port;
+    o.loops = argc > 2 ? static_cast<unsigned>(std::atoi(argv[2])) : std::thread::hardware_concurrency();
+    o.reaction_ms = argc > 3 ? static_cast<std::uint32_t>(std::atoi(argv[3])) : o.reaction_ms;
+    o.turn_ms = argc > 4 ? static_cast<std::uint32_t>(std::atoi(argv[4])) : o.turn_ms;
+    o.checkpoint = argc > 5 ? argv[5] : "";
+    o.checkpoint_ms = argc > 6 ? static_cast<std::uint32_t>(std::atoi(argv[6])) : 0;
+    o.wal = argc > 7 ? argv[7] : "";
+    o.wal_ms = argc > 8 ? static_cast<std::uint32_t>(std::atoi(argv[8])) : o.wal_ms;
+    o.workers = argc > 9 ? static_cast<unsigned>(std::atoi(argv[9])) : 1;
+    o.match_tick_ms = argc > 10 ? static_cast<std::uint32_t>(std::atoi(argv[10])) : 0;
+    if(o.loops == 0){
+        o.loops = 1;
+    }
+    if(o.workers == 0){
+        o.workers = 1;
+    }
+    try {
+        ShardDirectory directory(o.workers * o.loops);
+        std::vector<int> inboxes(directory.shards());
+        std::vector<int> outboxes(directory.shards());
+        for(unsigned shard = 0; shard < directory.shards(); ++shard){
+            int fds[2];
+            Handoff::channel(fds);
+            outboxes[shard] = fds[0];
+            inboxes[shard] = fds[1];
+        }
+        if(o.workers == 1){
+            return run_worker(o, directory, inboxes, outboxes, 0);
+        }
+        if(o.port == 0){
+            o.port = free_port();
+        }
+        std::cout << "coup_server supervising " << o.workers << " workers of " << o.loops
+                  << " loops on port " << o.port << std::endl;
+        return supervise(o, directory, inboxes, outboxes);
+    } catch (const std::exception& e) {
+        std::cerr << "coup_server: " << e.what() << std::endl;
+        return 1;
+    }
+}
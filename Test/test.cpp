@@ -9,10 +9,39 @@
 #include "../Players/Spy.hpp"
 #include "../Players/PlayerFactory.hpp"
 #include "../Game.hpp"
+#include "../Engine/Reaction.hpp"
+#include "../Engine/EventLog.hpp"
+#include "../Engine/Replay.hpp"
+#include "../Engine/Archive.hpp"
+#include "../Engine/Deal.hpp"
+#include "../Engine/Snapshot.hpp"
+#include "../Engine/History.hpp"
+#include "../Engine/CowState.hpp"
+#include "../Engine/TurnFlow.hpp"
+#include "../Engine/Strategy.hpp"
+#include "../Engine/Simulator.hpp"
+#include "../Engine/Rating.hpp"
+#include "../Engine/Mcts.hpp"
+#include "../Engine/Cfr.hpp"
+#include "../Engine/Tournament.hpp"
+#include "../Server/Server.hpp"
+#include "../Server/Client.hpp"
+#include "../Server/Match.hpp"
+#include "../Server/Checkpoint.hpp"
+#include "../Server/TimerWheel.hpp"
+#include "../Server/Matchmaker.hpp"
+#include "../Server/Shard.hpp"
+#include "../Server/Wal.hpp"
+#include "../Server/Journal.hpp"
+#include "../Tools/Histogram.hpp"
 #include <iostream>
 #include <vector>
 #include <stdexcept>
+#include <cstdio>
+#include <fstream>
+#include <thread>
 #include <string>
+#include <unistd.h>
 
 TEST_CASE("Game Singleton Pattern") {
     Game& game1 = Game::instance();
@@ -1068,6 +1097,2031 @@ TEST_CASE("Spy Special Abilities - Complete") {
     }
 }
 
+TEST_CASE("Player List Capacity") {
+    Game& game = Game::instance();
+    game.get_players().clear();
+
+    SUBCASE("Seats Are Bounded By COUP_MAX_PLAYERS") {
+        std::vector<Player*> seated;
+        for (int i = 0; i < PlayerList::CAPACITY; ++i) {
+            seated.push_back(new Player(game, "Seat" + std::to_string(i)));
+            game.get_players().push_back(seated.back());
+        }
+        CHECK(game.get_players().size() == PlayerList::capacity());
+
+        Player extra(game, "Extra");
+        CHECK_THROWS_AS(game.get_players().push_back(&extra), std::runtime_error);
+        CHECK_THROWS_AS(game.get_players().reserve(PlayerList::capacity() + 1), std::runtime_error);
+
+        int count = 0;
+        for (Player* p : game.get_players()) {
+            CHECK(p == seated[count]);
+            count++;
+        }
+        CHECK(count == PlayerList::CAPACITY);
+
+        game.get_players().clear();
+        CHECK(game.get_players().empty());
+        for (Player* p : seated) {
+            delete p;
+        }
+    }
+}
+
+TEST_CASE("Per-Seat State Arrays") {
+    Game& game = Game::instance();
+    game.get_players().clear();
+
+    SUBCASE("Seating Copies State And Role") {
+        Merchant* merchant = new Merchant(game, "MerchantPlayer");
+        Player* player = new Player(game, "Player");
+        merchant->set_coins(4);
+
+        game.get_players().push_back(merchant);
+        game.get_players().push_back(player);
+
+        PlayerList& players = game.get_players();
+        CHECK(merchant->get_seat() == 0);
+        CHECK(player->get_seat() == 1);
+        CHECK(players.role(0) == Role::MERCHANT);
+        CHECK(players.role(1) == Role::CITIZEN);
+        CHECK(players.coins(0) == 4);
+        CHECK(players.active_mask() == 0b11);
+        CHECK(players.seated_mask() == 0b11);
+        delete merchant;
+        delete player;
+    }
+
+    SUBCASE("Actions Keep Arrays In Sync") {
+        Player* sanctioner = new Player(game, "Sanctioner");
+        Player* target = new Player(game, "Target");
+        game.get_players().push_back(sanctioner);
+        game.get_players().push_back(target);
+        game.set_turn(0);
+
+        sanctioner->set_coins(10);
+        sanctioner->coup(*target);
+
+        PlayerList& players = game.get_players();
+        CHECK(players.coins(0) == 3);
+        CHECK(players.is_active(1) == false);
+        CHECK(players.active_mask() == 0b01);
+
+        target->set_isActive(true);
+        target->set_isSanction(true);
+        target->set_lastArrested(true);
+        CHECK(players.active_mask() == 0b11);
+        CHECK(players.sanction_mask() == 0b10);
+        CHECK(players.arrested_mask() == 0b10);
+
+        game.get_players().clear();
+        CHECK(players.active_mask() == 0);
+        delete sanctioner;
+        delete target;
+    }
+}
+
+TEST_CASE("Blocker Masks") {
+    Game& game = Game::instance();
+    game.get_players().clear();
+
+    SUBCASE("Eligible Blockers Per Action") {
+        Player* actor = new Player(game, "Actor");
+        General* general = new General(game, "General");
+        Governor* governor = new Governor(game, "Governor");
+        Judge* judge = new Judge(game, "Judge");
+        General* poorGeneral = new General(game, "PoorGeneral");
+
+        game.get_players().push_back(actor);
+        game.get_players().push_back(general);
+        game.get_players().push_back(governor);
+        game.get_players().push_back(judge);
+        game.get_players().push_back(poorGeneral);
+
+        general->set_coins(5);
+        poorGeneral->set_coins(4);
+
+        CHECK(game.get_players().role_mask(Role::GENERAL) == 0b10010);
+        CHECK(game.blockers_for(GameAction::COUP, 0) == 0b00010);
+        CHECK(game.blockers_for(GameAction::TAX, 0) == 0b00100);
+        CHECK(game.blockers_for(GameAction::BRIBE, 0) == 0b01000);
+        CHECK(game.blockers_for(GameAction::GATHER, 0) == 0);
+        CHECK(game.blockers_for(GameAction::TAX, 2) == 0); // cannot block yourself
+
+        poorGeneral->set_coins(7);
+        CHECK(game.blockers_for(GameAction::COUP, 0) == 0b10010);
+
+        general->set_isActive(false); // couped
+        CHECK(game.blockers_for(GameAction::COUP, 0) == 0b10000);
+        general->set_isActive(true);  // coup blocked / reactivated
+        CHECK(game.blockers_for(GameAction::COUP, 0) == 0b10010);
+
+        game.get_players().clear();   // reset
+        CHECK(game.get_players().role_mask(Role::GENERAL) == 0);
+        delete actor;
+        delete general;
+        delete governor;
+        delete judge;
+        delete poorGeneral;
+    }
+}
+
+TEST_CASE("Reaction Pipeline") {
+    Game& game = Game::instance();
+    game.get_players().clear();
+
+    SUBCASE("Governor Blocks Tax Through Policy") {
+        Player* actor = new Player(game, "Actor");
+        Governor* governor = new Governor(game, "Governor");
+        game.get_players().push_back(actor);
+        game.get_players().push_back(governor);
+        game.set_turn(0);
+
+        actor->tax();
+        Reaction reaction(game, GameAction::TAX, 0);
+        CHECK(reaction.is_open());
+        CHECK(reaction.current_blocker() == 1);
+
+        BlockAllPolicy block;
+        CHECK(reaction.resolve(block) == 1);
+        CHECK(actor->get_coins() == 0);
+        CHECK_FALSE(reaction.is_open());
+        delete actor;
+        delete governor;
+    }
+
+    SUBCASE("Allowed Tax Stands") {
+        Player* actor = new Player(game, "Actor");
+        Governor* governor = new Governor(game, "Governor");
+        game.get_players().push_back(actor);
+        game.get_players().push_back(governor);
+        game.set_turn(0);
+
+        actor->tax();
+        Reaction reaction(game, GameAction::TAX, 0);
+        AllowAllPolicy allow;
+        CHECK(reaction.resolve(allow) == -1);
+        CHECK(actor->get_coins() == 2);
+        delete actor;
+        delete governor;
+    }
+
+    SUBCASE("Second General Blocks Coup In Seat Order") {
+        Player* couper = new Player(game, "Couper");
+        General* poorGeneral = new General(game, "PoorGeneral");
+        Player* target = new Player(game, "Target");
+        General* general = new General(game, "General");
+        game.get_players().push_back(couper);
+        game.get_players().push_back(poorGeneral);
+        game.get_players().push_back(target);
+        game.get_players().push_back(general);
+        game.set_turn(0);
+
+        couper->set_coins(7);
+        general->set_coins(5);
+        couper->coup(*target);
+        CHECK(target->get_isActive() == false);
+
+        Reaction reaction(game, GameAction::COUP, 0, 2);
+        CHECK(reaction.get_pending() == 0b1000); // poor General cannot pay
+        BlockAllPolicy block;
+        CHECK(reaction.resolve(block) == 3);
+        CHECK(target->get_isActive() == true);
+        CHECK(general->get_coins() == 0);
+        CHECK(couper->get_lastAction() == GameAction::NONE);
+        CHECK(game.get_turn() == 1);
+        delete couper;
+        delete poorGeneral;
+        delete target;
+        delete general;
+    }
+
+    SUBCASE("Judge Block Ends Bribe Turn") {
+        Player* briber = new Player(game, "Briber");
+        Judge* judge = new Judge(game, "Judge");
+        game.get_players().push_back(briber);
+        game.get_players().push_back(judge);
+        game.set_turn(0);
+
+        briber->set_coins(4);
+        briber->bribe();
+        Reaction reaction(game, GameAction::BRIBE, 0);
+        reaction.block();
+        CHECK(reaction.get_blockedBy() == 1);
+        CHECK(game.get_isBribe() == false);
+        CHECK(game.get_turn() == 1);
+        CHECK_THROWS_AS(reaction.block(), std::runtime_error);
+        delete briber;
+        delete judge;
+    }
+
+    SUBCASE("Unblockable Action Opens No Window") {
+        Player* actor = new Player(game, "Actor");
+        Governor* governor = new Governor(game, "Governor");
+        game.get_players().push_back(actor);
+        game.get_players().push_back(governor);
+        game.set_turn(0);
+
+        actor->gather();
+        Reaction reaction(game, GameAction::GATHER, 0);
+        CHECK_FALSE(reaction.is_open());
+        CHECK(reaction.current_blocker() == -1);
+        delete actor;
+        delete governor;
+    }
+}
+
+TEST_CASE("Batched Moves") {
+    Game& game = Game::instance();
+    game.get_players().clear();
+
+    SUBCASE("Batch Applies Until First Illegal Move") {
+        Player* p0 = new Player(game, "P0");
+        Governor* p1 = new Governor(game, "P1");
+        Player* p2 = new Player(game, "P2");
+        game.get_players().push_back(p0);
+        game.get_players().push_back(p1);
+        game.get_players().push_back(p2);
+        game.set_turn(0);
+
+        std::vector<Move> moves = {
+            {GameAction::GATHER, 0},
+            {GameAction::TAX, 1},
+            {GameAction::GATHER, 2},
+            {GameAction::COUP, 0, 1},   // only 1 coin
+            {GameAction::GATHER, 0},
+        };
+        BatchResult result = game.apply_batch(moves);
+        CHECK(result.applied == 3);
+        CHECK(result.failed_index == 3);
+        CHECK(result.status == MoveStatus::NOT_ENOUGH_COINS);
+        CHECK(p0->get_coins() == 1);
+        CHECK(p1->get_coins() == 3);
+        CHECK(p2->get_coins() == 1);
+        CHECK(game.get_turn() == 0);
+        delete p0;
+        delete p1;
+        delete p2;
+    }
+
+    SUBCASE("Validation Statuses") {
+        Player* p0 = new Player(game, "P0");
+        Judge* p1 = new Judge(game, "P1");
+        Merchant* p2 = new Merchant(game, "P2");
+        game.get_players().push_back(p0);
+        game.get_players().push_back(p1);
+        game.get_players().push_back(p2);
+        game.set_turn(0);
+
+        p0->set_coins(3);
+        p2->set_coins(1);
+        CHECK(game.validate({GameAction::GATHER, 1}) == MoveStatus::OUT_OF_TURN);
+        CHECK(game.validate({GameAction::GATHER, 7}) == MoveStatus::BAD_SEAT);
+        CHECK(game.validate({GameAction::SANCTION, 0, 1}) == MoveStatus::NOT_ENOUGH_COINS);
+        CHECK(game.validate({GameAction::SANCTION, 0, 2}) == MoveStatus::OK);
+        CHECK(game.validate({GameAction::SANCTION, 0, 0}) == MoveStatus::BAD_TARGET);
+        CHECK(game.validate({GameAction::ARREST, 0, 2}) == MoveStatus::TARGET_NO_COINS);
+        CHECK(game.validate({GameAction::UNIQE, 0}) == MoveStatus::NO_ABILITY);
+        p0->set_coins(10);
+        CHECK(game.validate({GameAction::GATHER, 0}) == MoveStatus::MUST_COUP);
+        p0->set_canArrest(false);
+        p0->set_coins(2);
+        CHECK(game.validate({GameAction::ARREST, 0, 1}) == MoveStatus::CANNOT_ARREST);
+        p0->set_isSanction(true);
+        CHECK(game.apply({GameAction::TAX, 0}) == MoveStatus::SANCTIONED);
+        CHECK(p0->get_coins() == 2);
+        delete p0;
+        delete p1;
+        delete p2;
+    }
+
+    SUBCASE("Arrest Through Engine Tracks Last Arrested") {
+        Player* p0 = new Player(game, "P0");
+        Player* p1 = new Player(game, "P1");
+        game.get_players().push_back(p0);
+        game.get_players().push_back(p1);
+        game.set_turn(0);
+
+        p0->set_coins(2);
+        p1->set_coins(2);
+        CHECK(game.apply({GameAction::ARREST, 0, 1}) == MoveStatus::OK);
+        CHECK(p1->get_lastArrested() == true);
+        CHECK(p1->get_coins() == 1);
+        CHECK(game.apply({GameAction::ARREST, 1, 0}) == MoveStatus::OK);
+        CHECK(p1->get_lastArrested() == false);
+        CHECK(p0->get_lastArrested() == true);
+        delete p0;
+        delete p1;
+    }
+
+    SUBCASE("No Moves After The Game Is Won") {
+        Player* p0 = new Player(game, "P0");
+        Player* p1 = new Player(game, "P1");
+        game.get_players().push_back(p0);
+        game.get_players().push_back(p1);
+        game.set_turn(0);
+
+        p0->set_coins(7);
+        CHECK(game.apply({GameAction::COUP, 0, 1}) == MoveStatus::OK);
+        CHECK(game.has_winner());
+        CHECK(game.validate({GameAction::GATHER, 0}) == MoveStatus::GAME_OVER);
+        delete p0;
+        delete p1;
+    }
+}
+
+TEST_CASE("Event Log And Replay") {
+    Game& game = Game::instance();
+    game.get_players().clear();
+
+    SUBCASE("Replay Rebuilds Moves And Block Decisions") {
+        Player* p0 = new Player(game, "P0");
+        Governor* p1 = new Governor(game, "P1");
+        General* p2 = new General(game, "P2");
+        game.get_players().push_back(p0);
+        game.get_players().push_back(p1);
+        game.get_players().push_back(p2);
+        game.set_turn(0);
+        p0->set_coins(7);
+        p2->set_coins(5);
+
+        EventLog log;
+        log.begin(game);
+        game.set_log(&log);
+
+        CHECK(game.apply({GameAction::TAX, 0}) == MoveStatus::OK);
+        Reaction taxReaction(game, GameAction::TAX, 0);
+        taxReaction.block();                              // Governor takes the tax back
+        CHECK(game.apply({GameAction::GATHER, 1}) == MoveStatus::OK);
+        CHECK(game.apply({GameAction::GATHER, 2}) == MoveStatus::OK);
+        CHECK(game.apply({GameAction::COUP, 0, 1}) == MoveStatus::OK);
+        Reaction coupReaction(game, GameAction::COUP, 0, 1);
+        coupReaction.allow();                             // General lets the coup stand
+        game.set_log(nullptr);
+
+        CHECK(log.get_events() == 6);
+        CHECK(log.get_bytes().size() == 8 + 1 + 3 * 5 + 1 + 6 * 3); // 3-byte records
+
+        int coins[3] = {p0->get_coins(), p1->get_coins(), p2->get_coins()};
+        int turn = game.get_turn();
+
+        CHECK(Replayer::replay(game, log) == 6);           // reseats (and deletes the old players)
+        PlayerList& players = game.get_players();
+        REQUIRE(players.size() == 3);
+        CHECK(players[0]->get_name() == "P0");
+        CHECK(players[1]->get_role() == Role::GOVERNOR);
+        CHECK(players.coins(0) == coins[0]);
+        CHECK(players.coins(1) == coins[1]);
+        CHECK(players.coins(2) == coins[2]);
+        CHECK(players.is_active(1) == false);
+        CHECK(game.get_turn() == turn);
+
+        CHECK(Replayer::replay(game, log, 2) == 2);       // prefix only
+        CHECK(game.get_players().coins(0) == 7);
+        game.clear_players();
+    }
+
+    SUBCASE("Corrupt Logs Are Rejected") {
+        std::vector<std::uint8_t> junk = {'N', 'O', 'P', 'E'};
+        CHECK_THROWS_AS(EventLog::from_bytes(junk.data(), junk.size()), std::runtime_error);
+
+        Player* p0 = new Player(game, "P0");
+        Player* p1 = new Player(game, "P1");
+        game.get_players().push_back(p0);
+        game.get_players().push_back(p1);
+        game.set_turn(0);
+        EventLog log;
+        log.begin(game);
+        log.record_move({GameAction::COUP, 0, 1});        // never legal with 0 coins
+        CHECK_THROWS_AS(Replayer::replay(game, log), std::runtime_error);
+
+        log.begin(game);
+        log.record_move({GameAction::GATHER, 0});
+        std::vector<std::uint8_t> bytes = log.get_bytes();
+        bytes[bytes.size() - 3] = (5 << 4) | static_cast<int>(GameAction::GATHER);   // no such kind
+        CHECK_THROWS_AS(EventLog::from_bytes(bytes.data(), bytes.size()), std::runtime_error);
+        CHECK_THROWS_AS(Replayer::replay(game, bytes.data(), bytes.size()), std::runtime_error);
+        game.clear_players();
+    }
+}
+
+TEST_CASE("Replay Archive") {
+    Game& game = Game::instance();
+    game.get_players().clear();
+    std::string path = "/tmp/coup_test_archive.bin";
+
+    SUBCASE("Games Are Found By Id And Replayed To Any Turn") {
+        EventLog logs[3];
+        int winners[3];
+        for(int g = 0; g < 3; ++g){
+            game.get_players().push_back(new Player(game, "A"));
+            game.get_players().push_back(new Judge(game, "B"));
+            game.set_turn(0);
+            logs[g].begin(game);
+            game.set_log(&logs[g]);
+            for(int i = 0; i <= g; ++i){
+                CHECK(game.apply({GameAction::GATHER, 0}) == MoveStatus::OK);
+                CHECK(game.apply({GameAction::GATHER, 1}) == MoveStatus::OK);
+            }
+            game.set_log(nullptr);
+            winners[g] = game.winner_seat();
+            game.clear_players();
+        }
+        CHECK(winners[0] == -1);
+        {
+            ArchiveWriter writer(path);
+            writer.add(30, logs[2], winners[2]);          // added out of order on purpose
+            writer.add(10, logs[0], winners[0]);
+            writer.add(20, logs[1], winners[1]);
+            writer.finish();
+        }
+
+        ArchiveReader archive(path);
+        REQUIRE(archive.games() == 3);
+        CHECK(archive.entry(0).game_id == 10);
+        CHECK(archive.find(15) == nullptr);
+        const ArchiveEntry* e = archive.find(30);
+        REQUIRE(e != nullptr);
+        CHECK(e->players == 2);
+        CHECK(e->winner == -1);
+        CHECK(e->role(1) == Role::JUDGE);
+        CHECK(archive.game_bytes(*e).size() == logs[2].get_bytes().size());
+
+        CHECK(archive.replay(game, 30) == 6);
+        CHECK(game.get_players().coins(0) == 3);
+        CHECK(archive.replay(game, 30, 3) == 3);           // state before the 4th move
+        CHECK(game.get_players().coins(0) == 2);
+        CHECK(game.get_players().coins(1) == 1);
+        CHECK(game.get_turn() == 1);
+        CHECK_THROWS_AS(archive.replay(game, 99), std::runtime_error);
+        game.clear_players();
+    }
+
+    SUBCASE("Files Without An Index Are Rejected") {
+        {
+            std::ofstream out(path, std::ios::binary | std::ios::trunc);
+            out << "not an archive, just some bytes";
+        }
+        CHECK_THROWS_AS(ArchiveReader reader(path), std::runtime_error);
+    }
+
+    SUBCASE("Index Is Aligned And Bounded By The File") {
+        game.get_players().push_back(new Player(game, "A"));
+        game.get_players().push_back(new Judge(game, "B"));
+        EventLog log;
+        log.begin(game);
+        game.clear_players();
+        REQUIRE(log.get_bytes().size() % alignof(ArchiveEntry) != 0);
+        {
+            ArchiveWriter writer(path);
+            writer.add(1, log, -1);
+        }
+        std::uint64_t count, index_offset;
+        {
+            ArchiveReader archive(path);
+            CHECK(archive.entry(0).length == log.get_bytes().size());
+            CHECK(reinterpret_cast<std::uintptr_t>(&archive.entry(0)) % alignof(ArchiveEntry) == 0);
+        }
+        std::fstream file(path, std::ios::binary | std::ios::in | std::ios::out);
+        file.seekg(-24, std::ios::end);
+        file.read(reinterpret_cast<char*>(&count), 8);
+        file.read(reinterpret_cast<char*>(&index_offset), 8);
+        CHECK(count == 1);
+        CHECK(index_offset % alignof(ArchiveEntry) == 0);
+        count = (~std::uint64_t(0)) / sizeof(ArchiveEntry) + 2;    // offset + count * 32 wraps around
+        index_offset += 32 - count * sizeof(ArchiveEntry);
+        file.seekp(-24, std::ios::end);
+        file.write(reinterpret_cast<const char*>(&count), 8);
+        file.write(reinterpret_cast<const char*>(&index_offset), 8);
+        file.close();
+        CHECK_THROWS_AS(ArchiveReader reader(path), std::runtime_error);
+    }
+    std::remove(path.c_str());
+}
+
+TEST_CASE("Replay Log Snapshots") {
+    Game& game = Game::instance();
+    game.get_players().clear();
+
+    SUBCASE("Seeking Through Snapshots Matches A Full Replay") {
+        game.get_players().push_back(new Player(game, "P0"));
+        game.get_players().push_back(new Governor(game, "P1"));
+        game.get_players().push_back(new Judge(game, "P2"));
+        game.set_turn(0);
+
+        EventLog plain, snapped;
+        plain.set_snapshot_interval(0);
+        snapped.set_snapshot_interval(4);
+        plain.begin(game);
+        snapped.begin(game);
+        for(int i = 0; i < 30; ++i){
+            int seat = game.get_turn();
+            Move m{GameAction::BRIBE, seat};
+            if(game.validate(m) != MoveStatus::OK){
+                m.action = GameAction::TAX;
+            }
+            plain.record_move(m);
+            snapped.record_move(m);
+            REQUIRE(game.apply(m) == MoveStatus::OK);
+            if(m.action == GameAction::TAX && seat != 1){
+                Reaction reaction(game, GameAction::TAX, seat);
+                reaction.block();                         // Governor takes every tax back
+                plain.record_block(GameAction::TAX, 1);
+                snapped.record_block(GameAction::TAX, 1);
+            }
+        }
+        CHECK(snapped.get_events() == plain.get_events());
+        CHECK(snapped.get_bytes().size() > plain.get_bytes().size());
+        const std::vector<SnapshotMark>& marks = snapped.get_snapshots();
+        CHECK(marks.size() == 7);                         // before moves 5, 9, ..., 29
+        CHECK(plain.get_snapshots().empty());
+        EventLog loaded = EventLog::from_bytes(snapped.get_bytes().data(), snapped.get_bytes().size());
+        bool same = loaded.get_snapshots().size() == marks.size();
+        for(std::size_t i = 0; same && i < marks.size(); ++i){
+            same = loaded.get_snapshots()[i].events == marks[i].events && loaded.get_snapshots()[i].offset == marks[i].offset;
+        }
+        CHECK(same);
+        LogSnapshot indexed, scanned;
+        EventReader by_index(snapped), by_scan(snapped.get_bytes().data(), snapped.get_bytes().size());
+        by_index.read_header();
+        by_scan.read_header();
+        REQUIRE(by_index.seek_snapshot(marks[3].events + 1, indexed));
+        REQUIRE(by_scan.seek_snapshot(marks[3].events + 1, scanned));
+        CHECK(indexed.events == marks[3].events);
+        CHECK(scanned.events == indexed.events);
+        CHECK(by_index.position() == by_scan.position());
+
+        for(std::size_t n = 0; n <= plain.get_events(); ++n){
+            CHECK(Replayer::replay(game, plain, n) == n);
+            int turn = game.get_turn();
+            bool bribe = game.get_isBribe();
+            int coins[3] = {game.get_players().coins(0), game.get_players().coins(1), game.get_players().coins(2)};
+            SeatMask sanctioned = game.get_players().sanction_mask();
+
+            CHECK(Replayer::replay(game, snapped, n) == n);
+            CHECK(game.get_turn() == turn);
+            CHECK(game.get_isBribe() == bribe);
+            CHECK(game.get_players().coins(0) == coins[0]);
+            CHECK(game.get_players().coins(1) == coins[1]);
+            CHECK(game.get_players().coins(2) == coins[2]);
+            CHECK(game.get_players().sanction_mask() == sanctioned);
+        }
+        game.clear_players();
+    }
+
+    SUBCASE("Truncated Snapshots Are Rejected") {
+        game.get_players().push_back(new Player(game, "P0"));
+        game.get_players().push_back(new Player(game, "P1"));
+        game.set_turn(0);
+        EventLog log;
+        log.set_snapshot_interval(1);
+        log.begin(game);
+        log.record_move({GameAction::GATHER, 0});
+        log.record_move({GameAction::GATHER, 1});       // preceded by a snapshot
+        std::vector<std::uint8_t> bytes = log.get_bytes();
+        bytes.resize(bytes.size() - 4);
+        CHECK_THROWS_AS(Replayer::replay(game, bytes.data(), bytes.size()), std::runtime_error);
+        game.clear_players();
+    }
+}
+
+TEST_CASE("Seeded Random Streams") {
+    SUBCASE("Same Seed Same Stream") {
+        Rng a(42), b(42), c(43);
+        bool differs = false;
+        for(int i = 0; i < 100; ++i){
+            std::uint64_t x = a();
+            CHECK(x == b());
+            differs |= x != c();
+        }
+        CHECK(differs);
+    }
+
+    SUBCASE("Split Streams Are Independent And Reproducible") {
+        Rng parent(7);
+        Rng first = parent.split();
+        Rng second = parent.split();
+        CHECK_FALSE(first == second);
+        CHECK_FALSE(second == parent);
+
+        Rng again(7);
+        CHECK(again.split() == first);
+        CHECK(again.split() == second);
+    }
+
+    SUBCASE("Bounded Draws Stay In Range And Cover It") {
+        Rng rng(1);
+        int seen[6] = {0, 0, 0, 0, 0, 0};
+        bool in_range = true;
+        for(int i = 0; i < 6000; ++i){
+            std::uint64_t v = rng.below(6);
+            in_range &= v < 6;
+            seen[v % 6]++;
+        }
+        CHECK(in_range);
+        for(int count : seen){
+            CHECK(count > 800);
+        }
+    }
+
+    SUBCASE("Dealt Tables Replay From Their Seed") {
+        Game& game = Game::instance();
+        game.get_players().clear();
+        Rng rng(2024);
+        deal_table(game, 6, rng);
+        PlayerList& players = game.get_players();
+        REQUIRE(players.size() == 6);
+        std::vector<Role> roles;
+        for(int i = 0; i < 6; ++i){
+            CHECK(players.role(i) != Role::CITIZEN);
+            CHECK(players.coins(i) == STARTING_COINS);
+            roles.push_back(players.role(i));
+        }
+        CHECK(players[5]->get_name() == "Player 6");
+        CHECK(game.get_turn() == 0);
+
+        Rng replay(2024);
+        CHECK(deal_roles(replay, 6) == roles);
+        CHECK_THROWS_AS(deal_table(game, PlayerList::CAPACITY + 1, replay), std::runtime_error);
+        CHECK(game.get_players().size() == 6);              // a refused deal keeps the table
+        game.clear_players();
+    }
+}
+
+TEST_CASE("Binary Game Snapshots") {
+    Game& game = Game::instance();
+    game.get_players().clear();
+    Rng rng(35);
+
+    // Deals a table and scrambles every field a snapshot carries
+    auto random_game = [&](){
+        int seats = 2 + static_cast<int>(rng.below(PlayerList::CAPACITY - 1));
+        deal_table(game, seats, rng);
+        for(Player* p : game.get_players()){
+            p->set_coins(static_cast<int>(rng.below(20)));
+            p->set_isActive(rng.below(2));
+            p->set_isSanction(rng.below(2));
+            p->set_canArrest(rng.below(2));
+            p->set_lastArrested(rng.below(2));
+            p->set_lastAction(static_cast<GameAction>(rng.below(static_cast<int>(GameAction::UNIQE) + 1)));
+        }
+        game.set_turn(static_cast<int>(rng.below(seats)));
+        game.set_isBribe(rng.below(2));
+    };
+
+    SUBCASE("Round Trip Fuzz") {
+        bool all_equal = true;
+        for(int i = 0; i < 500; ++i){
+            random_game();
+            std::vector<std::uint8_t> bytes = Snapshot::save(game);
+            all_equal &= bytes.size() == sizeof(SnapshotHeader) + game.get_players().size() * sizeof(SeatRecord);
+
+            Snapshot::load(game, bytes.data(), bytes.size());        // same table: in place
+            all_equal &= Snapshot::save(game) == bytes;
+            game.clear_players();
+            Snapshot::load(game, bytes.data(), bytes.size());        // empty table: reseated
+            all_equal &= Snapshot::save(game) == bytes;
+        }
+        CHECK(all_equal);
+        game.clear_players();
+    }
+
+    SUBCASE("Corrupted Blobs Fail Cleanly") {
+        int rejected = 0;
+        bool sane = true;
+        for(int i = 0; i < 500; ++i){
+            random_game();
+            std::vector<std::uint8_t> bytes = Snapshot::save(game);
+            bytes[rng.below(bytes.size())] ^= static_cast<std::uint8_t>(1 + rng.below(255));
+            try {
+                Snapshot::load(game, bytes.data(), bytes.size());
+                sane &= Snapshot::save(game).size() == bytes.size();  // accepted blobs are still well-formed
+            } catch (const std::runtime_error&) {
+                rejected++;
+            }
+        }
+        CHECK(sane);
+        CHECK(rejected > 0);
+
+        std::vector<std::uint8_t> bytes = Snapshot::save(game);
+        CHECK_THROWS_AS(Snapshot::load(game, bytes.data(), bytes.size() - 1), std::runtime_error);
+        std::uint8_t small[8];
+        CHECK_THROWS_AS(Snapshot::save(game, small, sizeof(small)), std::runtime_error);
+        game.get_players()[0]->set_name("A name much too long for one seat");
+        CHECK_THROWS_AS(Snapshot::save(game), std::runtime_error);
+        game.clear_players();
+    }
+}
+
+TEST_CASE("Delta History") {
+    Game& game = Game::instance();
+    game.get_players().clear();
+    Rng rng(36);
+    deal_table(game, 4, rng);
+
+    // Plays n legal moves, picking uniformly among gather/tax/bribe/arrest/coup
+    auto play = [&](History& history, std::vector<std::vector<std::uint8_t>>& states, int n){
+        for(int i = 0; i < n && !game.has_winner(); ++i){
+            int seat = game.get_turn();
+            int target = (seat + 1 + static_cast<int>(rng.below(3))) % 4;
+            Move options[] = {{GameAction::COUP, seat, target}, {GameAction::BRIBE, seat},
+                              {GameAction::ARREST, seat, target}, {GameAction::TAX, seat}, {GameAction::GATHER, seat}};
+            std::size_t start = rng.below(5);
+            for(std::size_t k = 0; k < 5; ++k){
+                if(game.apply(options[(start + k) % 5]) == MoveStatus::OK){
+                    break;
+                }
+            }
+            history.record(game);
+            states.push_back(Snapshot::save(game));
+        }
+    };
+
+    SUBCASE("Every Recorded State Rebuilds Exactly") {
+        History history;
+        std::vector<std::vector<std::uint8_t>> states{Snapshot::save(game)};
+        history.begin(game);
+        play(history, states, 400);
+        REQUIRE(history.size() == states.size());
+        CHECK(history.memory_bytes() < states.size() * states[0].size());
+
+        bool exact = true;
+        for(std::size_t i = 0; i < states.size(); ++i){
+            history.restore(game, i);
+            exact &= Snapshot::save(game) == states[i];
+        }
+        CHECK(exact);
+        CHECK_THROWS_AS(history.state_at(states.size()), std::runtime_error);
+    }
+
+    SUBCASE("Retention Compacts Old States Away") {
+        History history;
+        std::vector<std::vector<std::uint8_t>> states{Snapshot::save(game)};
+        history.set_retention(300);
+        history.begin(game);
+        for(int i = 0; i < 3000; ++i){                 // bribe/tax never ends the game
+            if(game.apply({GameAction::BRIBE, game.get_turn()}) != MoveStatus::OK){
+                game.apply({GameAction::TAX, game.get_turn()});
+            }
+            history.record(game);
+            states.push_back(Snapshot::save(game));
+        }
+        std::size_t recorded = states.size();
+        REQUIRE(history.size() == recorded);
+        CHECK(history.first() > 0);
+        CHECK(history.size() - history.first() <= 300 + History::COMPACT_INTERVAL);
+        CHECK_THROWS_AS(history.state_at(0), std::runtime_error);
+        bool exact = true;
+        for(std::size_t i = history.first(); i < recorded; ++i){
+            history.restore(game, i);
+            exact &= Snapshot::save(game) == states[i];
+        }
+        CHECK(exact);
+    }
+    game.clear_players();
+}
+
+TEST_CASE("Copy-On-Write Game States") {
+    Game& game = Game::instance();
+    game.get_players().clear();
+    Rng rng(37);
+    deal_table(game, 4, rng);
+    CowState root = CowState::capture(game);
+
+    SUBCASE("Moves Copy Only The Seats They Touch") {
+        MoveStatus status;
+        CowState gathered = root.after(game, {GameAction::GATHER, 0}, status);
+        REQUIRE(status == MoveStatus::OK);
+        CHECK(gathered.seat_state(0).coins == STARTING_COINS + 1);
+        CHECK(gathered.turn() == 1);
+        CHECK_FALSE(gathered.shares_seat(root, 0));
+        CHECK(gathered.shares_seat(root, 1));
+        CHECK(gathered.shares_seat(root, 2));
+        CHECK(gathered.shares_seat(root, 3));
+        CHECK(&gathered.table() == &root.table());
+
+        CowState taxed = root.after(game, {GameAction::TAX, 0}, status);   // sibling of gathered
+        REQUIRE(status == MoveStatus::OK);
+        CHECK(root.seat_state(0).coins == STARTING_COINS);                  // parent untouched
+        CHECK(taxed.shares_seat(gathered, 1));
+
+        CowState refused = gathered.after(game, {GameAction::COUP, 1, 0}, status);
+        CHECK(status == MoveStatus::NOT_ENOUGH_COINS);
+        for(int i = 0; i < 4; ++i){
+            CHECK(refused.shares_seat(gathered, i));
+        }
+
+        gathered.load(game);
+        CHECK(game.get_players().coins(0) == STARTING_COINS + 1);
+        CHECK(game.get_turn() == 1);
+    }
+
+    SUBCASE("Seating Rebuilds The Table From Any State") {
+        MoveStatus status;
+        CowState child = root.after(game, {GameAction::GATHER, 0}, status);
+        game.clear_players();
+        child.seat(game);
+        REQUIRE(game.get_players().size() == 4);
+        CHECK(game.get_players().role(2) == root.table().roles[2]);
+        CHECK(game.get_players()[3]->get_name() == "Player 4");
+        CHECK(CowState::capture(game).seat_state(0).coins == STARTING_COINS + 1);
+    }
+    game.clear_players();
+}
+
+TEST_CASE("Match Server Protocol") {
+    SUBCASE("Frames Survive Arbitrary Stream Splits") {
+        std::vector<std::uint8_t> bytes;
+        put_join(bytes, 4, "Alice");
+        put_act(bytes, GameAction::COUP, 2);
+        put_empty(bytes, MsgType::ALLOW);
+        FrameBuffer buffer;
+        std::vector<Frame> frames;
+        Frame f;
+        for(std::uint8_t b : bytes){                      // one byte at a time
+            buffer.append(&b, 1);
+            while(buffer.next(f)){
+                frames.push_back(f);
+            }
+        }
+        REQUIRE(frames.size() == 3);
+        CHECK(frames[0].type == MsgType::JOIN);
+        CHECK(frames[0].payload.size() == 2 + 5);
+        CHECK(frames[1].payload == std::vector<std::uint8_t>{static_cast<std::uint8_t>(GameAction::COUP), 2});
+        CHECK(frames[2].type == MsgType::ALLOW);
+        CHECK(buffer.buffered() == 0);
+
+        std::uint8_t huge[] = {0xff, 0xff, 0xff, 0x7f, 1};
+        buffer.append(huge, sizeof(huge));
+        CHECK_THROWS_AS(buffer.next(f), std::runtime_error);
+    }
+
+    SUBCASE("A Seat Left In The Lobby Is Free Again") {
+        Match match(1, 2);
+        CHECK(match.join(10, "A") == 0);
+        match.leave(0);
+        CHECK_FALSE(match.full());                        // no ghost seat to start with
+        CHECK(match.join(11, "B") == 0);
+        CHECK_FALSE(match.full());
+        CHECK(match.join(12, "C") == 1);
+        REQUIRE(match.full());
+        Rng rng(38);
+        match.start(rng);
+        CHECK(match.game().get_players().active_mask() == 0x3);
+        CHECK_FALSE(match.finished());
+        match.leave(1);                                   // after the start a leaver forfeits
+        CHECK(match.finished());
+        CHECK(match.game().winner_seat() == 0);
+    }
+
+    SUBCASE("Two Clients Play Over Localhost") {
+        Server server(0, 38);
+        std::thread loop([&server](){ server.run(); });
+        {
+            Client a("127.0.0.1", server.port());
+            Client b("127.0.0.1", server.port());
+            std::vector<std::uint8_t> out;
+            put_join(out, 2, "A");
+            a.send(out);
+            JoinedMsg ja = read_joined(a.receive());
+            out.clear();
+            put_join(out, 2, "B");
+            b.send(out);
+            JoinedMsg jb = read_joined(b.receive());
+            CHECK(ja.match == jb.match);
+            CHECK(ja.seat == 0);
+            CHECK(jb.seat == 1);
+
+            StateMsg start = read_state(a.receive());
+            CHECK(read_state(b.receive()).version == start.version);
+            REQUIRE(start.seats.size() == 2);
+            CHECK(start.turn == 0);
+            CHECK(start.seats[0].coins == STARTING_COINS);
+
+            out.clear();
+            put_act(out, GameAction::GATHER);
+            b.send(out);                                  // not b's turn
+            ErrorMsg err = read_error(b.receive());
+            CHECK(err.code == static_cast<std::uint8_t>(MoveStatus::OUT_OF_TURN));
+
+            a.send(out);
+            StateMsg after = read_state(a.receive());
+            CHECK(read_state(b.receive()).version == after.version);
+            CHECK(after.version > start.version);
+            CHECK(after.seats[0].coins == STARTING_COINS + 1);
+            CHECK(after.turn == 1);
+        }   // both clients hang up; the server forfeits their seats and drops the match
+
+        Client c("127.0.0.1", server.port());
+        std::vector<std::uint8_t> garbage = {0, 0, 0, 0};   // zero-length frame
+        c.send(garbage);
+        Frame f;
+        REQUIRE(c.receive(f, 2000));
+        CHECK(read_error(f).code == static_cast<std::uint8_t>(ServerError::BAD_MESSAGE));
+        CHECK_THROWS_AS(c.receive(f, 2000), std::runtime_error);
+
+        server.stop();
+        loop.join();
+        CHECK(server.matches() == 0);
+    }
+}
+
+TEST_CASE("Unattended Play Support") {
+    SUBCASE("Stuck Turns Are Detected And Passed") {
+        Game game;
+        Spy* spy = new Spy(game, "S");
+        Merchant* merchant = new Merchant(game, "M");
+        game.get_players().push_back(spy);
+        game.get_players().push_back(merchant);
+        game.set_turn(0);
+        spy->set_coins(1);
+        spy->set_isSanction(true);
+        merchant->set_coins(1);                           // arresting a Merchant takes 2
+        CHECK_FALSE(game.have_arrests_options(*spy));
+        CHECK_FALSE(game.has_legal_move(0));
+        CHECK(game.has_legal_move(1) == false);           // not seat 1's turn
+        spy->set_isSanction(false);
+        CHECK(game.has_legal_move(0));
+    }
+
+    SUBCASE("Matches Pass Turns Nobody Can Play") {
+        Match match(1, 2);
+        match.join(10, "A");
+        match.join(11, "B");
+        Rng rng(39);
+        match.start(rng);
+        Game& game = match.game();
+        game.get_players()[0]->set_coins(4);
+        game.get_players()[0]->set_isSanction(true);
+        game.get_players()[1]->set_coins(0);
+        CHECK(match.act(0, GameAction::BRIBE, -1) == 0);  // extra turn, but sanctioned with 0 coins
+        while(match.reaction().is_open()){
+            match.answer(match.reaction().current_blocker(), false);
+        }
+        CHECK(game.get_turn() == 1);
+    }
+
+    SUBCASE("Latency Histogram Percentiles") {
+        Histogram h;
+        for(std::uint64_t v = 1; v <= 10000; ++v){
+            h.record(v);
+        }
+        CHECK(h.count() == 10000);
+        CHECK(h.max() == 10000);
+        CHECK(h.percentile(0.5) >= 5000);
+        CHECK(h.percentile(0.5) <= 5000 * 1.02);
+        CHECK(h.percentile(0.99) >= 9900);
+        CHECK(h.percentile(0.99) <= 9900 * 1.02);
+        CHECK(h.percentile(1.0) == 10000);
+        Histogram other;
+        other.record(20000);
+        h.merge(other);
+        CHECK(h.max() == 20000);
+    }
+}
+
+TEST_CASE("Delta State Sync") {
+    SUBCASE("Deltas Carry Only Changed Fields") {
+        StateMsg a;
+        a.match = 7;
+        a.version = 3;
+        a.turn = 0;
+        a.seats = {{Role::SPY, 1, 2}, {Role::JUDGE, 1, 2}, {Role::BARON, 1, 2}};
+        StateMsg b = a;
+        b.version = 4;
+        b.turn = 1;
+        b.seats[0].coins = 5;
+        std::vector<std::uint8_t> full;
+        std::vector<std::uint8_t> delta;
+        put_state(full, b);
+        put_delta(delta, a, b);
+        CHECK(delta.size() < full.size());
+        CHECK(delta.size() == 4 + 1 + 12 + 1 + 1 + 1 + 4);   // one field, one seat
+
+        FrameBuffer buffer;
+        buffer.append(delta.data(), delta.size());
+        Frame f;
+        REQUIRE(buffer.next(f));
+        StateMsg copy = a;
+        REQUIRE(apply_delta(copy, f));
+        CHECK(copy.version == 4);
+        CHECK(copy.turn == 1);
+        CHECK(copy.seats[0].coins == 5);
+        CHECK(copy.seats[1].coins == 2);
+
+        StateMsg behind = a;
+        behind.version = 2;                               // missed the base version
+        CHECK_FALSE(apply_delta(behind, f));
+        CHECK(behind.turn == 0);
+    }
+
+    SUBCASE("Acking Clients Get Deltas, Others Full States") {
+        Server server(0, 40);
+        std::thread loop([&server](){ server.run(); });
+        {
+            Client a("127.0.0.1", server.port());
+            Client b("127.0.0.1", server.port());
+            std::vector<std::uint8_t> out;
+            put_join(out, 2, "A");
+            a.send(out);
+            read_joined(a.receive());
+            out.clear();
+            put_join(out, 2, "B");
+            b.send(out);
+            read_joined(b.receive());
+            StateMsg sa = read_state(a.receive());
+            StateMsg sb = read_state(b.receive());
+            out.clear();
+            put_ack(out, sa.version);
+            a.send(out);                                  // only a opts in
+
+            out.clear();
+            put_act(out, GameAction::GATHER);
+            a.send(out);
+            Frame fa = a.receive();
+            Frame fb = b.receive();
+            REQUIRE(fa.type == MsgType::DELTA);
+            REQUIRE(fb.type == MsgType::STATE);
+            CHECK(fa.payload.size() < fb.payload.size());
+            REQUIRE(apply_delta(sa, fa));
+            sb = read_state(fb);
+            CHECK(sa.version == sb.version);
+            CHECK(sa.turn == sb.turn);
+            CHECK(sa.seats[0].coins == STARTING_COINS + 1);
+            CHECK(sa.seats[0].coins == sb.seats[0].coins);
+        }
+        server.stop();
+        loop.join();
+    }
+}
+
+TEST_CASE("Spectator Fan-Out") {
+    Server server(0, 41);
+    std::thread loop([&server](){ server.run(); });
+    {
+        Client a("127.0.0.1", server.port());
+        Client b("127.0.0.1", server.port());
+        std::vector<std::uint8_t> out;
+        put_join(out, 2, "A");
+        a.send(out);
+        JoinedMsg joined = read_joined(a.receive());
+        out.clear();
+        put_join(out, 2, "B");
+        b.send(out);
+        read_joined(b.receive());
+        read_state(a.receive());
+        read_state(b.receive());
+
+        Client lost("127.0.0.1", server.port());
+        out.clear();
+        put_watch(out, joined.match + 100);
+        lost.send(out);
+        CHECK(read_error(lost.receive()).code == static_cast<std::uint8_t>(ServerError::NO_SUCH_MATCH));
+
+        std::vector<std::unique_ptr<Client>> watchers;
+        std::vector<StateMsg> seen(3);
+        for(int i = 0; i < 3; ++i){
+            watchers.push_back(std::make_unique<Client>("127.0.0.1", server.port()));
+            out.clear();
+            put_watch(out, joined.match);
+            watchers[i]->send(out);
+            JoinedMsg w = read_joined(watchers[i]->receive());
+            CHECK(w.seat == -1);
+            CHECK(w.players == 2);
+            seen[i] = read_state(watchers[i]->receive());     // caught up in full on arrival
+        }
+        out.clear();
+        put_watch(out, joined.match);
+        a.send(out);                                      // players cannot also watch
+        CHECK(read_error(a.receive()).code == static_cast<std::uint8_t>(ServerError::ALREADY_JOINED));
+
+        out.clear();
+        put_act(out, GameAction::GATHER);
+        a.send(out);
+        StateMsg played = read_state(a.receive());
+        bool all_deltas = true;
+        bool all_match = true;
+        for(int i = 0; i < 3; ++i){
+            Frame f = watchers[i]->receive();
+            all_deltas = all_deltas && f.type == MsgType::DELTA && apply_delta(seen[i], f);
+            all_match = all_match && seen[i].version == played.version && seen[i].turn == played.turn &&
+                        seen[i].seats[0].coins == played.seats[0].coins;
+        }
+        CHECK(all_deltas);
+        CHECK(all_match);
+        CHECK(server.coalesced() == 0);
+    }
+    server.stop();
+    loop.join();
+}
+
+TEST_CASE("Match Command Queue") {
+    SUBCASE("Producers Keep Their Own Order") {
+        MpscQueue<std::uint64_t> queue(1000);
+        CHECK(queue.capacity() == 1024);
+        const int producers = 4;
+        const std::uint64_t each = 20000;
+        std::vector<std::thread> threads;
+        for(int p = 0; p < producers; ++p){
+            threads.emplace_back([&queue, p](){
+                for(std::uint64_t i = 0; i < each; ++i){
+                    while(!queue.try_push((static_cast<std::uint64_t>(p) << 32) | i)){
+                        std::this_thread::yield();
+                    }
+                }
+            });
+        }
+        std::vector<std::uint64_t> next(producers, 0);
+        std::uint64_t received = 0;
+        bool ordered = true;
+        while(received < producers * each){
+            received += queue.drain([&](std::uint64_t v){
+                int p = static_cast<int>(v >> 32);
+                ordered = ordered && (v & 0xffffffffu) == next[p];
+                next[p]++;
+            }, 256);
+        }
+        for(std::thread& t : threads){
+            t.join();
+        }
+        CHECK(ordered);
+        CHECK(queue.empty());
+    }
+
+    SUBCASE("A Full Inbox Rejects And Drains In Order") {
+        Match match(1, 2);
+        match.join(10, "A");
+        match.join(11, "B");
+        Rng rng(42);
+        match.start(rng);
+        Command cmd;
+        cmd.seat = 1;                                     // out of turn
+        cmd.action = GameAction::GATHER;
+        std::size_t posted = 0;
+        while(match.post(cmd)){
+            posted++;
+        }
+        CHECK(posted == Match::INBOX_CAPACITY);
+        std::vector<std::uint8_t> codes;
+        match.drain([&](const Command&, std::uint8_t code){ codes.push_back(code); }, 1);
+        REQUIRE(codes.size() == 1);
+        CHECK(codes[0] == static_cast<std::uint8_t>(MoveStatus::OUT_OF_TURN));
+        CHECK(match.drain([](const Command&, std::uint8_t){}) == posted - 1);
+
+        cmd.seat = 0;
+        cmd.tag = 7;
+        std::uint32_t before = match.version();
+        CHECK(match.post(cmd));
+        match.drain([&](const Command& c, std::uint8_t code){
+            CHECK(c.tag == 7);
+            CHECK(code == 0);
+        });
+        CHECK(match.version() == before + 1);
+        CHECK(match.game().get_players().coins(0) == STARTING_COINS + 1);
+    }
+}
+
+TEST_CASE("Timer Wheel") {
+    SUBCASE("Timers Fire On Their Tick Across Levels") {
+        TimerWheel wheel(1000);
+        Rng rng(43);
+        std::vector<std::uint64_t> due;
+        std::vector<TimerWheel::TimerId> ids;
+        for(std::uint64_t i = 0; i < 5000; ++i){
+            std::uint64_t at = 1000 + 1 + rng.below(i % 2 ? 300 : 200000);   // levels 0 to 2
+            due.push_back(at);
+            ids.push_back(wheel.schedule(at, i));
+        }
+        bool cancelled = true;
+        for(std::size_t i = 0; i < ids.size(); i += 3){
+            cancelled = wheel.cancel(ids[i]) && cancelled;
+        }
+        CHECK(cancelled);
+        CHECK_FALSE(wheel.cancel(ids[0]));                // already cancelled
+        CHECK(wheel.size() == 5000 - 1667);
+
+        std::vector<std::uint64_t> expired;
+        bool on_time = true;
+        std::size_t fired = 0;
+        for(std::uint64_t t = 1000; t <= 202000; t += 1 + rng.below(700)){
+            wheel.advance(t, expired);
+            for(std::uint64_t i : expired){
+                on_time = on_time && i % 3 != 0 && due[i] <= t && due[i] + 700 > t;
+            }
+            fired += expired.size();
+            expired.clear();
+        }
+        wheel.advance(202001, expired);
+        fired += expired.size();
+        CHECK(on_time);
+        CHECK(fired == 5000 - 1667);
+        CHECK(wheel.size() == 0);
+        CHECK(wheel.next_due() == UINT64_MAX);
+
+        TimerWheel::TimerId late = wheel.schedule(wheel.now() + 5, 1);
+        CHECK(wheel.next_due() == 5);
+        expired.clear();
+        wheel.advance(wheel.now() + 4, expired);
+        CHECK(expired.empty());
+        wheel.advance(wheel.now() + 1, expired);
+        CHECK(expired == std::vector<std::uint64_t>{1});
+        CHECK_FALSE(wheel.cancel(late));                  // fired
+        expired.clear();
+        std::uint64_t far = wheel.now() + (std::uint64_t(1) << 40);   // beyond the wheel's range
+        wheel.schedule(far, 2);
+        wheel.advance(far - 1, expired);
+        CHECK(expired.empty());
+        wheel.advance(far, expired);
+        CHECK(expired == std::vector<std::uint64_t>{2});
+    }
+
+    SUBCASE("Idle Matches Are Played On Their Deadline") {
+        Server server(0, 43);
+        server.set_timeouts(30, 60);
+        std::thread loop([&server](){ server.run(); });
+        {
+            Client a("127.0.0.1", server.port());
+            Client b("127.0.0.1", server.port());
+            std::vector<std::uint8_t> out;
+            put_join(out, 2, "A");
+            a.send(out);
+            read_joined(a.receive());
+            out.clear();
+            put_join(out, 2, "B");
+            b.send(out);
+            read_joined(b.receive());
+            StateMsg start = read_state(a.receive());
+            CHECK(start.turn == 0);
+            Frame f;
+            REQUIRE(a.receive(f, 2000));                 // nobody moved: seat 0 gathers by itself
+            StateMsg idle = read_state(f);
+            CHECK(idle.version == start.version + 1);
+            CHECK(idle.turn == 1);
+            CHECK(idle.seats[0].coins == STARTING_COINS + 1);
+        }
+        server.stop();
+        loop.join();
+    }
+}
+
+TEST_CASE("Coroutine Turn Flow") {
+    SUBCASE("Turns Suspend On Moves And Answers") {
+        Game game;
+        Player* actor = new Player(game, "A");
+        Governor* governor = new Governor(game, "G");
+        Player* third = new Player(game, "C");
+        game.get_players().push_back(actor);
+        game.get_players().push_back(governor);
+        game.get_players().push_back(third);
+        game.set_turn(0);
+        {
+            TurnFlow flow = TurnFlow::play(game);
+            CHECK(flow.waiting() == TurnFlow::Waiting::MOVE);
+            CHECK(flow.seat() == 0);
+            CHECK(flow.submit({GameAction::GATHER, 1}) == MoveStatus::OUT_OF_TURN);
+            CHECK(flow.seat() == 0);                          // an illegal move is asked again
+            CHECK_THROWS(flow.answer(false));
+
+            CHECK(flow.submit({GameAction::TAX, 0}) == MoveStatus::OK);
+            CHECK(flow.waiting() == TurnFlow::Waiting::ANSWER);
+            CHECK(flow.seat() == 1);
+            CHECK(flow.reaction().is_open());
+            CHECK_THROWS(flow.submit({GameAction::GATHER, 1}));
+            flow.answer(true);
+            CHECK(actor->get_coins() == 0);
+            CHECK(flow.reaction().get_blockedBy() == 1);
+            CHECK_FALSE(flow.reaction().is_open());
+            CHECK(flow.waiting() == TurnFlow::Waiting::MOVE);
+            CHECK(flow.seat() == 1);
+
+            CHECK(flow.submit({GameAction::GATHER, 1}) == MoveStatus::OK);
+            CHECK(flow.seat() == 2);
+            CHECK(flow.submit({GameAction::TAX, 2}) == MoveStatus::OK);
+            flow.answer(false);
+            CHECK(third->get_coins() == 2);
+            CHECK(flow.seat() == 0);
+            CHECK(TurnFlow::frame_bytes() > 0);
+            CHECK(TurnFlow::frame_bytes() < 1024);
+        }
+    }
+
+    SUBCASE("The Flow Ends With The Game") {
+        Game game;
+        Player* actor = new Player(game, "A");
+        Player* target = new Player(game, "B");
+        game.get_players().push_back(actor);
+        game.get_players().push_back(target);
+        game.set_turn(0);
+        actor->set_coins(7);
+        {
+            TurnFlow flow = TurnFlow::play(game);
+            CHECK(flow.submit({GameAction::COUP, 0, 1}) == MoveStatus::OK);
+            CHECK(game.has_winner());
+            CHECK(flow.done());
+            CHECK(flow.waiting() == TurnFlow::Waiting::NOTHING);
+            CHECK(flow.seat() == -1);
+            CHECK_THROWS(flow.submit({GameAction::GATHER, 1}));
+        }
+        TurnFlow idle;
+        CHECK_FALSE(idle.done());
+        CHECK_FALSE(idle.reaction().is_open());
+    }
+}
+
+TEST_CASE("Match Checkpoints") {
+    SUBCASE("A Half-Answered Window Survives A Restore") {
+        Match match(7, 3);
+        match.join(10, "A");
+        match.join(11, "B");
+        match.join(12, "C");
+        Rng rng(40);                                      // seats 1 and 2 can both block a tax
+        match.start(rng);
+        CHECK(match.act(0, GameAction::TAX, -1) == 0);
+        CHECK(match.reaction().get_pending() == 6);
+        CHECK(match.answer(1, false) == 0);
+
+        std::vector<std::uint8_t> record;
+        match.checkpoint(record);
+        std::unique_ptr<Match> restored = Match::restore(record.data(), record.size());
+        CHECK(restored->id() == 7);
+        CHECK(restored->started());
+        CHECK(restored->version() == match.version());
+        CHECK(restored->reaction().is_open());
+        CHECK(restored->reaction().current_blocker() == 2);
+        CHECK(restored->reaction().get_pending() == 4);
+        std::vector<std::uint8_t> before, after;
+        put_state(before, make_state(7, match.version(), match.game(), match.reaction()));
+        put_state(after, make_state(7, restored->version(), restored->game(), restored->reaction()));
+        CHECK(before == after);
+
+        CHECK(restored->conns() == std::vector<int>(3, Match::RESERVED));
+        CHECK(restored->rejoin(2, 20, "B") == static_cast<std::uint8_t>(ServerError::NO_SUCH_SEAT));
+        CHECK(restored->rejoin(2, 20, "C") == 0);
+        CHECK(restored->rejoin(2, 21, "C") == static_cast<std::uint8_t>(ServerError::NO_SUCH_SEAT));
+        CHECK(restored->answer(2, true) == 0);            // finishes the window where it stopped
+        CHECK(match.answer(2, true) == 0);
+        before.clear();
+        after.clear();
+        put_state(before, make_state(7, match.version(), match.game(), match.reaction()));
+        put_state(after, make_state(7, restored->version(), restored->game(), restored->reaction()));
+        CHECK(before == after);
+
+        record[offsetof(MatchRecord, actor)] = 9;         // actor outside the table
+        CHECK_THROWS(Match::restore(record.data(), record.size()));
+        CHECK_THROWS(Match::restore(record.data(), 10));
+    }
+
+    SUBCASE("A Restored Match Journals A Log That Replays On Its Own") {
+        std::string path = "/tmp/coup_test_restored_wal.bin";
+        std::remove(path.c_str());
+        Match match(8, 3);
+        match.join(10, "A");
+        match.join(11, "B");
+        match.join(12, "C");
+        Rng rng(7);
+        match.start(rng);
+        int actor = match.game().get_turn();
+        int victim = (actor + 1) % 3;
+        match.game().get_players()[actor]->set_coins(7);
+        CHECK(match.act(actor, GameAction::COUP, victim) == 0);
+        while(match.reaction().is_open()){
+            CHECK(match.answer(match.reaction().current_blocker(), false) == 0);
+        }
+        REQUIRE_FALSE(match.game().get_players().is_active(victim));
+
+        std::vector<std::uint8_t> record;
+        match.checkpoint(record);
+        std::unique_ptr<Match> restored = Match::restore(record.data(), record.size());
+        {
+            Journal journal(path, 0, 0);
+            journal.log_changes(*restored);                   // BEGIN, before any move
+            for(int i = 0; i < 4; ++i){
+                CHECK(restored->act(restored->game().get_turn(), GameAction::GATHER, -1) == 0);
+            }
+            journal.log_changes(*restored);                   // EVENTS
+            journal.commit();
+        }
+        std::vector<WalMatch> matches = Wal::recover(Wal::scan(path));
+        REQUIRE(matches.size() == 1);
+        Game replayed;
+        CHECK(Replayer::replay(replayed, matches[0].log.data(), matches[0].log.size()) == 4);
+        CHECK_FALSE(replayed.get_players().is_active(victim));
+        std::vector<std::uint8_t> live, rebuilt;
+        put_state(live, make_state(8, 0, restored->game(), restored->reaction()));
+        put_state(rebuilt, make_state(8, 0, replayed, Reaction()));
+        CHECK(live == rebuilt);
+        std::remove(path.c_str());
+    }
+
+    SUBCASE("Servers Save And Restore Live Matches") {
+        std::string path = "/tmp/coup_test_checkpoint.bin";
+        std::remove(path.c_str());
+        JoinedMsg joined{};
+        StateMsg saved;
+        {
+            Server server(0, 41);
+            std::thread loop([&server](){ server.run(); });
+            Client a("127.0.0.1", server.port());
+            Client b("127.0.0.1", server.port());
+            std::vector<std::uint8_t> out;
+            put_join(out, 2, "A");
+            a.send(out);
+            joined = read_joined(a.receive());
+            out.clear();
+            put_join(out, 2, "B");
+            b.send(out);
+            read_joined(b.receive());
+            saved = read_state(a.receive());
+            read_state(b.receive());
+            server.stop();                                // before the clients hang up and forfeit
+            loop.join();
+            CHECK(server.checkpoint(path) == 1);
+        }
+
+        Server server(0, 42);
+        CHECK(server.restore("/tmp/coup_test_no_such_checkpoint.bin") == 0);
+        CHECK(server.restore(path, 2) == 1);
+        CHECK(server.matches() == 1);
+        CHECK_THROWS(server.restore(path));               // ids already hosted
+        std::thread loop([&server](){ server.run(); });
+        {
+            Client stranger("127.0.0.1", server.port());
+            std::vector<std::uint8_t> out;
+            put_resume(out, joined.match, joined.seat, "B");
+            stranger.send(out);
+            CHECK(read_error(stranger.receive()).code == static_cast<std::uint8_t>(ServerError::NO_SUCH_SEAT));
+
+            Client a("127.0.0.1", server.port());
+            out.clear();
+            put_resume(out, joined.match, joined.seat, "A");
+            a.send(out);
+            JoinedMsg back = read_joined(a.receive());
+            CHECK(back.match == joined.match);
+            CHECK(back.seat == joined.seat);
+            StateMsg state = read_state(a.receive());
+            CHECK(state.version == saved.version);
+            CHECK(state.turn == saved.turn);
+            CHECK(state.seats.size() == saved.seats.size());
+        }
+        server.stop();
+        loop.join();
+
+        std::FILE* f = std::fopen(path.c_str(), "r+b");
+        std::fseek(f, 20, SEEK_SET);
+        std::fputc(0x5a, f);
+        std::fclose(f);
+        Server other(0, 43);
+        CHECK_THROWS(other.restore(path));                // checksum catches the flipped byte
+        std::remove(path.c_str());
+    }
+}
+
+TEST_CASE("Write-Ahead Log") {
+    std::string path = "/tmp/coup_test_wal.bin";
+    std::remove(path.c_str());
+
+    SUBCASE("One Commit Covers Many Records And Torn Tails Are Cut") {
+        const std::uint8_t events[] = {1, 2, 3};
+        const std::uint8_t winner[] = {1, 'B'};
+        {
+            Wal wal(path, 48);
+            wal.append(WalKind::BEGIN, 4, 1, events, 2);
+            wal.append(WalKind::EVENTS, 4, 2, events + 2, 1);
+            CHECK_FALSE(wal.full());
+            wal.append(WalKind::FINISH, 4, 3, winner, 2);
+            CHECK(wal.full());
+            CHECK(wal.durable() == 0);
+            CHECK(Wal::scan(path).records.empty());           // nothing reaches the file before commit
+            CHECK(wal.commit());
+            CHECK_FALSE(wal.commit());
+            CHECK(wal.durable() == 3);
+            CHECK(wal.commits() == 1);
+            wal.append(WalKind::BEGIN, 4, 1, events, 3);      // id reused after a restart
+        }
+        WalScan scan = Wal::scan(path);
+        CHECK(scan.records.size() == 4);
+        CHECK(scan.valid_bytes == scan.file_bytes);
+        CHECK(scan.records[2].kind == WalKind::FINISH);
+        CHECK(scan.records[2].version == 3);
+        std::vector<WalMatch> matches = Wal::recover(scan);
+        CHECK(matches.size() == 2);
+        CHECK(matches[0].finished);
+        CHECK(matches[0].winner == 1);
+        CHECK(matches[0].winner_name == "B");
+        CHECK(matches[0].log == std::vector<std::uint8_t>{1, 2, 3});
+        CHECK_FALSE(matches[1].finished);
+
+        std::FILE* f = std::fopen(path.c_str(), "ab");
+        const char torn[] = {40, 0, 0, 0, 9, 9};                  // a record cut short by a crash
+        std::fwrite(torn, 1, sizeof(torn), f);
+        std::fclose(f);
+        CHECK(Wal::scan(path).valid_bytes == scan.valid_bytes);
+        {
+            Wal reopened(path);
+            reopened.append(WalKind::FORFEIT, 9, 1, winner, 1);
+        }
+        scan = Wal::scan(path);
+        CHECK(scan.records.size() == 5);                          // appended after the cut, not after the junk
+        CHECK(scan.valid_bytes == scan.file_bytes);
+        CHECK(Wal::recover(scan).back().forfeits == std::vector<int>{1});
+    }
+
+    SUBCASE("Results Are Durable Before Players Hear Them") {
+        Server server(0, 46);
+        server.set_wal(path, 0);
+        std::thread loop([&server](){ server.run(); });
+        Client a("127.0.0.1", server.port());
+        JoinedMsg joined{};
+        {
+            Client b("127.0.0.1", server.port());
+            std::vector<std::uint8_t> out;
+            put_join(out, 2, "A");
+            a.send(out);
+            joined = read_joined(a.receive());
+            out.clear();
+            put_join(out, 2, "B");
+            b.send(out);
+            read_joined(b.receive());
+            read_state(a.receive());
+            read_state(b.receive());
+        }                                                     // B hangs up and forfeits
+        StateMsg last = read_state(a.receive());
+        CHECK(last.winner == joined.seat);
+        std::vector<WalMatch> matches = Wal::recover(Wal::scan(path));
+        CHECK(matches.size() == 1);
+        CHECK(matches[0].match == joined.match);
+        CHECK(matches[0].finished);
+        CHECK(matches[0].winner == joined.seat);
+        CHECK(matches[0].winner_name == "A");
+        CHECK(matches[0].forfeits == std::vector<int>{1 - joined.seat});
+        EventReader reader(matches[0].log.data(), matches[0].log.size());
+        CHECK(reader.read_header().names.size() == 2);
+        server.stop();
+        loop.join();
+        CHECK(server.wal()->commits() >= 1);
+    }
+    std::remove(path.c_str());
+}
+
+TEST_CASE("Sharded Match Hosting") {
+    SUBCASE("The Directory Maps Ids To Shards") {
+        ShardDirectory directory(2, 8);
+        CHECK(directory.capacity() == 8);
+        CHECK_FALSE(directory.up(0));
+        std::uint32_t a = directory.allocate(0);
+        std::uint32_t b = directory.allocate(1);
+        std::uint32_t c = directory.allocate(1);
+        CHECK(a == 1);
+        CHECK(b == 2);
+        CHECK(c == 4);                                    // shard s hands out s + 1, s + 1 + shards, ...
+        CHECK(directory.lookup(a) == 0);
+        CHECK(directory.lookup(c) == 1);
+        CHECK(directory.lookup(3) == -1);
+        CHECK(directory.info(1).matches.load() == 2);
+        directory.release(b);
+        CHECK(directory.lookup(b) == -1);
+        CHECK(directory.info(1).matches.load() == 1);
+
+        CHECK(directory.claim(7, 0));                     // restored with its old id
+        CHECK(directory.claim(7, 0));
+        CHECK_FALSE(directory.claim(6, 0));               // shard 1's id
+        CHECK_FALSE(directory.claim(15, 0));              // slot 7 holds match 7
+        CHECK(directory.allocate(0) == 11);               // past it, and 9 would share match 1's slot
+        CHECK(directory.drop(1) == 1);
+        CHECK(directory.lookup(c) == -1);
+        CHECK(directory.lookup(7) == 0);
+        CHECK(directory.info(1).matches.load() == 0);
+
+        ShardDirectory tiny(1, 2);
+        tiny.allocate(0);
+        tiny.allocate(0);
+        CHECK_THROWS(tiny.allocate(0));
+        CHECK_THROWS(ShardDirectory(0));
+    }
+
+    SUBCASE("Connections Move To The Shard Hosting Their Match") {
+        ShardDirectory directory(2);
+        std::vector<int> inboxes(2), outboxes(2);
+        for(int shard = 0; shard < 2; ++shard){
+            int fds[2];
+            Handoff::channel(fds);
+            outboxes[shard] = fds[0];
+            inboxes[shard] = fds[1];
+        }
+        Server first(0, 47);
+        Server second(0, 48);
+        first.set_shard(directory, 0, inboxes[0], outboxes);
+        second.set_shard(directory, 1, inboxes[1], outboxes);
+        directory.info(0).pid.store(1);
+        directory.info(1).pid.store(1);
+        std::thread loop1([&first](){ first.run(); });
+        std::thread loop2([&second](){ second.run(); });
+        {
+            Client a("127.0.0.1", second.port());
+            Client b("127.0.0.1", second.port());
+            std::vector<std::uint8_t> out;
+            put_join(out, 2, "A");
+            a.send(out);
+            JoinedMsg joined = read_joined(a.receive());
+            CHECK(directory.lookup(joined.match) == 1);
+            out.clear();
+            put_join(out, 2, "B");
+            b.send(out);
+            read_joined(b.receive());
+            StateMsg started = read_state(a.receive());
+
+            Client watcher("127.0.0.1", first.port());
+            out.clear();
+            put_watch(out, joined.match);
+            watcher.send(out);
+            JoinedMsg watching = read_joined(watcher.receive());
+            CHECK(watching.match == joined.match);
+            CHECK(read_state(watcher.receive()).version == started.version);
+
+            Client stranger("127.0.0.1", first.port());
+            out.clear();
+            put_watch(out, joined.match + 100);
+            stranger.send(out);
+            CHECK(read_error(stranger.receive()).code == static_cast<std::uint8_t>(ServerError::NO_SUCH_MATCH));
+            directory.info(1).pid.store(0);               // shard 1's worker is down
+            out.clear();
+            put_watch(out, joined.match);
+            stranger.send(out);
+            CHECK(read_error(stranger.receive()).code == static_cast<std::uint8_t>(ServerError::NO_SUCH_MATCH));
+        }
+        first.stop();
+        second.stop();
+        loop1.join();
+        loop2.join();
+        CHECK(first.handed_off() == 1);                   // the watcher only; the strangers stayed
+        CHECK(second.taken_over() == 1);
+        for(int shard = 0; shard < 2; ++shard){
+            ::close(inboxes[shard]);
+            ::close(outboxes[shard]);
+        }
+    }
+}
+
+TEST_CASE("Matchmaking") {
+    SUBCASE("Tables Form Inside Rating Buckets And Widen With Waiting") {
+        Matchmaker mm(100, 2000);
+        std::vector<std::vector<std::string>> tables;
+        auto record = [&tables](const std::vector<Ticket>& group){
+            tables.emplace_back();
+            for(const Ticket& t : group){
+                tables.back().push_back(t.name);
+            }
+        };
+        auto ticket = [](std::uint64_t tag, const std::string& name, int rating, int seats, std::uint64_t since){
+            Ticket t;
+            t.tag = tag;
+            t.name = name;
+            t.rating = rating;
+            t.seats = seats;
+            t.since = since;
+            return t;
+        };
+        mm.enqueue(ticket(1, "a", 1510, 2, 0));
+        mm.enqueue(ticket(2, "far", 1750, 2, 0));
+        mm.enqueue(ticket(3, "b", 1590, 2, 0));
+        mm.enqueue(ticket(4, "c", 1520, 2, 0));
+        mm.enqueue(ticket(5, "d", 1505, 2, 0));
+        mm.enqueue(ticket(6, "near", 1610, 2, 0));
+        mm.enqueue(ticket(7, "trio", 1500, 3, 0));
+        CHECK_THROWS(mm.enqueue(ticket(8, "x", 1500, 1, 0)));
+        CHECK(mm.waiting() == 7);
+        CHECK(mm.tick(10, record) == 2);
+        CHECK(tables[0] == std::vector<std::string>{"a", "b"});    // same bucket, oldest first
+        CHECK(tables[1] == std::vector<std::string>{"c", "d"});
+        CHECK(mm.waiting(2) == 2);                                 // 1610 and 1750: 140 apart
+        CHECK(mm.waiting(3) == 1);
+        CHECK(mm.tick(1999, record) == 0);
+        CHECK(mm.tick(2000, record) == 1);                         // both now tolerate 200
+        CHECK(tables[2] == std::vector<std::string>{"near", "far"});
+        CHECK(mm.formed() == 3);
+        CHECK(mm.mean_wait() == doctest::Approx((4 * 10 + 2 * 2000) / 6.0));
+
+        mm.enqueue(ticket(9, "e", 1500, 2, 3000));
+        mm.enqueue(ticket(10, "f", 1500, 2, 3000));
+        mm.cancel(9);
+        CHECK(mm.tick(3001, record) == 0);
+        CHECK(mm.waiting() == 2);                                  // f and the trio
+
+        mm.enqueue(ticket(11, "g", 1500, 2, 4000));
+        mm.cancel(11);
+        mm.enqueue(ticket(11, "g again", 1500, 2, 4000));         // queued again before the tick
+        CHECK(mm.tick(4000, record) == 1);
+        CHECK(tables.back() == std::vector<std::string>{"f", "g again"});
+        CHECK(mm.waiting() == 1);
+        CHECK_THROWS(Matchmaker(0));
+    }
+
+    SUBCASE("Servers Seat Matched Players Together") {
+        Server server(0, 48);
+        server.set_matchmaking(2);
+        std::thread loop([&server](){ server.run(); });
+        {
+            Client a("127.0.0.1", server.port());
+            Client b("127.0.0.1", server.port());
+            std::vector<std::uint8_t> out;
+            put_join(out, 2, "A", 1200);
+            a.send(out);
+            out.clear();
+            put_join(out, 2, "B", 1250);
+            b.send(out);
+            JoinedMsg ja = read_joined(a.receive());
+            JoinedMsg jb = read_joined(b.receive());
+            CHECK(ja.match == jb.match);
+            CHECK(ja.seat != jb.seat);
+            CHECK(read_state(a.receive()).version == read_state(b.receive()).version);
+            out.clear();
+            put_join(out, 2, "A", 1200);
+            a.send(out);
+            CHECK(read_error(a.receive()).code == static_cast<std::uint8_t>(ServerError::ALREADY_JOINED));
+        }
+        server.stop();
+        loop.join();
+        CHECK(server.matchmaker()->formed() == 1);
+    }
+
+    SUBCASE("Matches Open On The Least-Loaded Shard") {
+        ShardDirectory directory(2);
+        std::vector<int> inboxes(2), outboxes(2);
+        for(int shard = 0; shard < 2; ++shard){
+            int fds[2];
+            Handoff::channel(fds);
+            outboxes[shard] = fds[0];
+            inboxes[shard] = fds[1];
+        }
+        Server first(0, 49);
+        Server second(0, 50);
+        first.set_shard(directory, 0, inboxes[0], outboxes);
+        second.set_shard(directory, 1, inboxes[1], outboxes);
+        first.set_matchmaking(2);
+        second.set_matchmaking(2);
+        directory.info(0).pid.store(1);
+        directory.info(1).pid.store(1);
+        directory.allocate(0);                            // shard 0 is busier
+        CHECK(directory.least_loaded(0) == 1);
+        std::thread loop1([&first](){ first.run(); });
+        std::thread loop2([&second](){ second.run(); });
+        {
+            Client a("127.0.0.1", second.port());
+            Client b("127.0.0.1", second.port());
+            std::vector<std::uint8_t> out;
+            put_join(out, 2, "A");
+            a.send(out);
+            out.clear();
+            put_join(out, 2, "B");
+            b.send(out);
+            JoinedMsg ja = read_joined(a.receive());
+            JoinedMsg jb = read_joined(b.receive());
+            CHECK(ja.match == jb.match);
+            CHECK(directory.lookup(ja.match) == 1);
+            read_state(a.receive());
+            read_state(b.receive());
+        }
+        first.stop();
+        second.stop();
+        loop1.join();
+        loop2.join();
+        CHECK(second.handed_off() == 2);                  // JOINs to the matchmaking shard
+        CHECK(first.taken_over() == 2);
+        CHECK(first.handed_off() == 2);                   // and the table back to the idle one
+        CHECK(second.taken_over() == 2);
+        CHECK(first.matchmaker()->formed() == 1);
+        CHECK(second.matchmaker()->formed() == 0);
+        for(int shard = 0; shard < 2; ++shard){
+            ::close(inboxes[shard]);
+            ::close(outboxes[shard]);
+        }
+    }
+}
+
+TEST_CASE("Rating Pipeline") {
+    SUBCASE("Strategies Only Pick Legal Moves") {
+        Game game;
+        std::vector<Role> roles{Role::GOVERNOR, Role::SPY, Role::BARON};
+        seat_roles(game, roles);
+        std::vector<Move> moves;
+        CHECK(legal_moves(game, 0, moves) > 0);
+        for(const Move& m : moves){
+            CHECK(game.validate(m) == MoveStatus::OK);
+            CHECK(m.action != GameAction::UNIQE);
+        }
+        game.get_players()[0]->set_coins(7);
+        Rng rng(1);
+        GreedyStrategy greedy;
+        Move coup = greedy.choose(game, 0, rng);
+        CHECK(coup.action == GameAction::COUP);
+        CHECK(coup.target == 1);
+        RandomStrategy random;
+        for(int i = 0; i < 50; ++i){
+            CHECK(game.validate(random.choose(game, 0, rng)) == MoveStatus::OK);
+        }
+        CHECK_THROWS_AS(make_strategy("oracle"), std::runtime_error);
+        CHECK(std::string(make_strategy("greedy")->name()) == "greedy");
+    }
+
+    SUBCASE("Simulated Games Do Not Depend On The Thread Count") {
+        Simulator one({"random", "greedy"}, 7);
+        Simulator three({"random", "greedy"}, 7);
+        std::vector<GameResult> a, b;
+        one.run(300, 4, 1, a);
+        three.run(100, 4, 3, b);
+        three.run(200, 4, 3, b);            // a run cut in two plays the same games
+        REQUIRE(a.size() == 300);
+        REQUIRE(b.size() == 300);
+        std::size_t finished = 0, same = 0;
+        for(std::size_t i = 0; i < a.size(); ++i){
+            bool equal = a[i].winner == b[i].winner && a[i].turns == b[i].turns;
+            for(int s = 0; s < 4; ++s){
+                equal = equal && a[i].roles[s] == b[i].roles[s] && a[i].strategies[s] == b[i].strategies[s];
+            }
+            same += equal ? 1 : 0;
+            finished += a[i].winner >= 0 ? 1 : 0;
+        }
+        CHECK(same == a.size());
+        CHECK(finished > 250);
+        CHECK(one.played() == 300);
+        CHECK_THROWS_AS(one.run(1, PlayerList::CAPACITY + 1, 1, a), std::runtime_error);
+        CHECK_THROWS_AS(Simulator({"random", "oracle"}, 1), std::runtime_error);
+    }
+
+    SUBCASE("One Game Moves The Winner Up And The Loser Down Alike") {
+        RatingEngine engine(2, 1);
+        GameResult r;
+        r.players = 2;
+        r.winner = 1;
+        r.roles[0] = Role::JUDGE;
+        r.roles[1] = Role::GENERAL;
+        r.strategies[0] = 0;
+        r.strategies[1] = 1;
+        engine.add(r);                      // batch of one: rated at once
+        CHECK(engine.rated() == 1);
+        CHECK(engine.strategies().mu(1) > RatingEngine::INITIAL_MU);
+        CHECK(engine.strategies().mu(0) + engine.strategies().mu(1) == doctest::Approx(2 * RatingEngine::INITIAL_MU));
+        CHECK(engine.roles().mu(static_cast<int>(Role::GENERAL)) == doctest::Approx(engine.strategies().mu(1)));
+        CHECK(engine.strategies().sigma(0) < RatingEngine::INITIAL_SIGMA);
+        CHECK(engine.strategies().games(0) == 1);
+        CHECK(engine.roles().games(static_cast<int>(Role::SPY)) == 0);
+
+        r.winner = -1;
+        engine.add(r);                      // unfinished: not rated
+        CHECK(engine.rated() == 1);
+        r.strategies[0] = 2;
+        CHECK_THROWS_AS(engine.add(r), std::runtime_error);
+        r.strategies[0] = 0;
+        r.winner = 2;
+        CHECK_THROWS_AS(engine.add(r), std::runtime_error);
+    }
+
+    SUBCASE("Greedy Outrates Random And Threads Agree") {
+        Simulator simulator({"random", "greedy"}, 11);
+        std::vector<GameResult> results;
+        simulator.run(4000, 4, 2, results);
+        RatingEngine serial(2, 500, 1);
+        RatingEngine parallel(2, 500, 4);
+        for(const GameResult& r : results){
+            serial.add(r);
+            parallel.add(r);
+        }
+        serial.flush();
+        parallel.flush();
+        CHECK(serial.rated() == parallel.rated());
+        CHECK(serial.strategies().mu(1) - serial.strategies().mu(0) > 4 * serial.strategies().sigma(0));
+        for(std::size_t k = 0; k < 2; ++k){
+            CHECK(parallel.strategies().mu(k) == doctest::Approx(serial.strategies().mu(k)).epsilon(1e-12));
+        }
+        for(int role = 0; role < ROLE_COUNT; ++role){
+            CHECK(parallel.roles().mu(role) == doctest::Approx(serial.roles().mu(role)).epsilon(1e-12));
+        }
+        const std::vector<ConvergencePoint>& points = serial.convergence();
+        REQUIRE(points.size() >= 8);
+        CHECK(points.back().games == serial.rated());
+        CHECK(points.back().max_sigma < points.front().max_sigma);
+        CHECK(points.back().max_change < points.front().max_change);
+    }
+
+    SUBCASE("Archived Games Rate Their Roles") {
+        std::string path = "/tmp/coup_test_rating_archive.bin";
+        {
+            Game game;
+            std::vector<Role> roles{Role::MERCHANT, Role::BARON, Role::SPY};
+            ArchiveWriter writer(path);
+            for(int g = 0; g < 6; ++g){
+                seat_roles(game, roles);
+                EventLog log;
+                log.begin(game);
+                writer.add(static_cast<std::uint64_t>(g + 1), log, g == 5 ? -1 : 0);   // the Merchant wins every finished game
+            }
+            writer.finish();
+        }
+        ArchiveReader archive(path);
+        RatingEngine engine(0);
+        CHECK(engine.add(archive) == 5);
+        engine.flush();
+        CHECK(engine.rated() == 5);
+        CHECK(engine.roles().mu(static_cast<int>(Role::MERCHANT)) > RatingEngine::INITIAL_MU);
+        CHECK(engine.roles().mu(static_cast<int>(Role::BARON)) < RatingEngine::INITIAL_MU);
+        CHECK(engine.roles().mu(static_cast<int>(Role::JUDGE)) == RatingEngine::INITIAL_MU);
+        std::remove(path.c_str());
+    }
+}
+
+TEST_CASE("Tournament Runner") {
+    SUBCASE("Search And Table Bots Play Legal Moves") {
+        Game game;
+        std::vector<Role> roles{Role::GENERAL, Role::JUDGE};
+        seat_roles(game, roles);
+        game.get_players()[0]->set_coins(7);
+        Rng rng(3);
+        MctsStrategy mcts(64);
+        CHECK(mcts.choose(game, 0, rng).action == GameAction::COUP);     // wins on the spot
+        CHECK(game.get_players()[0]->get_coins() == 7);                    // searched on a scratch table
+        CHECK(game.get_turn() == 0);
+        CHECK_THROWS_AS(make_strategy("mcts:0"), std::runtime_error);
+
+        CHECK(CfrTable::infoset(game, 0) >= 0);
+        CHECK(CfrTable::infoset(game, 0) < CfrTable::INFOSETS);
+        unsigned legal = CfrTable::legal(game, 0);
+        CHECK(legal == 0x3f);
+        CfrTable table;
+        table.train(50, rng);
+        CHECK(table.trained() == 50);
+        double policy[CfrTable::ACTIONS];
+        table.average(CfrTable::infoset(game, 0), 1u << 5, policy);       // only coup allowed
+        CHECK(policy[5] == 1.0);
+
+        std::string path = "/tmp/coup_test_cfr.bin";
+        table.save(path);
+        CfrTable loaded = CfrTable::load(path);
+        double again[CfrTable::ACTIONS];
+        bool same = true;
+        for(int key = 0; key < CfrTable::INFOSETS; ++key){
+            table.average(key, 0x3f, policy);
+            loaded.average(key, 0x3f, again);
+            for(int a = 0; a < CfrTable::ACTIONS; ++a){
+                same = same && policy[a] == again[a];
+            }
+        }
+        CHECK(same);
+        CHECK(loaded.trained() == 50);
+        std::unique_ptr<Strategy> cfr = make_strategy("cfr:" + path);
+        Move m = cfr->choose(game, 0, rng);
+        CHECK(game.validate(m) == MoveStatus::OK);
+        std::remove(path.c_str());
+        CHECK_THROWS_AS(CfrTable::load(path), std::runtime_error);
+    }
+
+    SUBCASE("Blocking Beats Not Blocking") {
+        Game game;
+        std::vector<Role> roles{Role::GOVERNOR, Role::GOVERNOR};
+        GreedyStrategy greedy;
+        PassiveStrategy passive;
+        Strategy* seats[] = {&greedy, &passive};
+        Rng rng(9);
+        GameResult r = play_game(game, seats, roles, rng);
+        CHECK(r.winner == 0);                  // seat 1's taxes are all taken back
+
+        TournamentResult result = Tournament({"greedy", "passive"}, 2, 1, 5).run(1);
+        CHECK(result.against(0, 1).rate() > 0.5);          // same moves: only blocks differ
+    }
+
+    SUBCASE("Every Seating And Deal Is Played Once Per Round") {
+        Tournament tournament({"random", "greedy"}, 2, 1, 5);
+        REQUIRE(tournament.games() == 2 * 36);
+        TournamentResult one = tournament.run(1);
+        TournamentResult three = tournament.run(3);
+        CHECK(one.games == 72);
+        CHECK(one.against(0, 1).games == 72);
+        CHECK(one.against(0, 1).score + one.against(1, 0).score == 72);
+        CHECK(one.against(1, 0).rate() > 0.8);
+        CHECK(one.against(1, 0).low() < one.against(1, 0).rate());
+        CHECK(one.against(1, 0).high() > one.against(1, 0).rate());
+        CHECK(one.against(0, 0).games == 0);
+        for(std::size_t i = 0; i < one.versus.size(); ++i){
+            CHECK(one.versus[i].score == three.versus[i].score);
+        }
+        std::uint64_t role_seats = 0;
+        for(int r = 0; r < ROLE_COUNT; ++r){
+            role_seats += one.roles[r].games + one.roles[ROLE_COUNT + r].games;
+            CHECK(one.roles[r].games == one.roles[ROLE_COUNT + r].games);        // both sides hold every role alike
+        }
+        CHECK(role_seats == 72 * 2);
+        CHECK(one.roles[static_cast<int>(Role::CITIZEN)].games == 0);
+        CHECK(one.seats[0].games == 36);
+
+        TournamentResult mirror = Tournament({"random", "random"}, 3, 1, 5).run(2);
+        CHECK(mirror.games == 6 * 216);
+        CHECK(mirror.against(0, 1).rate() == doctest::Approx(0.5).epsilon(0.05));
+
+        CHECK_THROWS_AS(Tournament({"greedy"}, 2), std::runtime_error);
+        CHECK_THROWS_AS(Tournament({"greedy", "random"}, 1), std::runtime_error);
+        CHECK_THROWS_AS(Tournament({"greedy", "oracle"}, 2), std::runtime_error);
+    }
+}
+
 TEST_CASE("Special Abilities Integration Tests") {
     Game& game = Game::instance();
     game.get_players().clear();
@@ -1142,3 +3196,4 @@ TEST_CASE("Special Abilities Integration Tests") {
     }
 }
 
+
@@ -0,0 +1,86 @@
+#ifndef HISTOGRAM_HPP
+#define HISTOGRAM_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @brief Fixed-memory latency histogram with about 1.6% relative error.
+ * Values are bucketed by their power of two and 64 linear sub-buckets within it (exact below 128),
+ * so recording is a couple of bit operations and percentiles never need sorting.
+ */
+class Histogram{
+    private:
+        static constexpr int SUB_BITS = 7;
+        static constexpr int SUB = 1 << SUB_BITS;
+        std::vector<std::uint64_t> _counts;
+        std::uint64_t _total;
+        std::uint64_t _max;
+
+        static std::size_t index(std::uint64_t v){
+            if(v < SUB){
+                return static_cast<std::size_t>(v);
+            }
+            int exp = 63 - __builtin_clzll(v) - SUB_BITS + 1;   // v >> exp lies in [SUB/2, SUB)
+            return static_cast<std::size_t>(exp * (SUB / 2) + (v >> exp));
+        }
+        static std::uint64_t value(std::size_t i){
+            if(i < SUB){
+                return i;
+            }
+            std::size_t exp = (i - SUB / 2) / (SUB / 2);
+            std::uint64_t mantissa = i - exp * (SUB / 2);
+            return ((mantissa + 1) << exp) - 1;               // upper edge of the bucket
+        }
+
+    public:
+        Histogram() : _counts(index(~std::uint64_t(0)) + 1, 0), _total(0), _max(0) {}
+
+        void record(std::uint64_t v){
+            _counts[index(v)]++;
+            _total++;
+            if(v > _max){
+                _max = v;
+            }
+        }
+        void merge(const Histogram& other){
+            for(std::size_t i = 0; i < _counts.size(); ++i){
+                _counts[i] += other._counts[i];
+            }
+            _total += other._total;
+            if(other._max > _max){
+                _max = other._max;
+            }
+        }
+        void clear(){
+            std::fill(_counts.begin(), _counts.end(), 0);
+            _total = 0;
+            _max = 0;
+        }
+        std::uint64_t count() const { return _total; }
+        std::uint64_t max() const { return _max; }
+        /**
+         * @brief Smallest recorded bucket covering fraction q (0..1) of the values.
+         */
+        std::uint64_t percentile(double q) const{
+            if(_total == 0){
+                return 0;
+            }
+            std::uint64_t rank = static_cast<std::uint64_t>(q * static_cast<double>(_total));
+            if(rank >= _total){
+                rank = _total - 1;
+            }
+            std::uint64_t seen = 0;
+            for(std::size_t i = 0; i < _counts.size(); ++i){
+                seen += _counts[i];
+                if(seen > rank){
+                    std::uint64_t v = value(i);
+                    return v < _max ? v : _max;
+                }
+            }
+            return _max;
+        }
+};
+#endif
@@ -0,0 +1,507 @@
+#include "Histogram.hpp"
+#include "../Server/Protocol.hpp"
+#include "../Engine/Rng.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct Options{
+    std::string host = "127.0.0.1";
+    std::uint16_t port = 7777;
+    int conns = 100;
+    int table = 2;
+    double seconds = 10;
+    bool scripted = false;
+    int ramp_step = 0;             // 0: fixed load; otherwise connections added per step
+    double step_seconds = 2;
+    int max_conns = 20000;
+    double slo_p99_ms = 5;
+    std::uint64_t seed = 1;
+    bool full_state = false;       // never ACK, so the server always sends full STATE frames
+    int spectators = 0;            // extra connections watching the bots' matches
+    int rating_spread = -1;        // bots JOIN with a rating 1500 +- this (-1: none)
+};
+
+void usage(){
+    std::cout << "coup_loadgen [--host A] [--port P] [--conns N] [--table T] [--seconds S]\n"
+                 "             [--policy random|scripted] [--seed X] [--full-state 0|1] [--spectators N]\n"
+                 "             [--rating-spread R]\n"
+                 "             [--ramp STEP --step-seconds S --slo-p99-ms MS --max-conns N]\n"
+                 "Opens N bot connections that play legal moves on coup_server and reports\n"
+                 "round-trip latency (send to first reply) every second. With --ramp, adds STEP\n"
+                 "connections every step until p99 exceeds the SLO. Raise `ulimit -n` for large N." << std::endl;
+}
+
+Options parse(int argc, char* argv[]){
+    Options o;
+    for(int i = 1; i < argc; ++i){
+        std::string arg = argv[i];
+        if(arg == "--help" || i + 1 >= argc){
+            usage();
+            std::exit(arg == "--help" ? 0 : 1);
+        }
+        std::string v = argv[++i];
+        if(arg == "--host") o.host = v;
+        else if(arg == "--port") o.port = static_cast<std::uint16_t>(std::stoi(v));
+        else if(arg == "--conns") o.conns = std::stoi(v);
+        else if(arg == "--table") o.table = std::stoi(v);
+        else if(arg == "--seconds") o.seconds = std::stod(v);
+        else if(arg == "--policy") o.scripted = v == "scripted";
+        else if(arg == "--seed") o.seed = std::stoull(v);
+        else if(arg == "--ramp") o.ramp_step = std::stoi(v);
+        else if(arg == "--step-seconds") o.step_seconds = std::stod(v);
+        else if(arg == "--slo-p99-ms") o.slo_p99_ms = std::stod(v);
+        else if(arg == "--max-conns") o.max_conns = std::stoi(v);
+        else if(arg == "--full-state") o.full_state = v != "0";
+        else if(arg == "--spectators") o.spectators = std::stoi(v);
+        else if(arg == "--rating-spread") o.rating_spread = std::stoi(v);
+        else{
+            usage();
+            std::exit(1);
+        }
+    }
+    return o;
+}
+
+struct Bot{
+    int fd = -1;
+    bool connected = false;
+    bool dead = false;             // dropped; erased after the current event batch
+    FrameBuffer in;
+    std::vector<std::uint8_t> out;
+    std::size_t sent = 0;
+    bool writing = false;
+    int seat = -1;
+    bool waiting = false;          // a request is in flight
+    Clock::time_point sent_at;
+    std::vector<std::pair<GameAction, int>> options;   // moves still to try this turn
+    StateMsg state;                // table as of the last STATE/DELTA applied
+    std::uint32_t acked = 0;
+    std::uint32_t match = 0;
+    bool spectator = false;
+    bool watching = false;
+    Rng rng;
+};
+
+struct Interval{
+    Histogram latency;
+    std::uint64_t actions = 0;
+    std::uint64_t rejected = 0;
+    std::uint64_t errors = 0;
+    std::uint64_t games = 0;
+    std::uint64_t state_bytes = 0;
+    std::uint64_t spectated = 0;   // state frames received by spectators
+};
+
+/**
+ * @brief Drives many bot connections from one epoll loop.
+ */
+class LoadGen{
+    private:
+        Options _opt;
+        int _epoll;
+        std::unordered_map<int, std::unique_ptr<Bot>> _bots;
+        std::vector<int> _players;     // fds of the playing bots, for spectators to pick from
+        Rng _rng;
+        Interval _now;
+
+        void watch(Bot& b, bool write){
+            epoll_event ev{};
+            ev.events = EPOLLIN | (write ? EPOLLOUT : 0u);
+            ev.data.fd = b.fd;
+            ::epoll_ctl(_epoll, EPOLL_CTL_MOD, b.fd, &ev);
+            b.writing = write;
+        }
+        void flush(Bot& b){
+            while(b.connected && b.sent < b.out.size()){
+                ssize_t n = ::send(b.fd, b.out.data() + b.sent, b.out.size() - b.sent, MSG_NOSIGNAL);
+                if(n < 0){
+                    if(errno == EAGAIN || errno == EWOULDBLOCK){
+                        break;
+                    }
+                    drop(b);
+                    return;
+                }
+                b.sent += static_cast<std::size_t>(n);
+            }
+            if(b.sent == b.out.size()){
+                b.out.clear();
+                b.sent = 0;
+            }
+            if(b.connected && b.out.empty() == b.writing){
+                watch(b, !b.out.empty());
+            }
+        }
+        void request(Bot& b){
+            b.waiting = true;
+            b.sent_at = Clock::now();
+            flush(b);
+        }
+        void join(Bot& b){
+            b.seat = -1;
+            int rating = _opt.rating_spread < 0 ? -1 : 1500 - _opt.rating_spread + static_cast<int>(b.rng.below(2 * _opt.rating_spread + 1));
+            put_join(b.out, _opt.table, "bot" + std::to_string(b.fd), rating);
+            flush(b);
+        }
+        /**
+         * @brief Spectates the match of a random playing bot; retried every second until one
+         * is seated (matches live on whichever server loop accepted their players).
+         */
+        void watch(Bot& b){
+            for(int tries = 0; tries < 8 && !_players.empty(); ++tries){
+                auto it = _bots.find(_players[b.rng.below(_players.size())]);
+                if(it != _bots.end() && !it->second->dead && !it->second->spectator && it->second->match != 0){
+                    put_watch(b.out, it->second->match);
+                    b.watching = true;
+                    flush(b);
+                    return;
+                }
+            }
+        }
+        void on_spectated(Bot& b, const Frame& f){
+            switch(f.type){
+                case MsgType::STATE:
+                    b.state = read_state(f);
+                    break;
+                case MsgType::DELTA:
+                    if(!apply_delta(b.state, f)){
+                        return;
+                    }
+                    break;
+                case MsgType::ERROR:
+                    b.watching = false;                  // the match ended meanwhile
+                    return;
+                default:
+                    return;
+            }
+            _now.spectated++;
+            _now.state_bytes += 5 + f.payload.size();
+            if(b.state.winner >= 0){
+                b.watching = false;
+                watch(b);
+            }
+        }
+        void drop(Bot& b){
+            if(b.dead){
+                return;
+            }
+            _now.errors++;
+            ::epoll_ctl(_epoll, EPOLL_CTL_DEL, b.fd, nullptr);
+            ::close(b.fd);
+            b.connected = false;
+            b.dead = true;
+        }
+        /**
+         * @brief Lists the moves that look legal from the pushed state (the server still
+         * has the final say): random order, or a fixed priority when scripted.
+         */
+        void plan_turn(Bot& b, const StateMsg& s){
+            b.options.clear();
+            const SeatView& me = s.seats[b.seat];
+            int coins = me.coins;
+            if(coins < 10){
+                if(!(me.flags & 2)){
+                    b.options.push_back({GameAction::TAX, -1});
+                    b.options.push_back({GameAction::GATHER, -1});
+                }
+                if(coins >= 4){
+                    b.options.push_back({GameAction::BRIBE, -1});
+                }
+            }
+            for(int t = 0; t < static_cast<int>(s.seats.size()); ++t){
+                const SeatView& other = s.seats[t];
+                if(t == b.seat || !(other.flags & 1)){
+                    continue;
+                }
+                if(coins >= 7){
+                    b.options.insert(b.options.begin(), {GameAction::COUP, t});
+                }
+                if(coins >= 10){
+                    continue;
+                }
+                if((me.flags & 4) && !(other.flags & 8) && other.coins >= (other.role == Role::MERCHANT ? 2 : 1)){
+                    b.options.push_back({GameAction::ARREST, t});
+                }
+                if(coins >= (other.role == Role::JUDGE ? 4 : 3)){
+                    b.options.push_back({GameAction::SANCTION, t});
+                }
+            }
+            if(!_opt.scripted){
+                std::shuffle(b.options.begin(), b.options.end(), b.rng);
+            }
+            std::reverse(b.options.begin(), b.options.end());     // try from the back
+        }
+        void try_next(Bot& b){
+            if(b.options.empty()){
+                return;
+            }
+            auto [action, target] = b.options.back();
+            b.options.pop_back();
+            put_act(b.out, action, target);
+            request(b);
+        }
+        void on_state(Bot& b, const Frame& f){
+            const StateMsg& s = b.state;
+            _now.state_bytes += 5 + f.payload.size();
+            bool mine = s.turn == b.seat && s.blocker < 0 && (s.seats[b.seat].flags & 1);
+            bool replying = s.winner < 0 && (s.blocker == b.seat || mine);
+            // Ack ahead of our own requests, or before falling out of the server's window
+            if(!_opt.full_state && s.winner < 0 && (replying || s.version - b.acked >= SYNC_WINDOW / 2)){
+                put_ack(b.out, s.version);
+                b.acked = s.version;
+            }
+            if(s.winner >= 0){
+                _now.games += s.winner == b.seat;
+                join(b);
+            }
+            else if(s.blocker == b.seat){
+                put_empty(b.out, (!_opt.scripted && b.rng.below(4) == 0) ? MsgType::BLOCK : MsgType::ALLOW);
+                request(b);
+            }
+            else if(mine){
+                plan_turn(b, s);
+                try_next(b);
+            }
+            flush(b);
+        }
+        void on_frame(Bot& b, const Frame& f){
+            if(b.spectator){
+                on_spectated(b, f);
+                return;
+            }
+            if(b.waiting){
+                b.waiting = false;
+                _now.latency.record(static_cast<std::uint64_t>(
+                    std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - b.sent_at).count()));
+                _now.actions++;
+            }
+            switch(f.type){
+                case MsgType::JOINED: {
+                    JoinedMsg j = read_joined(f);
+                    b.seat = j.seat;
+                    b.match = j.match;
+                    b.acked = 0;
+                    break;
+                }
+                case MsgType::ERROR:
+                    _now.rejected++;
+                    try_next(b);
+                    break;
+                case MsgType::STATE:
+                    b.state = read_state(f);
+                    on_state(b, f);
+                    break;
+                case MsgType::DELTA:
+                    if(apply_delta(b.state, f)){
+                        on_state(b, f);
+                    }
+                    break;
+                default:
+                    break;
+            }
+        }
+        void on_event(Bot& b, std::uint32_t events){
+            if(!b.connected){
+                int err = 0;
+                socklen_t len = sizeof(err);
+                ::getsockopt(b.fd, SOL_SOCKET, SO_ERROR, &err, &len);
+                if(err != 0 || (events & (EPOLLERR | EPOLLHUP))){
+                    drop(b);
+                    return;
+                }
+                b.connected = true;
+                if(b.spectator){
+                    watch(b);
+                }
+                else{
+                    join(b);
+                }
+                return;
+            }
+            if(events & (EPOLLERR | EPOLLHUP)){
+                drop(b);
+                return;
+            }
+            if(events & EPOLLOUT){
+                flush(b);
+            }
+            if(!(events & EPOLLIN)){
+                return;
+            }
+            std::uint8_t buf[16384];
+            while(true){
+                ssize_t got = ::recv(b.fd, buf, sizeof(buf), 0);
+                if(got == 0 || (got < 0 && errno != EAGAIN && errno != EWOULDBLOCK)){
+                    drop(b);
+                    return;
+                }
+                if(got < 0){
+                    break;
+                }
+                b.in.append(buf, static_cast<std::size_t>(got));
+            }
+            Frame f;
+            while(!b.dead && b.in.next(f)){
+                on_frame(b, f);
+            }
+        }
+
+    public:
+        explicit LoadGen(const Options& opt) : _opt(opt), _epoll(::epoll_create1(EPOLL_CLOEXEC)), _rng(opt.seed) {}
+        ~LoadGen(){
+            for(auto& entry : _bots){
+                if(!entry.second->dead){
+                    ::close(entry.first);
+                }
+            }
+            ::close(_epoll);
+        }
+        std::size_t connections() const { return _bots.size(); }
+
+        void add(int n, bool spectators = false){
+            sockaddr_in addr{};
+            addr.sin_family = AF_INET;
+            addr.sin_port = htons(_opt.port);
+            if(::inet_pton(AF_INET, _opt.host.c_str(), &addr.sin_addr) != 1){
+                throw std::runtime_error("Bad server address: " + _opt.host);
+            }
+            for(int i = 0; i < n; ++i){
+                int fd = ::socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+                if(fd < 0){
+                    _now.errors++;
+                    continue;
+                }
+                int one = 1;
+                ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+                if(::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 && errno != EINPROGRESS){
+                    ::close(fd);
+                    _now.errors++;
+                    continue;
+                }
+                auto bot = std::make_unique<Bot>();
+                bot->fd = fd;
+                bot->rng = _rng.split();
+                bot->spectator = spectators;
+                if(!spectators){
+                    _players.push_back(fd);
+                }
+                epoll_event ev{};
+                ev.events = EPOLLIN | EPOLLOUT;
+                ev.data.fd = fd;
+                ::epoll_ctl(_epoll, EPOLL_CTL_ADD, fd, &ev);
+                bot->writing = true;
+                _bots.emplace(fd, std::move(bot));
+            }
+        }
+        /**
+         * @brief Runs the loop for a while, printing one line per second.
+         * @return Stats of the whole period.
+         */
+        Interval run(double seconds, double& elapsed){
+            Interval period;
+            Clock::time_point end = Clock::now() + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(seconds));
+            Clock::time_point tick = Clock::now() + std::chrono::seconds(1);
+            epoll_event events[512];
+            while(Clock::now() < end){
+                int wait = static_cast<int>(std::chrono::duration_cast<std::chrono::milliseconds>(std::min(tick, end) - Clock::now()).count());
+                int n = ::epoll_wait(_epoll, events, 512, std::max(wait, 0));
+                for(int i = 0; i < n; ++i){
+                    auto it = _bots.find(events[i].data.fd);
+                    if(it != _bots.end() && !it->second->dead){
+                        on_event(*it->second, events[i].events);
+                    }
+                }
+                std::erase_if(_bots, [](const auto& entry){ return entry.second->dead; });
+                Clock::time_point now = Clock::now();
+                if(now >= tick || now >= end){
+                    elapsed += 1;
+                    print(std::to_string(static_cast<int>(elapsed)) + "s", _now, 1.0);
+                    period.latency.merge(_now.latency);
+                    period.actions += _now.actions;
+                    period.rejected += _now.rejected;
+                    period.errors += _now.errors;
+                    period.games += _now.games;
+                    period.state_bytes += _now.state_bytes;
+                    period.spectated += _now.spectated;
+                    _now = Interval();
+                    tick = now + std::chrono::seconds(1);
+                    std::erase_if(_players, [this](int fd){ return _bots.count(fd) == 0; });
+                    for(auto& entry : _bots){
+                        Bot& b = *entry.second;
+                        if(b.spectator && b.connected && !b.watching){
+                            watch(b);
+                        }
+                    }
+                }
+            }
+            return period;
+        }
+        void print(const std::string& label, const Interval& s, double seconds) const{
+            std::cout << std::left << std::setw(8) << label << std::right
+                      << " conns " << std::setw(6) << _bots.size()
+                      << "  req/s " << std::setw(9) << static_cast<std::uint64_t>(s.actions / seconds)
+                      << "  p50 " << std::setw(6) << s.latency.percentile(0.50)
+                      << "  p99 " << std::setw(6) << s.latency.percentile(0.99)
+                      << "  p999 " << std::setw(6) << s.latency.percentile(0.999) << " us"
+                      << "  rejected " << s.rejected << "  errors " << s.errors
+                      << "  games " << s.games
+                      << "  state B/s " << static_cast<std::uint64_t>(s.state_bytes / seconds)
+                      << "  spectated/s " << static_cast<std::uint64_t>(s.spectated / seconds) << std::endl;
+        }
+};
+
+}
+
+int main(int argc, char* argv[]){
+    Options opt = parse(argc, argv);
+    try {
+        LoadGen gen(opt);
+        gen.add(opt.conns);
+        gen.add(opt.spectators, true);
+        double elapsed = 0;
+        if(opt.ramp_step <= 0){
+            Interval all = gen.run(opt.seconds, elapsed);
+            gen.print("total", all, opt.seconds);
+            return 0;
+        }
+        int passing = 0;
+        while(true){
+            Interval step = gen.run(opt.step_seconds, elapsed);
+            double p99_ms = step.latency.percentile(0.99) / 1000.0;
+            int conns = static_cast<int>(gen.connections());
+            std::cout << "-- " << conns << " connections: p99 " << p99_ms << " ms" << std::endl;
+            if(p99_ms > opt.slo_p99_ms || step.errors > 0){
+                std::cout << "SLO broken at " << conns << " connections; last passing: " << passing << std::endl;
+                return 0;
+            }
+            passing = conns;
+            if(conns + opt.ramp_step > opt.max_conns){
+                std::cout << "Reached --max-conns with the SLO intact at " << conns << " connections" << std::endl;
+                return 0;
+            }
+            gen.add(opt.ramp_step);
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "coup_loadgen: " << e.what() << std::endl;
+        return 1;
+    }
+}
@@ -0,0 +1,166 @@
+#include "../Engine/Rating.hpp"
+#include "../Engine/Simulator.hpp"
+#include "../Engine/Archive.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+struct Options{
+    std::vector<std::string> strategies{"random", "greedy"};
+    std::size_t games = 100000;
+    int players = 4;
+    unsigned threads = std::thread::hardware_concurrency();
+    std::size_t batch = RatingEngine::DEFAULT_BATCH;
+    std::size_t every = 0;          // games between report rows, 0: a tenth of the run
+    std::uint64_t seed = 1;
+    std::string archive;
+};
+
+void usage(){
+    std::cout << "coup_rate [--strategies random,greedy] [--games N] [--players P] [--threads T]\n"
+                 "          [--batch B] [--every N] [--seed X] [--archive PATH]\n"
+                 "Rates strategies and roles from N simulated games at P-seat tables (each seat\n"
+                 "a random pick of the strategies, roles dealt at random), or the roles from the\n"
+                 "finished games of a replay archive. Prints how far the ratings still move every\n"
+                 "N games, then each rating with its standard error." << std::endl;
+}
+
+std::vector<std::string> split(const std::string& list){
+    std::vector<std::string> names;
+    std::stringstream in(list);
+    std::string name;
+    while(std::getline(in, name, ',')){
+        if(!name.empty()){
+            names.push_back(name);
+        }
+    }
+    return names;
+}
+
+Options parse(int argc, char* argv[]){
+    Options o;
+    for(int i = 1; i < argc; ++i){
+        std::string arg = argv[i];
+        if(arg == "--help" || i + 1 >= argc){
+            usage();
+            std::exit(arg == "--help" ? 0 : 1);
+        }
+        std::string v = argv[++i];
+        if(arg == "--strategies") o.strategies = split(v);
+        else if(arg == "--games") o.games = std::stoull(v);
+        else if(arg == "--players") o.players = std::stoi(v);
+        else if(arg == "--threads") o.threads = static_cast<unsigned>(std::stoul(v));
+        else if(arg == "--batch") o.batch = std::stoull(v);
+        else if(arg == "--every") o.every = std::stoull(v);
+        else if(arg == "--seed") o.seed = std::stoull(v);
+        else if(arg == "--archive") o.archive = v;
+        else{
+            usage();
+            std::exit(1);
+        }
+    }
+    return o;
+}
+
+std::vector<double> ratings(const RatingEngine& engine){
+    std::vector<double> mu;
+    for(const RatingTable* table : {&engine.strategies(), &engine.roles()}){
+        for(std::size_t k = 0; k < table->size(); ++k){
+            mu.push_back(table->mu(k));
+        }
+    }
+    return mu;
+}
+
+/**
+ * @brief One convergence row: games so far, the largest rating move since the last row,
+ * the largest standard error, and the rating throughput of the row.
+ */
+void print_row(const RatingEngine& engine, std::vector<double>& last, double seconds, std::size_t games){
+    std::vector<double> now = ratings(engine);
+    double moved = 0;
+    for(std::size_t k = 0; k < now.size(); ++k){
+        moved = std::max(moved, std::abs(now[k] - last[k]));
+    }
+    last = now;
+    double sigma = engine.convergence().empty() ? RatingEngine::INITIAL_SIGMA : engine.convergence().back().max_sigma;
+    char line[128];
+    std::snprintf(line, sizeof(line), "%12llu %12.2f %10.2f %14.0f",
+                  static_cast<unsigned long long>(engine.rated()), moved, sigma, seconds > 0 ? games / seconds : 0.0);
+    std::cout << line << std::endl;
+}
+
+void print_table(const char* title, const RatingTable& table, const std::vector<std::string>& names){
+    std::cout << title << std::endl;
+    for(std::size_t k = 0; k < table.size(); ++k){
+        if(table.games(k) == 0){
+            continue;
+        }
+        char line[128];
+        std::snprintf(line, sizeof(line), "  %-10s %8.1f +- %5.1f  (%llu seats)", names[k].c_str(), table.mu(k),
+                      2 * table.sigma(k), static_cast<unsigned long long>(table.games(k)));
+        std::cout << line << std::endl;
+    }
+}
+}
+
+/**
+ * coup_rate: streams simulated or archived games through the rating engine and reports
+ * how the ratings converge.
+ */
+int main(int argc, char* argv[]){
+    using Clock = std::chrono::steady_clock;
+    Options o = parse(argc, argv);
+    try {
+        std::vector<std::string> roles;
+        for(int r = 0; r < ROLE_COUNT; ++r){
+            roles.push_back(role_name(static_cast<Role>(r)));
+        }
+        RatingEngine engine(o.archive.empty() ? o.strategies.size() : 0, o.batch, o.threads);
+        std::vector<double> last = ratings(engine);
+        std::cout << "       games   max change  max sigma   games/second" << std::endl;
+        if(!o.archive.empty()){
+            ArchiveReader archive(o.archive);
+            std::size_t every = o.every > 0 ? o.every : std::max<std::size_t>(archive.games() / 10, 1);
+            Clock::time_point start = Clock::now();
+            for(std::size_t i = 0; i < archive.games(); ++i){
+                engine.add(archive.entry(i));
+                if((i + 1) % every == 0 || i + 1 == archive.games()){
+                    engine.flush();
+                    print_row(engine, last, std::chrono::duration<double>(Clock::now() - start).count(), i + 1);
+                }
+            }
+        }
+        else{
+            Simulator simulator(o.strategies, o.seed);
+            std::size_t every = o.every > 0 ? o.every : std::max<std::size_t>(o.games / 10, 1);
+            std::vector<GameResult> results;
+            Clock::time_point start = Clock::now();
+            while(simulator.played() < o.games){
+                results.clear();
+                simulator.run(std::min<std::size_t>(every, o.games - simulator.played()), o.players, o.threads, results);
+                for(const GameResult& r : results){
+                    engine.add(r);
+                }
+                engine.flush();
+                print_row(engine, last, std::chrono::duration<double>(Clock::now() - start).count(), simulator.played());
+            }
+            print_table("strategies (mu +- 2 sigma)", engine.strategies(), o.strategies);
+        }
+        print_table("roles (mu +- 2 sigma)", engine.roles(), roles);
+    } catch (const std::exception& e) {
+        std::cerr << "coup_rate: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
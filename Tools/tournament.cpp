@@ -0,0 +1,128 @@
+#include "../Engine/Tournament.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+struct Options{
+    std::vector<std::string> strategies{"random", "greedy", "mcts", "cfr"};
+    int players = 2;
+    std::size_t rounds = 1;
+    unsigned threads = std::thread::hardware_concurrency();
+    std::uint64_t seed = 1;
+};
+
+void usage(){
+    std::cout << "coup_tournament [--strategies random,greedy,mcts,cfr] [--players P] [--rounds R]\n"
+                 "                [--threads T] [--seed X]\n"
+                 "Plays a round-robin between the strategies: every pair, at P-seat tables, in\n"
+                 "every seating and every dealing of the six roles, R times over, on T threads.\n"
+                 "Prints win rates with 95% confidence intervals: each strategy against each\n"
+                 "other, by role held, and by seat. Strategies: random, greedy, passive, mcts, mcts:N\n"
+                 "(N iterations a move), cfr (the built-in table) or cfr:PATH." << std::endl;
+}
+
+std::vector<std::string> split(const std::string& list){
+    std::vector<std::string> names;
+    std::stringstream in(list);
+    std::string name;
+    while(std::getline(in, name, ',')){
+        if(!name.empty()){
+            names.push_back(name);
+        }
+    }
+    return names;
+}
+
+Options parse(int argc, char* argv[]){
+    Options o;
+    for(int i = 1; i < argc; ++i){
+        std::string arg = argv[i];
+        if(arg == "--help" || i + 1 >= argc){
+            usage();
+            std::exit(arg == "--help" ? 0 : 1);
+        }
+        std::string v = argv[++i];
+        if(arg == "--strategies") o.strategies = split(v);
+        else if(arg == "--players") o.players = std::stoi(v);
+        else if(arg == "--rounds") o.rounds = std::stoull(v);
+        else if(arg == "--threads") o.threads = static_cast<unsigned>(std::stoul(v));
+        else if(arg == "--seed") o.seed = std::stoull(v);
+        else{
+            usage();
+            std::exit(1);
+        }
+    }
+    return o;
+}
+
+// "57.3 +- 1.2", the rate and the half-width of its interval in percent
+std::string cell(const Tally& t){
+    char text[32];
+    std::snprintf(text, sizeof(text), "%5.1f +-%4.1f", 100 * t.rate(), 50 * (t.high() - t.low()));
+    return text;
+}
+
+/**
+ * @brief One row per strategy, one column per label; Tallies at [row * columns + column].
+ */
+void print_matrix(const std::string& title, const std::vector<std::string>& rows, const std::vector<std::string>& columns,
+                  const std::vector<Tally>& tallies, bool skip_diagonal){
+    std::printf("%s\n%-12s", title.c_str(), "");
+    for(const std::string& c : columns){
+        std::printf(" %13.13s", c.c_str());
+    }
+    std::printf("\n");
+    for(std::size_t r = 0; r < rows.size(); ++r){
+        std::printf("%-12.12s", rows[r].c_str());
+        for(std::size_t c = 0; c < columns.size(); ++c){
+            const Tally& t = tallies[r * columns.size() + c];
+            std::printf(" %13s", (skip_diagonal && r == c) || t.games == 0 ? "-" : cell(t).c_str());
+        }
+        std::printf("\n");
+    }
+}
+}
+
+/**
+ * coup_tournament: round-robin win-rate matrices for bot strategies.
+ */
+int main(int argc, char* argv[]){
+    Options o = parse(argc, argv);
+    try {
+        Tournament tournament(o.strategies, o.players, o.rounds, o.seed);
+        std::cout << tournament.games() << " games on " << o.threads << " threads" << std::endl;
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        TournamentResult result = tournament.run(o.threads);
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        std::printf("%llu games in %.2f s (%.0f games/s), %llu hit the turn cap\n\n",
+                    static_cast<unsigned long long>(result.games), seconds, result.games / seconds,
+                    static_cast<unsigned long long>(result.unfinished));
+
+        print_matrix("win rate % (row against column)", o.strategies, o.strategies, result.versus, true);
+        std::vector<std::string> roles;
+        for(int r = 0; r < ROLE_COUNT; ++r){
+            roles.push_back(role_name(static_cast<Role>(r)));
+        }
+        std::printf("\n");
+        print_matrix("win rate % per seat by role held (even: " + std::to_string(100.0 / o.players).substr(0, 4) + ")",
+                     o.strategies, roles, result.roles, false);
+        std::vector<std::string> seats;
+        for(int s = 0; s < o.players; ++s){
+            seats.push_back("seat " + std::to_string(s + 1));
+        }
+        std::printf("\n");
+        print_matrix("win rate % per seat by position", o.strategies, seats, result.seats, false);
+    } catch (const std::exception& e) {
+        std::cerr << "coup_tournament: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
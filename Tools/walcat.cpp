@@ -0,0 +1,138 @@
+#include "../Server/Wal.hpp"
+#include "../Engine/EventLog.hpp"
+#include <cstdlib>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+namespace {
+
+const char* action_name(GameAction a){
+    switch(a){
+        case GameAction::GATHER: return "gather";
+        case GameAction::TAX: return "tax";
+        case GameAction::BRIBE: return "bribe";
+        case GameAction::ARREST: return "arrest";
+        case GameAction::SANCTION: return "sanction";
+        case GameAction::COUP: return "coup";
+        case GameAction::UNIQE: return "ability";
+        default: return "none";
+    }
+}
+const char* kind_name(EventKind k){
+    switch(k){
+        case EventKind::MOVE: return "move";
+        case EventKind::BLOCK: return "block";
+        case EventKind::ALLOW: return "allow";
+        default: return "snapshot";
+    }
+}
+
+void usage(){
+    std::cout << "coup_wal <log> [--repair] [--events] [--match ID]\n"
+                 "Checks a coup_server write-ahead log and lists what it recovers: every match\n"
+                 "with its last logged version, forfeits, and for finished ones the winner and\n"
+                 "the coup that decided it. --repair cuts a torn tail off the file, --events\n"
+                 "prints each match's decoded moves and answers." << std::endl;
+}
+
+void print_match(const WalMatch& m, bool events){
+    std::cout << "match " << m.match << "  v" << m.version;
+    Event e;
+    std::size_t count = 0;
+    Event last_coup{EventKind::MOVE, GameAction::NONE, -1};
+    std::string detail;
+    LogHeader header;
+    if(!m.log.empty()){
+        try {
+            EventReader reader(m.log.data(), m.log.size());
+            header = reader.read_header();
+            while(reader.next(e)){
+                count++;
+                if(e.kind == EventKind::MOVE && e.action == GameAction::COUP){
+                    last_coup = e;
+                }
+                if(events){
+                    detail += "\n    " + std::string(kind_name(e.kind)) + " " + action_name(e.action) +
+                             " seat " + std::to_string(e.seat) + (e.target >= 0 ? " -> " + std::to_string(e.target) : "");
+                }
+            }
+        } catch (const std::runtime_error& ex) {
+            detail += std::string("\n    log unreadable: ") + ex.what();
+        }
+    }
+    std::cout << "  " << header.names.size() << " seats  " << count << " events";
+    if(m.finished){
+        std::cout << "  finished, winner seat " << m.winner << " (" << m.winner_name << ")";
+        if(last_coup.seat >= 0){
+            std::cout << ", last coup seat " << last_coup.seat << " -> " << last_coup.target;
+        }
+    }
+    else{
+        std::cout << "  unfinished";
+    }
+    for(int seat : m.forfeits){
+        std::cout << "  forfeit " << seat;
+    }
+    std::cout << detail << std::endl;
+}
+}
+
+/**
+ * coup_wal <log> [--repair] [--events] [--match ID]
+ */
+int main(int argc, char* argv[]){
+    if(argc < 2){
+        usage();
+        return 1;
+    }
+    std::string path;
+    bool repair = false;
+    bool events = false;
+    long only = -1;
+    for(int i = 1; i < argc; ++i){
+        std::string arg = argv[i];
+        if(arg == "--help"){
+            usage();
+            return 0;
+        }
+        else if(arg == "--repair"){
+            repair = true;
+        }
+        else if(arg == "--events"){
+            events = true;
+        }
+        else if(arg == "--match" && i + 1 < argc){
+            only = std::atol(argv[++i]);
+        }
+        else{
+            path = arg;
+        }
+    }
+    try {
+        WalScan scan = Wal::scan(path);
+        std::cout << path << ": " << scan.records.size() << " records, " << scan.valid_bytes << " of "
+                  << scan.file_bytes << " bytes intact" << std::endl;
+        if(scan.valid_bytes != scan.file_bytes){
+            std::cout << "torn tail of " << scan.file_bytes - scan.valid_bytes << " bytes (never committed)";
+            if(repair){
+                Wal::repair(path);
+                std::cout << ", cut off";
+            }
+            std::cout << std::endl;
+        }
+        std::size_t finished = 0;
+        std::vector<WalMatch> matches = Wal::recover(scan);
+        for(const WalMatch& m : matches){
+            finished += m.finished ? 1 : 0;
+            if(only < 0 || static_cast<long>(m.match) == only){
+                print_match(m, events);
+            }
+        }
+        std::cout << matches.size() << " matches, " << finished << " finished" << std::endl;
+    } catch (const std::exception& e) {
+        std::cerr << "coup_wal: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}